@@ -21,10 +21,19 @@ along with this program. If not, see <http://www.gnu.org/licenses/>.
 
 #include "context.hpp"
 
+#include <algorithm>
+
 #include "widget/widget.hpp"
 
 using namespace ruis;
 
+namespace {
+constexpr uint32_t texture_atlas_max_page_size = 1024;
+
+// bigger images gain nothing from sharing the texture, they are rendered with textures of their own
+constexpr uint32_t texture_atlas_max_image_size = 256;
+} // namespace
+
 context::context(
 	utki::shared_ref<ruis::render::renderer> r,
 	utki::shared_ref<ruis::updater> u,
@@ -39,7 +48,11 @@ context::context(
 	cursor_manager(std::move(set_mouse_cursor_function)),
 	loader(*this),
 	inflater(*this),
-	units(dots_per_inch, dots_per_pp)
+	units(dots_per_inch, dots_per_pp),
+	texture_atlas(
+		std::min(texture_atlas_max_page_size, uint32_t(this->renderer.get().max_texture_size)),
+		texture_atlas_max_image_size
+	)
 {
 	if (!this->post_to_ui_thread) {
 		throw std::invalid_argument("context::context(): no post to UI thread function provided");
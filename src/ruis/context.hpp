@@ -21,12 +21,17 @@ along with this program. If not, see <http://www.gnu.org/licenses/>.
 
 #pragma once
 
+#include <vector>
+
 #include "render/renderer.hpp"
+#include "res/texture_atlas.hpp"
 #include "util/events.hpp"
 #include "util/localization.hpp"
 #include "util/mouse_cursor.hpp"
 #include "util/mouse_cursor_manager.hpp"
+#include "util/raster_cache.hpp"
 #include "util/units.hpp"
+#include "util/worker_pool.hpp"
 
 #include "inflater.hpp"
 #include "layout_factory.hpp"
@@ -44,6 +49,27 @@ class context : public std::enable_shared_from_this<context>
 
 	void set_focused_widget(const std::shared_ptr<widget>& w);
 
+	// areas which need to be re-rendered, in normalized device coordinates
+	std::vector<r4::rectangle<float>> damage;
+	bool damaged_all = true;
+
+	void add_damage(const r4::rectangle<float>& r)
+	{
+		if (this->damaged_all) {
+			return;
+		}
+		this->damage.push_back(r);
+	}
+
+	void add_damage_all() noexcept
+	{
+		this->damaged_all = true;
+		this->damage.clear();
+	}
+
+	// incremented each time appearance of resources shared by widgets changes, see invalidate_appearance()
+	unsigned appearance_generation = 0;
+
 public:
 	const utki::shared_ref<ruis::render::renderer> renderer;
 
@@ -83,6 +109,46 @@ public:
 	 */
 	ruis::units units;
 
+	/**
+	 * @brief Texture atlas for small bitmaps of image resources.
+	 * Image resources pack their small bitmaps to this atlas, so that many small images
+	 * can be rendered from the same texture. The atlas is only to be used from UI thread.
+	 */
+	res::texture_atlas texture_atlas;
+
+	/**
+	 * @brief Rasterize SVG images in background.
+	 * If enabled, SVG image resources are rasterized to newly requested dimensions on worker threads.
+	 * Until the rasterization is finished, the image is rendered from its nearest already rasterized size,
+	 * or not rendered at all if there is no such.
+	 */
+	bool async_rasterization = false;
+
+	/**
+	 * @brief Persistent cache of rasterized bitmaps.
+	 * If set, SVG images and font glyphs rasterized once are stored to the cache and
+	 * are taken from it instead of rasterizing them again, also across application runs.
+	 * Set to nullptr to disable the cache. Disabled by default.
+	 */
+	std::shared_ptr<const ruis::raster_cache> raster_cache;
+
+	/**
+	 * @brief Worker threads for running background tasks.
+	 */
+	worker_pool workers;
+
+	/**
+	 * @brief Notify that appearance of resources used by widgets has changed.
+	 * Drops render caches of all widgets and requests re-rendering of the whole GUI.
+	 * Resources which change their appearance asynchronously, like SVG images rasterized in background,
+	 * call this function from UI thread once the change is done.
+	 */
+	void invalidate_appearance() noexcept
+	{
+		++this->appearance_generation;
+		this->add_damage_all();
+	}
+
 	constexpr static const auto default_dots_per_inch = 96;
 	constexpr static const auto default_dots_per_pp = 1;
 
@@ -0,0 +1,56 @@
+/*
+ruis - GUI framework
+
+Copyright (C) 2012-2024  Ivan Gagis <igagis@gmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* ================ LICENSE END ================ */
+
+#include "font.hpp"
+
+using namespace ruis;
+
+namespace {
+class string_glyph_run : public font::glyph_run
+{
+	const font& owner;
+	const std::u32string str;
+	const unsigned tab_size;
+	const size_t offset;
+
+public:
+	string_glyph_run(const font& owner, std::u32string str, unsigned tab_size, size_t offset) :
+		owner(owner),
+		str(std::move(str)),
+		tab_size(tab_size),
+		offset(offset)
+	{}
+
+	font::render_result render(const ruis::matrix4& matrix, r4::vector4<float> color) const override
+	{
+		return this->owner.render(matrix, color, this->str, this->tab_size, this->offset);
+	}
+};
+} // namespace
+
+std::unique_ptr<const font::glyph_run> font::make_glyph_run_internal(
+	std::u32string str,
+	unsigned tab_size,
+	size_t offset
+) const
+{
+	return std::make_unique<string_glyph_run>(*this, std::move(str), tab_size, offset);
+}
@@ -21,6 +21,7 @@ along with this program. If not, see <http://www.gnu.org/licenses/>.
 
 #pragma once
 
+#include <memory>
 #include <string>
 
 #include <r4/matrix.hpp>
@@ -79,7 +80,51 @@ public:
 		size_t length;
 	};
 
+	/**
+	 * @brief Glyph run.
+	 * A string of text with glyphs looked up and positioned once,
+	 * so that it can be rendered many times without doing that work again.
+	 * The glyph run must not outlive the font it was created by.
+	 */
+	class glyph_run
+	{
+	protected:
+		glyph_run() = default;
+
+	public:
+		glyph_run(const glyph_run&) = delete;
+		glyph_run& operator=(const glyph_run&) = delete;
+
+		glyph_run(glyph_run&&) = delete;
+		glyph_run& operator=(glyph_run&&) = delete;
+
+		virtual ~glyph_run() = default;
+
+		/**
+		 * @brief Render the glyph run.
+		 * @param matrix - transformation matrix to use when rendering.
+		 * @param color - text color.
+		 * @return Render result.
+		 */
+		virtual render_result render(const ruis::matrix4& matrix, r4::vector4<float> color) const = 0;
+	};
+
 protected:
+	/**
+	 * @brief Create glyph run.
+	 * Default implementation creates a glyph run which just keeps the string
+	 * and renders it with render_internal() each time.
+	 * @param str - string of text to create the glyph run for.
+	 * @param tab_size - tab size in characters.
+	 * @param offset - sub-string offset, see render_internal().
+	 * @return Glyph run.
+	 */
+	virtual std::unique_ptr<const glyph_run> make_glyph_run_internal(
+		std::u32string str,
+		unsigned tab_size,
+		size_t offset
+	) const;
+
 	/**
 	 * @brief Render string of text.
 	 * @param matrix - transformation matrix to use when rendering the text.
@@ -208,6 +253,23 @@ public:
 		return this->render(matrix, color, str.c_str(), tab_size, offset);
 	}
 
+	/**
+	 * @brief Create glyph run.
+	 * @param str - string of text to create the glyph run for.
+	 * @param tab_size - tab size in characters. For non-monospace fonts this is the number of space-character advances.
+	 * @param offset - in case the string is a sub-string of a bigger string, this is a sub-string offset from
+	 * the string start. See render() for details.
+	 * @return Glyph run.
+	 */
+	std::unique_ptr<const glyph_run> make_glyph_run(
+		std::u32string str,
+		unsigned tab_size = 4,
+		size_t offset = std::numeric_limits<size_t>::max()
+	) const
+	{
+		return this->make_glyph_run_internal(std::move(str), tab_size, offset);
+	}
+
 	/**
 	 * @brief Get string advance.
 	 * @param str - string to get advance for.
@@ -0,0 +1,215 @@
+/*
+ruis - GUI framework
+
+Copyright (C) 2012-2024  Ivan Gagis <igagis@gmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* ================ LICENSE END ================ */
+
+#include "glyph_atlas.hxx"
+
+#include <algorithm>
+
+#include <utki/debug.hpp>
+
+using namespace ruis;
+
+namespace {
+constexpr uint32_t initial_atlas_size = 256;
+
+// gap between glyphs to avoid sampling neighbour glyphs
+constexpr uint32_t glyph_padding = 1;
+
+rasterimage::image_variant make_atlas_image(r4::vector2<uint32_t> dims)
+{
+	rasterimage::image_variant ret(
+		dims, //
+		rasterimage::format::grey,
+		rasterimage::depth::uint_8_bit
+	);
+
+	auto& im = ret.get<rasterimage::format::grey, rasterimage::depth::uint_8_bit>();
+	using pixel_type = std::remove_reference_t<decltype(im)>::pixel_type;
+	for (uint32_t y = 0; y != im.dims().y(); ++y) {
+		auto line = im[y];
+		std::fill(line.begin(), line.end(), pixel_type{});
+	}
+
+	return ret;
+}
+
+void blit(
+	rasterimage::image<uint8_t, 1>& dst, //
+	r4::vector2<uint32_t> pos,
+	const rasterimage::image<uint8_t, 1>& src
+)
+{
+	ASSERT(pos.x() + src.dims().x() <= dst.dims().x())
+	ASSERT(pos.y() + src.dims().y() <= dst.dims().y())
+
+	for (uint32_t y = 0; y != src.dims().y(); ++y) {
+		auto src_line = src[y];
+		std::copy(src_line.begin(), src_line.end(), utki::next(dst[pos.y() + y].begin(), pos.x()));
+	}
+}
+} // namespace
+
+glyph_atlas::glyph_atlas(uint32_t max_size) :
+	max_size(max_size),
+	image(make_atlas_image(r4::vector2<uint32_t>(std::min(initial_atlas_size, max_size))))
+{}
+
+bool glyph_atlas::grow()
+{
+	auto dims = this->dims();
+
+	// grow height first, so that existing shelves stay as they are,
+	// when height cannot grow anymore, grow width to give more room to existing shelves
+	if (dims.y() < this->max_size) {
+		dims.y() = std::min(dims.y() * 2, this->max_size);
+	} else if (dims.x() < this->max_size) {
+		dims.x() = std::min(dims.x() * 2, this->max_size);
+	} else {
+		return false;
+	}
+
+	auto new_image = make_atlas_image(dims);
+	blit(
+		new_image.get<rasterimage::format::grey, rasterimage::depth::uint_8_bit>(),
+		{0, 0},
+		this->image.get<rasterimage::format::grey, rasterimage::depth::uint_8_bit>()
+	);
+	this->image = std::move(new_image);
+
+	// texture of different dimensions is needed
+	this->tex.reset();
+
+	return true;
+}
+
+glyph_atlas::shelf* glyph_atlas::find_shelf(r4::vector2<uint32_t> dims)
+{
+	auto atlas_dims = this->dims();
+
+	// find best fitting shelf, i.e. the lowest one which is high enough
+	shelf* best = nullptr;
+	for (auto& s : this->shelves) {
+		if (s.height < dims.y() || s.width_used + dims.x() > atlas_dims.x()) {
+			continue;
+		}
+		if (!best || s.height < best->height) {
+			best = &s;
+		}
+	}
+
+	// do not waste too much space of a high shelf on a low glyph, open new shelf instead if possible
+	if (best && best->height <= dims.y() * 2) {
+		return best;
+	}
+
+	uint32_t new_shelf_y = this->shelves.empty() ? 0 : this->shelves.back().y + this->shelves.back().height;
+	if (new_shelf_y + dims.y() <= atlas_dims.y() && dims.x() <= atlas_dims.x()) {
+		this->shelves.push_back({.y = new_shelf_y, .height = dims.y(), .width_used = 0});
+		return &this->shelves.back();
+	}
+
+	return best;
+}
+
+std::optional<r4::rectangle<uint32_t>> glyph_atlas::add(const rasterimage::image<uint8_t, 1>& im)
+{
+	auto dims = im.dims() + r4::vector2<uint32_t>(glyph_padding);
+
+	if (dims.x() > this->max_size || dims.y() > this->max_size) {
+		return std::nullopt;
+	}
+
+	shelf* s = this->find_shelf(dims);
+	while (!s) {
+		if (!this->grow()) {
+			return std::nullopt;
+		}
+		s = this->find_shelf(dims);
+	}
+
+	r4::vector2<uint32_t> pos = {s->width_used, s->y};
+	s->width_used += dims.x();
+
+	blit(this->image.get<rasterimage::format::grey, rasterimage::depth::uint_8_bit>(), pos, im);
+
+	if (this->dirty_rows_begin == this->dirty_rows_end) {
+		this->dirty_rows_begin = pos.y();
+		this->dirty_rows_end = pos.y() + im.dims().y();
+	} else {
+		this->dirty_rows_begin = std::min(this->dirty_rows_begin, pos.y());
+		this->dirty_rows_end = std::max(this->dirty_rows_end, pos.y() + im.dims().y());
+	}
+
+	return r4::rectangle<uint32_t>(pos, im.dims());
+}
+
+void glyph_atlas::clear()
+{
+	this->shelves.clear();
+	this->image = make_atlas_image(this->dims());
+	++this->cur_generation;
+
+	// New glyphs take areas of the old ones, so the old texture cannot be updated in place:
+	// glyph runs recorded to a deferred draw list before clearing still sample it.
+	this->tex.reset();
+	this->dirty_rows_begin = 0;
+	this->dirty_rows_end = 0;
+}
+
+utki::shared_ref<const render::texture_2d> glyph_atlas::get_texture(render::factory& f)
+{
+	auto& im = this->image.get<rasterimage::format::grey, rasterimage::depth::uint_8_bit>();
+
+	if (this->tex && this->dirty_rows_begin != this->dirty_rows_end) {
+		ASSERT(this->dirty_rows_end <= im.dims().y())
+
+		rasterimage::image_variant rows(
+			{im.dims().x(), this->dirty_rows_end - this->dirty_rows_begin},
+			rasterimage::format::grey,
+			rasterimage::depth::uint_8_bit
+		);
+		auto& rows_im = rows.get<rasterimage::format::grey, rasterimage::depth::uint_8_bit>();
+		for (uint32_t y = 0; y != rows_im.dims().y(); ++y) {
+			auto src_line = im[this->dirty_rows_begin + y];
+			std::copy(src_line.begin(), src_line.end(), rows_im[y].begin());
+		}
+
+		if (!this->tex->update({0, this->dirty_rows_begin}, rows)) {
+			// the renderer backend does not support partial texture updates
+			this->tex.reset();
+		}
+	}
+
+	this->dirty_rows_begin = 0;
+	this->dirty_rows_end = 0;
+
+	if (!this->tex) {
+		auto t = f.create_texture_2d(
+			this->image,
+			{.min_filter = render::texture_2d::filter::nearest,
+			 .mag_filter = render::texture_2d::filter::nearest,
+			 .mipmap = render::texture_2d::mipmap::none}
+		);
+		this->tex = t.to_shared_ptr();
+	}
+
+	return utki::shared_ref<const render::texture_2d>(this->tex);
+}
@@ -0,0 +1,121 @@
+/*
+ruis - GUI framework
+
+Copyright (C) 2012-2024  Ivan Gagis <igagis@gmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* ================ LICENSE END ================ */
+
+#pragma once
+
+#include <optional>
+#include <vector>
+
+#include <rasterimage/image_variant.hpp>
+#include <r4/rectangle.hpp>
+#include <utki/shared_ref.hpp>
+
+#include "../render/factory.hpp"
+#include "../render/texture_2d.hpp"
+
+namespace ruis {
+
+/**
+ * @brief Growable texture atlas for glyph bitmaps.
+ * Glyph bitmaps are packed into shelves: rows of glyphs of similar height.
+ * When there is no room left, the atlas grows by doubling its dimensions,
+ * already packed glyphs keep their positions. The atlas cannot grow beyond the given maximum size.
+ * The texture is uploaded lazily, only when it is requested after new glyphs were added.
+ * Only the rows of the atlas where glyphs were added are uploaded, unless the renderer backend does not support
+ * partial texture updates or the atlas has grown or was cleared, in which case the texture is created again.
+ */
+class glyph_atlas
+{
+	const uint32_t max_size;
+
+	rasterimage::image_variant image;
+
+	struct shelf {
+		uint32_t y;
+		uint32_t height;
+		uint32_t width_used;
+	};
+
+	std::vector<shelf> shelves;
+
+	std::shared_ptr<render::texture_2d> tex;
+
+	// rows of the atlas image changed since the texture was uploaded, [begin, end)
+	uint32_t dirty_rows_begin = 0;
+	uint32_t dirty_rows_end = 0;
+
+	unsigned cur_generation = 0;
+
+	bool grow();
+
+	shelf* find_shelf(r4::vector2<uint32_t> dims);
+
+public:
+	/**
+	 * @param max_size - maximum width and height of the atlas texture.
+	 */
+	glyph_atlas(uint32_t max_size);
+
+	/**
+	 * @brief Get atlas dimensions.
+	 * @return Atlas dimensions in pixels.
+	 */
+	r4::vector2<uint32_t> dims() const noexcept
+	{
+		return this->image.dims();
+	}
+
+	/**
+	 * @brief Get generation of the atlas.
+	 * The generation is incremented each time the atlas is cleared.
+	 * All the rectangles returned by add() before that become invalid.
+	 * @return Current generation of the atlas.
+	 */
+	unsigned generation() const noexcept
+	{
+		return this->cur_generation;
+	}
+
+	/**
+	 * @brief Add glyph bitmap to the atlas.
+	 * @param im - glyph bitmap.
+	 * @return Rectangle occupied by the glyph bitmap within the atlas, in pixels.
+	 * @return std::nullopt if the atlas is full and cannot grow anymore.
+	 */
+	std::optional<r4::rectangle<uint32_t>> add(const rasterimage::image<uint8_t, 1>& im);
+
+	/**
+	 * @brief Remove all glyphs from the atlas.
+	 * Increments the atlas generation. The next get_texture() call returns a new texture,
+	 * the previously returned texture keeps the old glyphs.
+	 */
+	void clear();
+
+	/**
+	 * @brief Get atlas texture.
+	 * Uploads the rows of the atlas where glyphs were added since last upload.
+	 * @param f - factory to create the texture with.
+	 * @return Atlas texture.
+	 */
+	utki::shared_ref<const render::texture_2d> get_texture(render::factory& f);
+};
+
+} // namespace ruis
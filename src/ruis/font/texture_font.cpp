@@ -22,10 +22,15 @@ along with this program. If not, see <http://www.gnu.org/licenses/>.
 #include "texture_font.hxx"
 
 #include <algorithm>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <vector>
 
 #include <utki/debug.hpp>
 
 #include "../context.hpp"
+#include "../util/raster_cache.hpp"
 #include "../util/util.hpp"
 
 using namespace ruis;
@@ -34,6 +39,23 @@ namespace {
 constexpr const char32_t unknown_char = 0xfffd;
 
 constexpr const auto freetype_granularity = 64;
+
+// returns false if the glyph could not be loaded
+bool load_char(FT_Face face, char32_t c, FT_Int32 load_flags)
+{
+	if (FT_Load_Char(face, FT_ULong(c), load_flags) != 0) {
+		if (c == unknown_char) {
+			throw std::runtime_error(
+				"texture_font::load_glyph(): could not load 'unknown character' glyph (UTF-32: 0xfffd)"
+			);
+		}
+		LOG([&](auto& o) {
+			o << "texture_font::load_glyph(" << std::hex << uint32_t(c) << "): failed to load glyph" << std::endl;
+		})
+		return false;
+	}
+	return true;
+}
 } // namespace
 
 freetype_face::freetype_lib_wrapper::freetype_lib_wrapper()
@@ -48,27 +70,144 @@ freetype_face::freetype_lib_wrapper::~freetype_lib_wrapper()
 	FT_Done_FreeType(this->lib);
 }
 
-freetype_face::freetype_face_wrapper::freetype_face_wrapper(FT_Library& lib, const papki::file& fi)
+std::shared_ptr<freetype_face::freetype_lib_wrapper> freetype_face::freetype_lib_wrapper::get_shared()
 {
-	this->font_file = fi.load();
-	ASSERT(!this->font_file.empty())
-	if (FT_New_Memory_Face(lib, this->font_file.data(), int(this->font_file.size()), 0 /* face_index */, &this->f) != 0)
-	{
+	static std::mutex mutex;
+	static std::weak_ptr<freetype_lib_wrapper> shared_lib;
+
+	std::lock_guard lock(mutex);
+
+	auto ret = shared_lib.lock();
+	if (!ret) {
+		ret = std::make_shared<freetype_lib_wrapper>();
+		shared_lib = ret;
+	}
+	return ret;
+}
+
+freetype_face::freetype_face_wrapper::freetype_face_wrapper(
+	freetype_lib_wrapper& lib,
+	utki::shared_ref<const mapped_file> font_file
+) :
+	lib(lib),
+	font_file(std::move(font_file))
+{
+	auto data = this->font_file.get().data();
+	ASSERT(!data.empty())
+
+	std::lock_guard lock(this->lib.mutex);
+	if (FT_New_Memory_Face(this->lib.lib, data.data(), FT_Long(data.size()), 0 /* face_index */, &this->f) != 0) {
 		throw std::runtime_error("freetype_face_wrapper::freetype_face_wrapper(): unable to crate font face object");
 	}
 }
 
 freetype_face::freetype_face_wrapper::~freetype_face_wrapper() noexcept
 {
+	std::lock_guard lock(this->lib.mutex);
 	FT_Done_Face(this->f);
 }
 
 freetype_face::freetype_face(const papki::file& fi) :
-	face(freetype.lib, fi)
+	freetype_face(mapped_file::load(fi))
+{}
+
+freetype_face::freetype_face(utki::shared_ref<const mapped_file> font_file) :
+	freetype(freetype_lib_wrapper::get_shared()),
+	face(*this->freetype, std::move(font_file))
 {}
 
+namespace {
+std::mutex faces_mutex;
+
+template <typename key_type, typename make_face_type>
+utki::shared_ref<const freetype_face> get_cached_face(
+	std::map<key_type, std::weak_ptr<const freetype_face>>& faces,
+	key_type key,
+	const make_face_type& make_face
+)
+{
+	std::lock_guard lock(faces_mutex);
+
+	if (auto i = faces.find(key); i != faces.end()) {
+		if (auto f = i->second.lock()) {
+			return utki::shared_ref<const freetype_face>(std::move(f));
+		}
+	}
+
+	// remove entries of faces which are not used anymore
+	for (auto i = faces.begin(); i != faces.end();) {
+		if (i->second.expired()) {
+			i = faces.erase(i);
+		} else {
+			++i;
+		}
+	}
+
+	utki::shared_ref<const freetype_face> ret = make_face();
+	faces[std::move(key)] = ret.to_shared_ptr();
+	return ret;
+}
+} // namespace
+
+utki::shared_ref<const freetype_face> freetype_face::load(const papki::file& fi)
+{
+	// Files on the local file system are memory mapped and the mappings are shared by file identity,
+	// so the faces are cached by the mapping. Other files, e.g. files from zip archives, cannot be told apart
+	// by path, so each load creates a new face.
+	return load(mapped_file::load(fi));
+}
+
+utki::shared_ref<const freetype_face> freetype_face::load(const utki::shared_ref<const mapped_file>& font_file)
+{
+	static std::map<const mapped_file*, std::weak_ptr<const freetype_face>> faces;
+
+	// the face holds a reference to the file contents, so the key pointer is valid as long as the face is alive
+	return get_cached_face(faces, &font_file.get(), [&]() {
+		return utki::make_shared<freetype_face>(font_file);
+	});
+}
+
+uint64_t freetype_face::get_content_hash() const
+{
+	std::lock_guard lock(this->mutex);
+
+	if (!this->content_hash.has_value()) {
+		// Hashing the whole font file is too slow to be done on the UI thread.
+		// TrueType and OpenType font files start with the table directory holding checksums of all the font tables,
+		// so the file header along with the file size identifies the font contents.
+		constexpr size_t max_header_size = 4096;
+
+		auto data = this->face.font_file.get().data();
+		auto size = uint64_t(data.size());
+
+		this->content_hash = raster_cache::hash(
+			data.subspan(0, std::min(data.size(), max_header_size)),
+			raster_cache::hash(utki::make_span(reinterpret_cast<const uint8_t*>(&size), sizeof(size)))
+		);
+	}
+	return this->content_hash.value();
+}
+
 void freetype_face::set_size(unsigned font_size) const
 {
+	if (auto i = this->sizes.find(font_size); i != this->sizes.end()) {
+		if (this->face.f->size != i->second) {
+			FT_Activate_Size(i->second);
+		}
+		return;
+	}
+
+	FT_Size size = nullptr;
+	if (FT_New_Size(this->face.f, &size) != 0) {
+		throw std::runtime_error("freetype_face::set_size(): unable to create size object");
+	}
+
+	// the size object is owned by the face, FT_Done_Face() destroys it
+	if (FT_Activate_Size(size) != 0) {
+		FT_Done_Size(size);
+		throw std::runtime_error("freetype_face::set_size(): unable to activate size object");
+	}
+
 	FT_Error error = FT_Set_Pixel_Sizes(
 		this->face.f,
 		0, // pixel_width (0 means "same as height")
@@ -76,12 +215,17 @@ void freetype_face::set_size(unsigned font_size) const
 	);
 
 	if (error != 0) {
+		FT_Done_Size(size);
 		throw std::runtime_error("texture_font::texture_font(): unable to set char size");
 	}
+
+	this->sizes.insert(std::make_pair(font_size, size));
 }
 
 freetype_face::metrics freetype_face::get_metrics(unsigned font_size) const
 {
+	std::lock_guard lock(this->mutex);
+
 	this->set_size(font_size);
 	using std::ceil;
 	return {
@@ -93,18 +237,12 @@ freetype_face::metrics freetype_face::get_metrics(unsigned font_size) const
 
 freetype_face::glyph freetype_face::load_glyph(char32_t c, unsigned font_size) const
 {
+	std::lock_guard lock(this->mutex);
+
 	// set character size in pixels
 	this->set_size(font_size);
 
-	if (FT_Load_Char(this->face.f, FT_ULong(c), FT_LOAD_RENDER) != 0) {
-		if (c == unknown_char) {
-			throw std::runtime_error(
-				"texture_font::load_glyph(): could not load 'unknown character' glyph (UTF-32: 0xfffd)"
-			);
-		}
-		LOG([&](auto& o) {
-			o << "texture_font::load_glyph(" << std::hex << uint32_t(c) << "): failed to load glyph" << std::endl;
-		})
+	if (!load_char(this->face.f, c, FT_LOAD_RENDER)) {
 		return {
 			{}, // vertices
 			{}, // image
@@ -152,50 +290,137 @@ freetype_face::glyph freetype_face::load_glyph(char32_t c, unsigned font_size) c
 	};
 }
 
+std::optional<freetype_face::glyph_metrics> freetype_face::load_glyph_metrics(char32_t c, unsigned font_size) const
+{
+	std::lock_guard lock(this->mutex);
+
+	this->set_size(font_size);
+
+	// without FT_LOAD_RENDER the glyph outline is only loaded and scaled, the bitmap is not rendered
+	if (!load_char(this->face.f, c, FT_LOAD_DEFAULT)) {
+		return std::nullopt;
+	}
+
+	const FT_Glyph_Metrics& m = this->face.f->glyph->metrics;
+
+	glyph_metrics ret;
+	ret.advance = real(m.horiAdvance) / real(freetype_granularity);
+
+	if (m.width == 0 || m.height == 0) {
+		// empty glyph (space)
+		ret.top_left.set(0);
+		ret.bottom_right.set(0);
+		return ret;
+	}
+
+	ret.top_left = ruis::vector2(real(m.horiBearingX), -real(m.horiBearingY)) / real(freetype_granularity);
+	ret.bottom_right = ruis::vector2(real(m.horiBearingX + m.width), real(m.height - m.horiBearingY)) /
+		real(freetype_granularity);
+
+	return ret;
+}
+
+texture_font::glyph_metrics texture_font::load_glyph_metrics(char32_t c) const
+{
+	auto ftm = this->face.get().load_glyph_metrics(c, this->font_size);
+
+	if (!ftm) {
+		return this->unknown_glyph_metrics;
+	}
+
+	glyph_metrics ret;
+	ret.top_left = ftm->top_left;
+	ret.bottom_right = ftm->bottom_right;
+	ret.advance = ftm->advance;
+	ret.has_bitmap = ret.top_left != ret.bottom_right;
+
+	return ret;
+}
+
+const texture_font::glyph_metrics& texture_font::get_glyph_metrics(char32_t c) const
+{
+	auto i = this->metrics.find(c);
+	if (i != this->metrics.end()) {
+		return i->second;
+	}
+
+	if (this->metrics.size() >= this->max_cached) {
+		this->metrics.clear();
+	}
+
+	auto r = this->metrics.insert(std::make_pair(c, this->load_glyph_metrics(c)));
+	ASSERT(r.second)
+
+	return r.first->second;
+}
+
 texture_font::glyph texture_font::load_glyph(char32_t c) const
 {
-	auto ftg = this->face.get().load_glyph(c, this->font_size);
+	// copy, because the reference is invalidated by subsequent get_glyph_metrics() calls
+	auto m = this->get_glyph_metrics(c);
 
-	if (ftg.advance < 0) {
-		return this->unknown_glyph;
+	if (m.substituted) {
+		// all characters missing in the font share the bitmap of the 'unknown character' glyph
+		return this->get_glyph(unknown_char);
 	}
 
 	glyph g;
-	g.advance = ftg.advance;
+	g.top_left = m.top_left;
+	g.bottom_right = m.bottom_right;
+	g.advance = m.advance;
 
-	if (ftg.image.empty()) {
-		g.top_left.set(0);
-		g.bottom_right.set(0);
-		// empty glyph (space)
+	if (!m.has_bitmap) {
+		// empty glyph (space), nothing to render
 		return g;
 	}
 
-	g.top_left = ftg.vertices[0];
-	g.bottom_right = ftg.vertices[2];
+	auto image = [&]() {
+		const auto* cache = this->context.get().raster_cache.get();
+		if (!cache) {
+			return this->face.get().load_glyph(c, this->font_size).image;
+		}
 
-	auto& r = this->context.get().renderer.get();
-	g.vao = r.factory
-				->create_vertex_array(
-					{r.factory->create_vertex_buffer(utki::make_span(ftg.vertices)),
-					 this->context.get().renderer.get().quad_01_vbo},
-					this->context.get().renderer.get().quad_indices,
-					render::vertex_array::mode::triangle_fan
-				)
-				.to_shared_ptr();
-	g.tex = this->context.get()
-				.renderer.get()
-				.factory
-				->create_texture_2d(
-					std::move(ftg.image),
-					{.min_filter = render::texture_2d::filter::nearest,
-					 .mag_filter = render::texture_2d::filter::nearest,
-					 .mipmap = render::texture_2d::mipmap::none}
-				)
-				.to_shared_ptr();
+		auto key = raster_cache::make_key(this->face.get().get_content_hash(), "glyph", this->font_size, c);
+		if (auto im = cache->get<1>(key)) {
+			return std::move(im.value());
+		}
+
+		auto im = this->face.get().load_glyph(c, this->font_size).image;
+		if (!im.empty()) {
+			cache->put(key, im);
+		}
+		return im;
+	}();
+
+	if (image.empty()) {
+		return g;
+	}
+
+	auto rect = this->atlas.add(image);
+	if (!rect) {
+		// atlas is full
+		this->evict_glyphs();
+
+		rect = this->atlas.add(image);
+		if (!rect) {
+			throw std::runtime_error("texture_font::load_glyph(): glyph bitmap does not fit into empty glyph atlas");
+		}
+	}
+	g.atlas_rect = rect.value();
 
 	return g;
 }
 
+void texture_font::evict_glyphs() const
+{
+	// the quads of the string being built before the eviction are rendered with the texture of evicted glyphs
+	auto& r = this->context.get().renderer.get();
+	this->evicted_texture = this->atlas.get_texture(*r.factory).to_shared_ptr();
+
+	this->glyphs.clear();
+	this->atlas.clear();
+}
+
 texture_font::texture_font(
 	const utki::shared_ref<ruis::context>& c,
 	// NOLINTNEXTLINE(modernize-pass-by-value)
@@ -206,11 +431,13 @@ texture_font::texture_font(
 	font(c),
 	font_size(font_size),
 	face(face),
+	atlas(c.get().renderer.get().max_texture_size),
 	max_cached(max_cached)
 {
 	//	TRACE(<< "texture_font::Load(): enter" << std::endl)
 
-	this->unknown_glyph = this->load_glyph(unknown_char);
+	this->unknown_glyph_metrics = this->load_glyph_metrics(unknown_char);
+	this->unknown_glyph_metrics.substituted = true;
 
 	//	TRACE(<< "texture_font::Load(): entering for loop" << std::endl)
 
@@ -228,53 +455,33 @@ texture_font::texture_font(
 const texture_font::glyph& texture_font::get_glyph(char32_t c) const
 {
 	auto i = this->glyphs.find(c);
-	if (i == this->glyphs.end()) {
-		auto r = this->glyphs.insert(std::make_pair(c, this->load_glyph(c)));
-		ASSERT(r.second)
-		i = r.first;
-		this->last_used_order.push_front(c);
-		i->second.last_used_iter = this->last_used_order.begin();
-
-		if (this->last_used_order.size() == this->max_cached) {
-			this->glyphs.erase(this->last_used_order.back());
-			this->last_used_order.pop_back();
-		}
-		//		TRACE(<< "texture_font::get_glyph(): glyph loaded: " << c << std::endl)
-	} else {
-		glyph& g = i->second;
-		this->last_used_order.splice(this->last_used_order.begin(), this->last_used_order, g.last_used_iter);
+	if (i != this->glyphs.end()) {
+		return i->second;
 	}
 
-	ASSERT(this->last_used_order.size() <= this->max_cached)
-
-	return i->second;
-}
-
-real texture_font::render_glyph_internal(const ruis::matrix4& matrix, r4::vector4<float> color, char32_t ch) const
-{
-	const glyph& g = this->get_glyph(ch);
-
-	// texture can be null for glyph of empty characters, like space, tab etc...
-	if (g.tex) {
-		ASSERT(g.vao)
-		this->context.get().renderer.get().shader->color_pos_tex_alpha->render(matrix, *g.vao, color, *g.tex);
+	if (this->glyphs.size() >= this->max_cached) {
+		this->evict_glyphs();
 	}
 
-	return g.advance;
+	auto r = this->glyphs.insert(std::make_pair(c, this->load_glyph(c)));
+	ASSERT(r.second)
+	//		TRACE(<< "texture_font::get_glyph(): glyph loaded: " << c << std::endl)
+
+	return r.first->second;
 }
 
 real texture_font::get_advance_internal(std::u32string_view str, unsigned tab_size) const
 {
 	real ret = 0;
 
-	real space_advance = this->get_glyph(U' ').advance;
+	real space_advance = this->get_glyph_metrics(U' ').advance;
 
 	for (auto c : str) {
 		try {
 			if (c == U'\t') {
 				ret += space_advance * real(tab_size);
 			} else {
-				const glyph& g = this->get_glyph(c);
+				const glyph_metrics& g = this->get_glyph_metrics(c);
 				ret += g.advance;
 			}
 		} catch (std::out_of_range&) {
@@ -300,19 +507,19 @@ ruis::rect texture_font::get_bounding_box_internal(std::u32string_view str, unsi
 
 	// init with bounding box of the first glyph
 	auto [cur_advance, left, right, top, bottom] = [&]() {
-		const glyph& g = this->get_glyph(*s);
+		const glyph_metrics& g = this->get_glyph_metrics(*s);
 		++s;
 
 		return std::make_tuple(g.advance, g.top_left.x(), g.bottom_right.x(), g.top_left.y(), g.bottom_right.y());
 	}();
 
-	real space_advance = this->get_glyph(U' ').advance;
+	real space_advance = this->get_glyph_metrics(U' ').advance;
 
 	for (; s != str.end(); ++s) {
 		if (*s == U'\t') {
 			cur_advance += space_advance * real(tab_size);
 		} else {
-			const glyph& g = this->get_glyph(*s);
+			const glyph_metrics& g = this->get_glyph_metrics(*s);
 
 			using std::min;
 			using std::max;
@@ -337,67 +544,236 @@ ruis::rect texture_font::get_bounding_box_internal(std::u32string_view str, unsi
 	return ret;
 }
 
-font::render_result texture_font::render_internal(
-	const ruis::matrix4& matrix,
-	r4::vector4<float> color,
-	const std::u32string_view str,
+namespace {
+// texture coordinates of the quads are in pixels while building, converts them to normalized ones
+void normalize_tex_coords(std::vector<render::renderer::quad>& quads, r4::vector2<uint32_t> tex_dims)
+{
+	auto dims = tex_dims.to<float>();
+	for (auto& q : quads) {
+		for (auto& v : q) {
+			v.tex_coord.x() /= dims.x();
+			v.tex_coord.y() /= dims.y();
+		}
+	}
+}
+} // namespace
+
+font::render_result texture_font::build_quads(
+	std::vector<quads_chunk>& chunks,
+	std::u32string_view str,
 	unsigned tab_size,
 	size_t offset
 ) const
 {
 	render_result ret = {0, 0};
 
-	if (str.size() == 0) {
+	chunks.clear();
+
+	if (str.empty()) {
 		return ret;
 	}
 
-	this->context.get().renderer.get().set_simple_alpha_blending();
+	chunks.emplace_back();
+	chunks.back().quads.reserve(str.size());
 
-	ruis::matrix4 matr(matrix);
-
-	real space_advance = this->get_glyph(U' ').advance;
+	real space_advance = this->get_glyph_metrics(U' ').advance;
 
 	size_t cur_offset = offset;
 
 	for (auto c : str) {
 		try {
-			real advance = [&]() {
-				if (c == U'\t') { // if tabulation
-					unsigned actual_tab_size = [&]() -> unsigned {
-						if (offset == std::numeric_limits<size_t>::max()) {
-							return tab_size;
-						} else {
-							return tab_size - cur_offset % tab_size;
-						}
-					}();
-					auto advance = space_advance * real(actual_tab_size);
-					ret.length += actual_tab_size;
-					cur_offset += actual_tab_size;
-					return advance;
-				} else { // all other characters
-					auto advance = this->render_glyph_internal(matr, color, c);
-					++ret.length;
-					++cur_offset;
-					return advance;
+			if (c == U'\t') { // if tabulation
+				unsigned actual_tab_size = [&]() -> unsigned {
+					if (offset == std::numeric_limits<size_t>::max()) {
+						return tab_size;
+					} else {
+						return tab_size - cur_offset % tab_size;
+					}
+				}();
+				ret.advance += space_advance * real(actual_tab_size);
+				ret.length += actual_tab_size;
+				cur_offset += actual_tab_size;
+			} else { // all other characters
+				auto generation = this->atlas.generation();
+
+				const glyph& g = this->get_glyph(c);
+
+				if (generation != this->atlas.generation() && !chunks.back().quads.empty()) {
+					// glyphs were evicted, the quads built so far refer to the texture of the evicted glyphs
+					ASSERT(this->evicted_texture)
+					auto& chunk = chunks.back();
+					chunk.tex = std::move(this->evicted_texture);
+					normalize_tex_coords(chunk.quads, chunk.tex->dims());
+					chunks.emplace_back();
+				}
+				this->evicted_texture.reset();
+
+				// atlas_rect can be empty for glyph of empty characters, like space
+				if (g.atlas_rect.d.is_positive()) {
+					auto tl = g.top_left + ruis::vector2(ret.advance, 0);
+					auto br = g.bottom_right + ruis::vector2(ret.advance, 0);
+
+					// texture coordinates are in pixels for now, they are normalized once all glyphs are loaded,
+					// because the atlas can grow while loading glyphs
+					auto tex_tl = g.atlas_rect.p.to<float>();
+					auto tex_br = g.atlas_rect.x2_y2().to<float>();
+
+					// same vertices order as in renderer::quad_01_vbo
+					chunks.back().quads.push_back({
+						{{tl, tex_tl}, //
+						 {{tl.x(), br.y()}, {tex_tl.x(), tex_br.y()}},
+						 {br, tex_br},
+						 {{br.x(), tl.y()}, {tex_br.x(), tex_tl.y()}}}
+					});
 				}
-			}();
 
-			ret.advance += advance;
-			matr.translate(advance, 0);
+				ret.advance += g.advance;
+				++ret.length;
+				++cur_offset;
+			}
 		} catch (std::out_of_range&) {
-			return ret;
+			break;
+		}
+	}
+
+	normalize_tex_coords(chunks.back().quads, this->atlas.dims());
+
+	return ret;
+}
+
+void texture_font::render_quads(
+	const ruis::matrix4& matrix,
+	r4::vector4<float> color,
+	utki::span<const quads_chunk> chunks
+) const
+{
+	auto& r = this->context.get().renderer.get();
+
+	r.set_simple_alpha_blending();
+
+	for (const auto& chunk : chunks) {
+		if (chunk.quads.empty()) {
+			continue;
 		}
+
+		r.render_alpha_quads(
+			matrix,
+			chunk.quads,
+			color,
+			chunk.tex ? utki::shared_ref<const render::texture_2d>(chunk.tex) : this->atlas.get_texture(*r.factory)
+		);
 	}
+}
+
+font::render_result texture_font::render_internal(
+	const ruis::matrix4& matrix,
+	r4::vector4<float> color,
+	const std::u32string_view str,
+	unsigned tab_size,
+	size_t offset
+) const
+{
+	std::vector<quads_chunk> chunks;
+
+	auto ret = this->build_quads(chunks, str, tab_size, offset);
+
+	this->render_quads(matrix, color, chunks);
 
 	return ret;
 }
 
+class texture_font::texture_glyph_run : public font::glyph_run
+{
+	const texture_font& owner;
+
+	const std::u32string str;
+	const unsigned tab_size;
+	const size_t offset;
+
+	// the quads stay valid as long as the atlas is not cleared and does not change its dimensions
+	mutable unsigned atlas_generation = 0;
+	mutable r4::vector2<uint32_t> atlas_dims;
+
+	mutable std::vector<quads_chunk> chunks;
+	mutable render_result result = {0, 0};
+
+	// the quads of each chunk uploaded to the rendering context, created on first render in immediate rendering mode
+	mutable std::vector<std::shared_ptr<const render::vertex_array>> vaos;
+
+	void rebuild() const
+	{
+		this->result = this->owner.build_quads(this->chunks, this->str, this->tab_size, this->offset);
+		this->atlas_generation = this->owner.atlas.generation();
+		this->atlas_dims = this->owner.atlas.dims();
+		this->vaos.clear();
+	}
+
+public:
+	texture_glyph_run(const texture_font& owner, std::u32string str, unsigned tab_size, size_t offset) :
+		owner(owner),
+		str(std::move(str)),
+		tab_size(tab_size),
+		offset(offset)
+	{
+		this->rebuild();
+	}
+
+	render_result render(const ruis::matrix4& matrix, r4::vector4<float> color) const override
+	{
+		if (this->atlas_generation != this->owner.atlas.generation() || this->atlas_dims != this->owner.atlas.dims()) {
+			this->rebuild();
+		}
+
+		auto& r = this->owner.context.get().renderer.get();
+
+		if (r.is_deferred()) {
+			// record the quads to the draw list, so that they are batched with the quads of other strings
+			this->owner.render_quads(matrix, color, this->chunks);
+			return this->result;
+		}
+
+		this->vaos.resize(this->chunks.size());
+
+		r.set_simple_alpha_blending();
+
+		for (size_t i = 0; i != this->chunks.size(); ++i) {
+			const auto& chunk = this->chunks[i];
+			if (chunk.quads.empty()) {
+				continue;
+			}
+
+			auto& vao = this->vaos[i];
+			if (!vao) {
+				vao = r.make_quads_vertex_array(chunk.quads).to_shared_ptr();
+			}
+
+			r.render_alpha_quads(
+				matrix,
+				*vao,
+				color,
+				chunk.tex ? *chunk.tex : this->owner.atlas.get_texture(*r.factory).get()
+			);
+		}
+
+		return this->result;
+	}
+};
+
+std::unique_ptr<const font::glyph_run> texture_font::make_glyph_run_internal(
+	std::u32string str,
+	unsigned tab_size,
+	size_t offset
+) const
+{
+	return std::make_unique<texture_glyph_run>(*this, std::move(str), tab_size, offset);
+}
+
 real texture_font::get_advance(char32_t c, unsigned tab_size) const
 {
 	if (c == U'\t') {
-		return this->get_glyph(U' ').advance * real(tab_size);
+		return this->get_glyph_metrics(U' ').advance * real(tab_size);
 	} else {
-		auto& g = this->get_glyph(c);
+		auto& g = this->get_glyph_metrics(c);
 		return g.advance;
 	}
 }
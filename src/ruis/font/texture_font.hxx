@@ -21,23 +21,26 @@ along with this program. If not, see <http://www.gnu.org/licenses/>.
 
 #pragma once
 
-#include <list>
+#include <mutex>
+#include <optional>
 #include <sstream>
 #include <stdexcept>
 #include <unordered_map>
 
 #include <ft2build.h>
 #include FT_FREETYPE_H
+#include FT_SIZES_H
 
 #include <papki/file.hpp>
 #include <r4/rectangle.hpp>
 #include <r4/vector.hpp>
 
 #include "../config.hpp"
-#include "../render/texture_2d.hpp"
-#include "../render/vertex_array.hpp"
+#include "../render/renderer.hpp"
+#include "../util/mapped_file.hpp"
 
 #include "font.hpp"
+#include "glyph_atlas.hxx"
 
 namespace ruis {
 
@@ -46,6 +49,10 @@ class freetype_face
 	struct freetype_lib_wrapper {
 		FT_Library lib = nullptr;
 
+		// the library is shared by faces used from different threads,
+		// FreeType requires creation and destruction of faces of the same library to be serialized
+		std::mutex mutex;
+
 		freetype_lib_wrapper();
 
 		freetype_lib_wrapper(const freetype_lib_wrapper&) = delete;
@@ -55,13 +62,20 @@ class freetype_face
 		freetype_lib_wrapper& operator=(freetype_lib_wrapper&&) = delete;
 
 		~freetype_lib_wrapper();
-	} freetype;
+
+		// returns the FreeType library shared by all the faces, the library is created on first use
+		static std::shared_ptr<freetype_lib_wrapper> get_shared();
+	};
+
+	// FreeType library must outlive the face
+	const std::shared_ptr<freetype_lib_wrapper> freetype;
 
 	struct freetype_face_wrapper {
+		freetype_lib_wrapper& lib;
 		FT_Face f = nullptr;
-		std::vector<std::uint8_t> font_file; // the buffer should be alive as long as the Face is alive!!!
+		const utki::shared_ref<const mapped_file> font_file; // should be alive as long as the Face is alive!!!
 
-		freetype_face_wrapper(FT_Library& lib, const papki::file& fi);
+		freetype_face_wrapper(freetype_lib_wrapper& lib, utki::shared_ref<const mapped_file> font_file);
 
 		freetype_face_wrapper(const freetype_face_wrapper&) = delete;
 		freetype_face_wrapper& operator=(const freetype_face_wrapper&) = delete;
@@ -72,19 +86,73 @@ class freetype_face
 		~freetype_face_wrapper() noexcept;
 	} face;
 
+	// The face is shared by fonts of all contexts, which can be used from different threads.
+	// FreeType face is not thread safe, so size activation and glyph loading are serialized.
+	mutable std::mutex mutex;
+
+	// FreeType size objects for each requested font size, owned and destroyed by the face
+	mutable std::unordered_map<unsigned, FT_Size> sizes;
+
+	// activates FreeType size object of the given font size, creates one if needed,
+	// the face mutex must be locked by the caller
 	void set_size(unsigned font_size) const;
 
+	mutable std::optional<uint64_t> content_hash;
+
 public:
 	freetype_face(const papki::file& fi);
 
+	freetype_face(utki::shared_ref<const mapped_file> font_file);
+
+	/**
+	 * @brief Load font face.
+	 * Faces of files on the local file system are cached, loading a face from the same file again returns
+	 * the already loaded face while it is still in use. Files are identified by the file system identity,
+	 * see mapped_file::map(). Faces of other files are not cached.
+	 * @param fi - font file.
+	 * @return Loaded font face.
+	 */
+	static utki::shared_ref<const freetype_face> load(const papki::file& fi);
+
+	/**
+	 * @brief Load font face from file contents in memory.
+	 * The face uses the file contents directly, without copying.
+	 * Loaded faces are cached, loading a face from the same file contents again returns the already loaded face
+	 * while it is still in use.
+	 * @param font_file - font file contents.
+	 * @return Loaded font face.
+	 */
+	static utki::shared_ref<const freetype_face> load(const utki::shared_ref<const mapped_file>& font_file);
+
 	struct glyph {
 		std::array<r4::vector2<real>, 4> vertices{};
 		rasterimage::image<uint8_t, 1> image;
 		real advance = 0;
 	};
 
+	/**
+	 * @brief Load and render glyph.
+	 * @param c - character to load the glyph for.
+	 * @param font_size - font size in pixels.
+	 * @return Glyph with rendered bitmap. Negative advance means that the glyph could not be loaded.
+	 */
 	glyph load_glyph(char32_t c, unsigned font_size) const;
 
+	struct glyph_metrics {
+		r4::vector2<real> top_left;
+		r4::vector2<real> bottom_right;
+		real advance = 0;
+	};
+
+	/**
+	 * @brief Load glyph metrics without rendering the glyph bitmap.
+	 * @param c - character to load the glyph metrics for.
+	 * @param font_size - font size in pixels.
+	 * @return Glyph metrics.
+	 * @return std::nullopt if the glyph could not be loaded.
+	 */
+	std::optional<glyph_metrics> load_glyph_metrics(char32_t c, unsigned font_size) const;
+
 	struct metrics {
 		real height;
 		real descender;
@@ -92,14 +160,27 @@ public:
 	};
 
 	metrics get_metrics(unsigned font_size) const;
+
+	/**
+	 * @brief Get hash of the font file contents.
+	 * The hash is calculated on first call, from the file size and the font tables directory at the start of the file.
+	 * @return Hash of the font file contents.
+	 */
+	uint64_t get_content_hash() const;
 };
 
 /**
  * @brief A texture font.
- * This font implementation reads a Truetype font from 'ttf' file and renders given
- * set of characters to a texture.
+ * This font implementation reads a Truetype font from 'ttf' file and renders
+ * glyphs of used characters to a glyph atlas texture.
+ * Glyph metrics are cached separately from glyph bitmaps, so measuring text does not render any glyphs,
+ * glyph bitmaps are rendered to the atlas only when the glyphs are actually drawn.
  * Then, for rendering strings of text it renders
- * row of quads with texture coordinates corresponding to string characters on the texture.
+ * row of quads with texture coordinates corresponding to string characters on the atlas,
+ * the whole string is rendered with one draw call.
+ * When the atlas is full or the number of cached glyphs reaches the limit, all the cached glyphs are evicted.
+ * In case glyphs are evicted while building quads of a string, the string is rendered in several draw calls,
+ * the quads built before the eviction are rendered with the texture of the evicted glyphs.
  */
 class texture_font : public font
 {
@@ -107,29 +188,48 @@ class texture_font : public font
 
 	const utki::shared_ref<const freetype_face> face;
 
-	mutable std::list<char32_t> last_used_order;
+	struct glyph_metrics {
+		ruis::vector2 top_left;
+		ruis::vector2 bottom_right;
+
+		real advance = 0;
+
+		// false for glyphs without bitmap, like space
+		bool has_bitmap = false;
+
+		// true if the font has no glyph for the character, so the 'unknown character' glyph is used instead
+		bool substituted = false;
+	};
+
+	mutable std::unordered_map<char32_t, glyph_metrics> metrics;
+
+	glyph_metrics unknown_glyph_metrics;
+
+	glyph_metrics load_glyph_metrics(char32_t c) const;
 
 	struct glyph {
 		ruis::vector2 top_left;
 		ruis::vector2 bottom_right;
 
-		// TOOD: make utki::shared_ref?
-		std::shared_ptr<render::vertex_array> vao;
-		std::shared_ptr<render::texture_2d> tex;
+		// position of the glyph bitmap within the atlas, empty for glyphs without bitmap, like space
+		r4::rectangle<uint32_t> atlas_rect{0, 0};
 
 		real advance = 0;
-
-		decltype(last_used_order)::iterator last_used_iter;
 	};
 
+	mutable glyph_atlas atlas;
+
 	mutable std::unordered_map<char32_t, glyph> glyphs;
 
 	unsigned max_cached;
 
-	glyph unknown_glyph;
-
 	glyph load_glyph(char32_t c) const;
 
+	// texture of the atlas with the last evicted glyphs, the quads built before the eviction refer to it
+	mutable std::shared_ptr<const render::texture_2d> evicted_texture;
+
+	void evict_glyphs() const;
+
 public:
 	/**
 	 * @brief Constructor.
@@ -160,9 +260,42 @@ protected:
 
 	ruis::rect get_bounding_box_internal(std::u32string_view str, unsigned tab_size) const override;
 
+	std::unique_ptr<const glyph_run> make_glyph_run_internal(
+		std::u32string str,
+		unsigned tab_size,
+		size_t offset
+	) const override;
+
 private:
-	real render_glyph_internal(const ruis::matrix4& matrix, r4::vector4<float> color, char32_t ch) const;
+	// NOTE: the returned reference is valid only until next call to get_glyph_metrics()
+	const glyph_metrics& get_glyph_metrics(char32_t c) const;
 
+	// renders the glyph bitmap to the atlas in case it is not there yet
+	// NOTE: the returned reference is valid only until next call to get_glyph()
 	const glyph& get_glyph(char32_t c) const;
+
+	// quads of glyphs which are on the same texture
+	struct quads_chunk {
+		std::vector<render::renderer::quad> quads;
+
+		// texture of evicted glyphs, nullptr if the quads refer to the current atlas texture
+		std::shared_ptr<const render::texture_2d> tex;
+	};
+
+	// texture coordinates of the last built chunk are valid for the current atlas generation and dimensions
+	render_result build_quads(
+		std::vector<quads_chunk>& chunks,
+		std::u32string_view str,
+		unsigned tab_size,
+		size_t offset
+	) const;
+
+	void render_quads(
+		const ruis::matrix4& matrix,
+		r4::vector4<float> color,
+		utki::span<const quads_chunk> chunks
+	) const;
+
+	class texture_glyph_run;
 };
 } // namespace ruis
@@ -21,6 +21,8 @@ along with this program. If not, see <http://www.gnu.org/licenses/>.
 
 #include "gui.hpp"
 
+#include <utki/util.hpp>
+
 #include "layout/linear_layout.hpp"
 #include "layout/pile_layout.hpp"
 #include "layout/size_layout.hpp"
@@ -345,6 +347,7 @@ void gui::init_standard_widgets(papki::file& fi)
 void gui::set_viewport(const ruis::vector2& size)
 {
 	this->viewport_size = size;
+	this->context.get().add_damage_all();
 
 	this->root_widget.get().resize(this->viewport_size);
 }
@@ -356,11 +359,76 @@ void gui::set_root(const utki::shared_ref<ruis::widget>& w)
 	}
 
 	this->root_widget = w;
+	this->context.get().add_damage_all();
 
 	this->root_widget.get().move_to(ruis::vector2(0));
 	this->root_widget.get().resize(this->viewport_size);
 }
 
+namespace {
+// with too many damaged regions it is cheaper to re-render their union at once
+constexpr size_t max_damage_regions = 4;
+
+r4::rectangle<float> unite(const r4::rectangle<float>& a, const r4::rectangle<float>& b)
+{
+	auto a_end = a.x2_y2();
+	auto b_end = b.x2_y2();
+
+	r4::rectangle<float> ret{0, 0};
+	for (size_t i = 0; i != ret.p.size(); ++i) {
+		using std::min;
+		using std::max;
+		ret.p[i] = min(a.p[i], b.p[i]);
+		ret.d[i] = max(a_end[i], b_end[i]) - ret.p[i];
+	}
+	return ret;
+}
+
+bool overlap(const r4::rectangle<float>& a, const r4::rectangle<float>& b)
+{
+	auto a_end = a.x2_y2();
+	auto b_end = b.x2_y2();
+	return a.p.x() < b_end.x() && b.p.x() < a_end.x() && a.p.y() < b_end.y() && b.p.y() < a_end.y();
+}
+
+std::vector<r4::rectangle<float>> merge_damage(const std::vector<r4::rectangle<float>>& damage)
+{
+	std::vector<r4::rectangle<float>> ret;
+
+	for (auto d : damage) {
+		// clamp to viewport in normalized device coordinates
+		d.intersect({{-1, -1}, {2, 2}});
+		if (!d.d.is_positive()) {
+			continue;
+		}
+
+		// merge with overlapping regions
+		for (auto i = ret.begin(); i != ret.end();) {
+			if (overlap(*i, d)) {
+				d = unite(d, *i);
+				ret.erase(i);
+				// the grown region can overlap regions checked before, so start over
+				i = ret.begin();
+			} else {
+				++i;
+			}
+		}
+
+		ret.push_back(d);
+	}
+
+	if (ret.size() > max_damage_regions) {
+		auto u = ret.front();
+		for (const auto& d : ret) {
+			u = unite(u, d);
+		}
+		ret = {u};
+	}
+
+	return ret;
+}
+} // namespace
+
 void gui::render(const matrix4& matrix) const
 {
 	if (this->get_root().is_layout_dirty()) {
@@ -369,11 +437,71 @@ void gui::render(const matrix4& matrix) const
 		})
 		// TODO: render() is const, but calls non-const lay_out(), fix it somehow? Perhaps make render() non-const?
 		this->root_widget.get().lay_out();
+
+		// layout change can move any widget
+		this->context.get().add_damage_all();
 	}
 
 	ruis::matrix4 m = make_viewport_matrix(matrix, this->viewport_size);
 
-	this->get_root().render_internal(m);
+	auto& c = this->context.get();
+	auto& r = c.renderer.get();
+
+	utki::scope_exit damage_scope_exit([&c]() {
+		c.damaged_all = false;
+		c.damage.clear();
+	});
+
+	utki::scope_exit frame_stats_scope_exit([&r]() {
+		r.finish_frame();
+	});
+
+	this->damage.clear();
+
+	if (!this->partial_rendering || c.damaged_all) {
+		this->get_root().render_internal(m);
+		r.flush();
+		this->damage.push_back(r.get_viewport());
+		return;
+	}
+
+	for (const auto& region : merge_damage(c.damage)) {
+		// convert to window coordinates
+		auto p1 = r.to_window_coords(region.p);
+		auto p2 = r.to_window_coords(region.x2_y2());
+		r4::rectangle<uint32_t> scissor{0, 0};
+		for (size_t i = 0; i != p1.size(); ++i) {
+			using std::min;
+			using std::max;
+			scissor.p[i] = min(p1[i], p2[i]);
+			scissor.d[i] = max(p1[i], p2[i]) - scissor.p[i];
+		}
+		if (!scissor.d.is_positive()) {
+			continue;
+		}
+		this->damage.push_back(scissor);
+
+		utki::scope_exit scissor_scope_exit([&r, old_scissor = r.get_scissor_state()]() {
+			r.set_scissor_state(old_scissor);
+		});
+		r.set_scissor_state({.enabled = true, .rect = scissor});
+
+		utki::scope_exit cull_rect_scope_exit([&r, old_cull_rect = r.get_cull_rect()]() {
+			r.set_cull_rect(old_cull_rect);
+		});
+		r.set_cull_rect(region);
+
+		r.clear_framebuffer_color();
+
+		this->get_root().render_internal(m);
+		r.flush();
+	}
+}
+
+void gui::set_partial_rendering(bool enable)
+{
+	this->partial_rendering = enable;
+	this->context.get().add_damage_all();
 }
 
 void gui::send_mouse_move(const vector2& pos, unsigned id)
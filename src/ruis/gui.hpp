@@ -21,6 +21,8 @@ along with this program. If not, see <http://www.gnu.org/licenses/>.
 
 #pragma once
 
+#include <vector>
+
 #include "context.hpp"
 #include "updateable.hpp"
 
@@ -98,6 +100,48 @@ public:
 	 */
 	void render(const matrix4& matrix = matrix4().set_identity()) const;
 
+private:
+	bool partial_rendering = false;
+
+	mutable std::vector<r4::rectangle<uint32_t>> damage;
+
+public:
+	/**
+	 * @brief Enable/disable partial rendering.
+	 * In partial rendering mode the render() re-renders only the areas damaged since previous render() call,
+	 * i.e. the areas of widgets whose appearance has changed. The damaged areas are cleared with
+	 * renderer::clear_framebuffer_color() under scissor test before re-rendering.
+	 * The rest of the frame buffer is left intact, so the frame buffer contents must be preserved
+	 * between frames and must not be cleared by the caller.
+	 * Layout changes, viewport size changes and root widget changes cause full re-rendering.
+	 * By default, partial rendering is disabled.
+	 * @param enable - whether to enable (true) or disable (false) partial rendering.
+	 */
+	void set_partial_rendering(bool enable);
+
+	/**
+	 * @brief Check if partial rendering is enabled.
+	 * @return true if partial rendering is enabled.
+	 * @return false otherwise.
+	 */
+	bool is_partial_rendering() const noexcept
+	{
+		return this->partial_rendering;
+	}
+
+	/**
+	 * @brief Get areas updated by the last render() call.
+	 * The areas are in the renderer's window coordinates, same as renderer::get_viewport().
+	 * Platform backends can use these to present only the updated parts of the frame.
+	 * In case nothing was damaged since previous render() call, the list is empty
+	 * and presenting the frame can be skipped altogether.
+	 * @return List of updated areas.
+	 */
+	const std::vector<r4::rectangle<uint32_t>>& get_damage() const noexcept
+	{
+		return this->damage;
+	}
+
 	/**
 	 * @brief Initialize standard widgets library.
 	 * In addition to core widgets it is possible to use standard widgets.
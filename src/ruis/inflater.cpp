@@ -21,6 +21,10 @@ along with this program. If not, see <http://www.gnu.org/licenses/>.
 
 #include "inflater.hpp"
 
+#include <algorithm>
+#include <iterator>
+#include <optional>
+
 #include "util/util.hpp"
 
 #include "context.hpp"
@@ -109,65 +113,175 @@ void substitute_vars(
 } // namespace
 
 namespace {
-tml::forest apply_gui_template(const tml::forest& templ, const std::set<std::string>& var_names, tml::forest trees)
+bool is_template_child(const tml::tree& arg)
+{
+	return !is_leaf_property(arg.value) || (is_variable(arg) && arg.children.front() == "children");
+}
+
+// returns variable name if the node is a well formed variable reference
+const std::string* get_variable_name(const tml::tree& node)
+{
+	if (node.value != "$" || node.children.size() != 1 || !node.children.front().children.empty()) {
+		return nullptr;
+	}
+	return &node.children.front().value.string;
+}
+} // namespace
+
+inflater::widget_template::instruction inflater::widget_template::compile(
+	const tml::tree& node,
+	const decltype(slots)& slots
+)
+{
+	instruction ret;
+
+	if (auto name = get_variable_name(node)) {
+		auto i = slots.find(*name);
+		if (i != slots.end()) {
+			ret.node = node;
+			ret.slot = i->second;
+			ret.literal = false;
+			return ret;
+		}
+	}
+
+	for (const auto& c : node.children) {
+		ret.children.push_back(compile(c, slots));
+		if (!ret.children.back().literal) {
+			ret.literal = false;
+		}
+	}
+
+	if (ret.literal) {
+		// no variable references in the subtree, no need to keep instructions for children
+		ret.children.clear();
+		ret.node = node;
+	} else {
+		ret.node = tml::tree(node.value);
+	}
+
+	return ret;
+}
+
+inflater::widget_template::widget_template(tml::tree templ, std::set<std::string> vars) :
+	templ(std::move(templ)),
+	vars(std::move(vars))
+{
+	for (const auto& v : this->vars) {
+		this->slots.try_emplace(v, this->slots.size());
+	}
+	this->children_slot = this->slots.try_emplace("children", this->slots.size()).first->second;
+
+	for (const auto& n : this->templ.children) {
+		this->program.push_back(compile(n, this->slots));
+	}
+
+	// NOTE: the program is not modified after this point, so the keys referring to its strings stay valid
+	for (size_t i = 0; i != this->program.size(); ++i) {
+		const auto& instr = this->program[i];
+		if (instr.slot == instruction::no_slot && is_leaf_property(instr.node.value)) {
+			// in case of same named properties the first one is replaced
+			this->properties.try_emplace(instr.node.value.string, i);
+		}
+	}
+}
+
+void inflater::widget_template::emit(
+	tml::forest& out,
+	const instruction& instr,
+	utki::span<const std::optional<tml::forest>> values
+)
+{
+	if (instr.literal) {
+		out.push_back(instr.node);
+		return;
+	}
+
+	if (instr.slot != instruction::no_slot) {
+		const auto& v = values[instr.slot];
+		if (v.has_value()) {
+			out.insert(out.end(), v->begin(), v->end());
+		} else {
+			// variables not given as arguments are left for later substitution
+			out.push_back(instr.node);
+		}
+		return;
+	}
+
+	out.emplace_back(instr.node.value);
+	auto& node = out.back();
+	for (const auto& c : instr.children) {
+		emit(node.children, c, values);
+	}
+}
+
+tml::forest inflater::widget_template::instantiate(tml::forest args) const
 {
-	// std::cout << "applying template: " << tml::to_string(templ) << std::endl;
-	// std::cout << "trees: " << tml::to_string(trees) << std::endl;
-	tml::forest ret = templ; // copy template
+	std::vector<std::optional<tml::forest>> values(this->slots.size());
+
+	// replaced values of top level properties
+	std::vector<std::optional<tml::forest>> replaced(this->program.size());
 
-	std::map<std::string, tml::forest> vars;
 	tml::forest children;
-	for (auto& i : trees) {
-		if (!is_leaf_property(i.value) || (is_variable(i) && i.children.front() == "children")) {
-			children.emplace_back(std::move(i));
+	tml::forest extra_properties;
+
+	for (auto& a : args) {
+		if (is_template_child(a)) {
+			children.emplace_back(std::move(a));
+			continue;
+		}
+
+		if (auto i = this->slots.find(a.value.string); i != this->slots.end()) {
+			values[i->second] = std::move(a.children);
 			continue;
 		}
 
-		if (var_names.find(i.value.string) != var_names.end()) {
-			vars[i.value.string] = std::move(i.children);
+		if (auto i = this->properties.find(a.value.string); i != this->properties.end()) {
+			replaced[i->second] = std::move(a.children);
 			continue;
 		}
 
-		auto t = std::find(ret.begin(), ret.end(), i.value);
-		if (t != ret.end()) {
-			t->children = std::move(i.children);
+		if (auto i = std::find(extra_properties.begin(), extra_properties.end(), a.value);
+			i != extra_properties.end())
+		{
+			i->children = std::move(a.children);
 			continue;
 		}
 
-		ret.emplace_back(std::move(i));
+		extra_properties.emplace_back(std::move(a));
 	}
-	vars["children"] = std::move(children);
+	values[this->children_slot] = std::move(children);
 
-#ifdef DEBUG
-	// for (auto& v : vars) {
-	// 	std::cout << "v = " << v.first << std::endl;
-	// }
-	// std::cout << "ret = " << tml::to_string(ret) << std::endl;
-#endif
+	auto find_var = [&](const std::string& name) -> const tml::forest* {
+		auto i = this->slots.find(name);
+		if (i == this->slots.end() || !values[i->second].has_value()) {
+			return nullptr;
+		}
+		return &values[i->second].value();
+	};
 
-	substitute_vars(
-		ret,
-		[&vars](const std::string& name) -> const tml::forest* {
-			// TRACE(<< "looking for var = " << name << std::endl)
-			auto i = vars.find(name);
-			if (i == vars.end()) {
-				// TRACE(<< "not found" << std::endl)
-				return nullptr;
-			}
-			// TRACE(<< "found = " << tml::to_string(i->second) << std::endl)
-			return &i->second;
-		},
-		false,
-		true
-	);
+	tml::forest ret;
+	ret.reserve(this->program.size() + extra_properties.size());
+
+	for (size_t i = 0; i != this->program.size(); ++i) {
+		auto& r = replaced[i];
+		if (!r.has_value()) {
+			emit(ret, this->program[i], utki::make_span(values));
+			continue;
+		}
+
+		// the argument value can refer to template variables as well
+		substitute_vars(r.value(), find_var, false, true);
+		ret.emplace_back(this->program[i].node.value, std::move(r.value()));
+	}
 
-	// std::cout << "ret substed = " << tml::to_string(ret) << std::endl;
+	substitute_vars(extra_properties, find_var, false, true);
+	std::move(extra_properties.begin(), extra_properties.end(), std::back_inserter(ret));
 
 	return ret;
 }
-} // namespace
 
-const decltype(inflater::factories)::value_type::second_type& inflater::find_factory(const std::string& widget_name)
+const decltype(inflater::factories)::value_type::second_type& inflater::find_factory(std::string_view widget_name)
 {
 	auto i = this->factories.find(widget_name);
 
@@ -190,38 +304,56 @@ utki::shared_ref<widget> inflater::inflate(const std::string& str)
 	return this->inflate(str.c_str());
 }
 
-utki::shared_ref<widget> inflater::inflate(tml::forest::const_iterator begin, tml::forest::const_iterator end)
+namespace {
+// Widget names of expanded widget declarations are prefixed with the marker,
+// so that templates and variables are not resolved for those again.
+constexpr char expanded_widget_marker = '!';
+
+bool is_expanded_widget(const tml::leaf& l)
 {
-	auto i = begin;
+	return l.string.size() >= 2 && l.string[0] == '@' && l.string[1] == expanded_widget_marker;
+}
 
-	if (i == end) {
+void check_widget_declaration(tml::forest::const_iterator begin, tml::forest::const_iterator end)
+{
+	if (begin == end) {
 		throw std::invalid_argument("inflater::inflater(): widget declaration not found in supplied forest");
 	}
 
-	if (is_leaf_property(i->value) || i->value.empty() || i->value.string[0] != '@') {
+	if (is_leaf_property(begin->value)) {
 		throw std::invalid_argument(
-			"inflater::inflater(): widget declaration must go first, found: "s + i->value.string
+			"inflater::inflater(): widget declaration must go first, found: "s + begin->value.string
 		);
 	}
+}
+} // namespace
 
-	std::string widget_name;
-	tml::forest widget_desc;
-
-	// TRACE(<< "inflating = " << i->value.string << std::endl)
-	if (auto tmpl = this->find_template(i->value.string.substr(1))) {
-		widget_name = tmpl->templ.value.string.substr(1);
-		// std::cout << "i->children = " << tml::to_string(i->children) << std::endl;
-		widget_desc = apply_gui_template(
-			tmpl->templ.children,
-			tmpl->vars,
-			tml::forest(i->children) // copy children
-		);
+std::pair<std::string, tml::forest> inflater::apply_template(const tml::tree& widget_decl) const
+{
+	// TRACE(<< "inflating = " << widget_decl.value.string << std::endl)
+	if (auto tmpl = this->find_template(std::string_view(widget_decl.value.string).substr(1))) {
+		// std::cout << "children = " << tml::to_string(widget_decl.children) << std::endl;
+		return {
+			tmpl->templ.value.string.substr(1),
+			tmpl->instantiate(tml::forest(widget_decl.children)) // copy children
+		};
 		// TRACE(<< "After applying template: " << tml::to_string(widget_desc) << std::endl)
-	} else {
-		widget_name = i->value.string.substr(1);
-		widget_desc = i->children;
+	}
+	return {widget_decl.value.string.substr(1), widget_decl.children};
+}
+
+utki::shared_ref<widget> inflater::inflate(tml::forest::const_iterator begin, tml::forest::const_iterator end)
+{
+	check_widget_declaration(begin, end);
+
+	if (is_expanded_widget(begin->value)) {
+		return this->inflate_expanded(*begin);
 	}
 
+	auto decl = this->apply_template(*begin);
+	auto& widget_name = decl.first;
+	auto& widget_desc = decl.second;
+
 	auto fac = this->find_factory(widget_name);
 
 	unsigned num_pop_defs = 0;
@@ -262,6 +394,122 @@ utki::shared_ref<widget> inflater::inflate(tml::forest::const_iterator begin, tm
 	}
 }
 
+tml::tree inflater::expand(const tml::tree& widget_decl)
+{
+	if (is_expanded_widget(widget_decl.value)) {
+		return widget_decl;
+	}
+
+	auto decl = this->apply_template(widget_decl);
+	auto& widget_name = decl.first;
+	auto& widget_desc = decl.second;
+
+	// check that the widget is known
+	this->find_factory(widget_name);
+
+	unsigned num_pop_defs = 0;
+	utki::scope_exit pop_defs_scope_exit([this, &num_pop_defs]() {
+		for (unsigned i = 0; i != num_pop_defs; ++i) {
+			this->pop_defs_block();
+		}
+	});
+
+	// Contents of the defs blocks are kept in the expanded description as is, because the widget can inflate
+	// some internal GUI scripts which may refer to the local definitions.
+	std::vector<tml::forest> defs_blocks;
+
+	for (auto& d : widget_desc) {
+		if (d.value != wording_defs) {
+			continue;
+		}
+		this->push_defs_block(d.children);
+		++num_pop_defs;
+
+		defs_blocks.push_back(std::move(d.children));
+		d.children.clear();
+	}
+
+	substitute_vars(
+		widget_desc,
+		[this](const std::string& name) -> const tml::forest* {
+			return this->find_variable(name);
+		},
+		true,
+		false
+	);
+
+	auto defs_block = defs_blocks.begin();
+	for (auto& c : widget_desc) {
+		if (c.value == wording_defs) {
+			ASSERT(defs_block != defs_blocks.end())
+			c.children = std::move(*defs_block);
+			++defs_block;
+		} else if (is_leaf_child(c.value)) {
+			c = this->expand(c);
+		}
+	}
+
+	return tml::tree(tml::leaf("@"s + expanded_widget_marker + widget_name), std::move(widget_desc));
+}
+
+utki::shared_ref<widget> inflater::inflate_expanded(const tml::tree& widget_decl)
+{
+	ASSERT(is_expanded_widget(widget_decl.value))
+
+	auto widget_name = std::string_view(widget_decl.value.string).substr(2);
+
+	auto fac = this->find_factory(widget_name);
+
+	const auto& desc = widget_decl.children;
+
+	auto has_defs = std::any_of(desc.begin(), desc.end(), [](const auto& d) {
+		return d.value == wording_defs && !d.children.empty();
+	});
+
+	try {
+		if (!has_defs) {
+			// fast path, the description is passed to the widget as is, without copying
+			return fac(utki::make_shared_from(this->context), desc);
+		}
+
+		unsigned num_pop_defs = 0;
+		utki::scope_exit pop_defs_scope_exit([this, &num_pop_defs]() {
+			for (unsigned i = 0; i != num_pop_defs; ++i) {
+				this->pop_defs_block();
+			}
+		});
+
+		tml::forest widget_desc = desc;
+		for (auto& d : widget_desc) {
+			if (d.value != wording_defs) {
+				continue;
+			}
+			this->push_defs_block(d.children);
+			++num_pop_defs;
+			d.children.clear();
+		}
+
+		return fac(utki::make_shared_from(this->context), widget_desc);
+	} catch (...) {
+		LOG([&](auto& o) {
+			o << "could not inflate widget: " << widget_name << "{" << tml::to_string(desc) << "}" << std::endl;
+		})
+		throw;
+	}
+}
+
+inflater::prototype inflater::make_prototype(tml::forest::const_iterator begin, tml::forest::const_iterator end)
+{
+	check_widget_declaration(begin, end);
+
+	return prototype(this->expand(*begin));
+}
+
+utki::shared_ref<widget> inflater::inflate(const prototype& proto)
+{
+	return this->inflate_expanded(proto.desc);
+}
+
 namespace {
 // name starts with @
 void check_template_recursion(const std::string& name, const tml::forest& desc)
@@ -279,10 +527,16 @@ void check_template_recursion(const std::string& name, const tml::forest& desc)
 }
 } // namespace
 
-inflater::widget_template inflater::parse_template(const std::string& name, const tml::forest& templ)
+std::unique_ptr<inflater::widget_template> inflater::parse_template(
+	const std::string& name,
+	const tml::forest& templ
+)
 {
 	// TRACE(<< "parse_template(): templ = " << tml::to_string(templ) << std::endl)
-	widget_template ret;
+	struct {
+		tml::tree templ;
+		std::set<std::string> vars;
+	} ret;
 
 	for (auto& n : templ) {
 		// template definition
@@ -329,19 +583,17 @@ inflater::widget_template inflater::parse_template(const std::string& name, cons
 	// TODO: why is recursion not allowed?
 	check_template_recursion(name, ret.templ.children);
 
-	if (auto tmpl = this->find_template(ret.templ.value.string.substr(1))) {
+	if (auto tmpl = this->find_template(std::string_view(ret.templ.value.string).substr(1))) {
 		ret.templ.value = tmpl->templ.value;
-		ret.templ.children = apply_gui_template( //
-			tmpl->templ.children,
-			tmpl->vars,
-			std::move(ret.templ.children)
-		);
+		ret.templ.children = tmpl->instantiate(std::move(ret.templ.children));
 
 		ret.vars.insert(tmpl->vars.begin(), tmpl->vars.end()); // forward all variables
 	}
 
 	// TRACE(<< "template parsed: " << tml::to_string(ret.templ) << std::endl)
-	return ret;
+
+	// compile the template once here, so that instantiating it does not have to analyze the template every time
+	return std::make_unique<widget_template>(std::move(ret.templ), std::move(ret.vars));
 }
 
 void inflater::push_defs(tml::forest::const_iterator begin, tml::forest::const_iterator end)
@@ -416,12 +668,12 @@ void inflater::pop_templates()
 	this->templates.pop_back();
 }
 
-const inflater::widget_template* inflater::find_template(const std::string& name) const
+const inflater::widget_template* inflater::find_template(std::string_view name) const
 {
 	for (auto i = this->templates.rbegin(); i != this->templates.rend(); ++i) {
 		auto r = i->find(name);
 		if (r != i->end()) {
-			return &r->second;
+			return r->second.get();
 		}
 	}
 	//	TRACE(<< "inflater::find_template(): template '" << name <<"' not found!!!" << std::endl)
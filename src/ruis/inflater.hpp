@@ -22,12 +22,19 @@ along with this program. If not, see <http://www.gnu.org/licenses/>.
 #pragma once
 
 #include <functional>
+#include <limits>
 #include <map>
 #include <memory>
+#include <optional>
 #include <set>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include <tml/tree.hpp>
 #include <utki/shared_ref.hpp>
+#include <utki/span.hpp>
 
 namespace ruis {
 
@@ -52,10 +59,11 @@ class inflater
 private:
 	std::map<
 		std::string,
-		std::function<utki::shared_ref<ruis::widget>(const utki::shared_ref<ruis::context>&, const tml::forest&)>>
+		std::function<utki::shared_ref<ruis::widget>(const utki::shared_ref<ruis::context>&, const tml::forest&)>,
+		std::less<>>
 		factories;
 
-	const decltype(factories)::value_type::second_type& find_factory(const std::string& widget_name);
+	const decltype(factories)::value_type::second_type& find_factory(std::string_view widget_name);
 
 	void add_factory(std::string widget_name, decltype(factories)::value_type::second_type factory);
 
@@ -150,6 +158,62 @@ public:
 		return utki::dynamic_reference_cast<widget_type>(this->inflate(str));
 	}
 
+	/**
+	 * @brief Widget prototype.
+	 * Prototype is a GUI script of a widget in which all GUI templates are expanded and all variables
+	 * are substituted, for the widget itself and for all its child widgets.
+	 * Inflating a widget from prototype does not need to resolve templates and variables again,
+	 * so it is cheaper than inflating the same widget from the original GUI script.
+	 * Use prototypes to create many instances of the same widget, e.g. list items.
+	 */
+	class prototype
+	{
+		friend class inflater;
+
+		tml::tree desc;
+
+		explicit prototype(tml::tree desc) :
+			desc(std::move(desc))
+		{}
+	};
+
+	/**
+	 * @brief Create widget prototype from GUI script.
+	 * Templates and variables are resolved within current definitions scope.
+	 * @param begin - begin iterator into the GUI script.
+	 * @param end - end iterator into the GUI script.
+	 * @return prototype of the first widget of the GUI script.
+	 */
+	prototype make_prototype(tml::forest::const_iterator begin, tml::forest::const_iterator end);
+
+	/**
+	 * @brief Create widget prototype from GUI script.
+	 * @param gui_script - GUI script to use.
+	 * @return prototype of the first widget of the GUI script.
+	 */
+	prototype make_prototype(const tml::forest& gui_script)
+	{
+		return this->make_prototype(gui_script.begin(), gui_script.end());
+	}
+
+	/**
+	 * @brief Create widgets hierarchy from widget prototype.
+	 * @param proto - widget prototype.
+	 * @return the inflated widget.
+	 */
+	utki::shared_ref<widget> inflate(const prototype& proto);
+
+	/**
+	 * @brief Inflate widget from prototype and cast to specified type.
+	 * @param proto - widget prototype.
+	 * @return the inflated widget.
+	 */
+	template <typename widget_type>
+	utki::shared_ref<widget_type> inflate_as(const prototype& proto)
+	{
+		return utki::dynamic_reference_cast<widget_type>(this->inflate(proto));
+	}
+
 	/**
 	 * @brief Inflate widget described in GUI script.
 	 * @param fi - file interface to get the GUI script.
@@ -172,16 +236,70 @@ public:
 private:
 	// TODO: why does clang-tidy complains about this line on macosx?
 	// NOLINTNEXTLINE(bugprone-exception-escape)
-	struct widget_template {
-		tml::tree templ;
-		std::set<std::string> vars;
+	class widget_template
+	{
+		// Compiled form of the template definition.
+		// Subtrees which have no references to template variables are stored as is,
+		// references to template variables are resolved to variable slots.
+		struct instruction {
+			constexpr static auto no_slot = std::numeric_limits<size_t>::max();
+
+			// the whole subtree for literal instructions, only the node value otherwise
+			tml::tree node;
+
+			// slot of the template variable to insert instead of the node, no_slot if none
+			size_t slot = no_slot;
+
+			bool literal = true;
+
+			std::vector<instruction> children;
+		};
+
+		std::vector<instruction> program;
+
+		// template variable name to slot mapping
+		std::unordered_map<std::string, size_t> slots;
+
+		size_t children_slot;
+
+		// top level property name to program index mapping, to replace property values given as arguments
+		std::unordered_map<std::string_view, size_t> properties;
+
+		static instruction compile(const tml::tree& node, const decltype(slots)& slots);
+
+		static void emit(
+			tml::forest& out,
+			const instruction& instr,
+			utki::span<const std::optional<tml::forest>> values
+		);
+
+	public:
+		const tml::tree templ;
+		const std::set<std::string> vars;
+
+		widget_template(tml::tree templ, std::set<std::string> vars);
+
+		widget_template(const widget_template&) = delete;
+		widget_template& operator=(const widget_template&) = delete;
+
+		widget_template(widget_template&&) = delete;
+		widget_template& operator=(widget_template&&) = delete;
+
+		~widget_template() = default;
+
+		/**
+		 * @brief Instantiate the template.
+		 * @param args - template arguments, i.e. contents of the template instance.
+		 * @return Description of the widget the template is defined with, with template variables substituted.
+		 */
+		tml::forest instantiate(tml::forest args) const;
 	};
 
-	widget_template parse_template(const std::string& name, const tml::forest& chain);
+	std::unique_ptr<widget_template> parse_template(const std::string& name, const tml::forest& chain);
 
-	std::vector<std::map<std::string, widget_template>> templates;
+	std::vector<std::map<std::string, std::unique_ptr<const widget_template>, std::less<>>> templates;
 
-	const widget_template* find_template(const std::string& name) const;
+	const widget_template* find_template(std::string_view name) const;
 
 	void push_templates(const tml::forest& chain);
 
@@ -197,6 +315,14 @@ private:
 
 	void push_defs_block(const tml::forest& chain);
 	void pop_defs_block();
+
+	// returns widget name and description of the widget declaration with template applied, if any
+	std::pair<std::string, tml::forest> apply_template(const tml::tree& widget_decl) const;
+
+	// expands templates and substitutes variables of the widget declaration and all its child widgets
+	tml::tree expand(const tml::tree& widget_decl);
+
+	utki::shared_ref<widget> inflate_expanded(const tml::tree& widget_decl);
 };
 
 } // namespace ruis
@@ -21,10 +21,27 @@ along with this program. If not, see <http://www.gnu.org/licenses/>.
 
 #include "layout_parameters.hpp"
 
+#include "../util/property_table.hpp"
 #include "../util/util.hpp"
 
 using namespace ruis;
 
+namespace {
+enum class layout_property {
+	dx,
+	dy,
+	weight,
+
+	enum_size
+};
+
+constexpr property_table<layout_property> layout_properties({
+	"dx",
+	"dy",
+	"weight",
+});
+} // namespace
+
 layout_parameters layout_parameters::make(const tml::forest& desc, const ruis::units& units)
 {
 	layout_parameters ret;
@@ -34,12 +51,18 @@ layout_parameters layout_parameters::make(const tml::forest& desc, const ruis::u
 		}
 
 		try {
-			if (p.value == "dx") {
-				ret.dims.x() = parse_layout_dimension_value(get_property_value(p), units);
-			} else if (p.value == "dy") {
-				ret.dims.y() = parse_layout_dimension_value(get_property_value(p), units);
-			} else if (p.value == "weight") {
-				ret.weight = get_property_value(p).to_float();
+			switch (layout_properties.find(p.value.string)) {
+				case layout_property::dx:
+					ret.dims.x() = parse_layout_dimension_value(get_property_value(p), units);
+					break;
+				case layout_property::dy:
+					ret.dims.y() = parse_layout_dimension_value(get_property_value(p), units);
+					break;
+				case layout_property::weight:
+					ret.weight = get_property_value(p).to_float();
+					break;
+				case layout_property::enum_size:
+					break;
 			}
 		} catch (std::invalid_argument&) {
 			LOG([&](auto& o) {
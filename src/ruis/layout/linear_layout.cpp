@@ -91,7 +91,7 @@ void linear_layout::lay_out(const vector2& dims, semiconst_widget_list& widgets)
 			}
 
 			if (!d.is_positive_or_zero()) {
-				vector2 md = w.get().measure(d);
+				vector2 md = w.get().measure_cached(d);
 				for (unsigned i = 0; i != md.size(); ++i) {
 					if (d[i] < 0) {
 						d[i] = md[i];
@@ -178,7 +178,7 @@ void linear_layout::lay_out(const vector2& dims, semiconst_widget_list& widgets)
 						[[fallthrough]];
 					case dim::length:
 						if (d.x() < 0 || d.y() < 0) {
-							vector2 md = w.get().measure(d);
+							vector2 md = w.get().measure_cached(d);
 							for (unsigned i = 0; i != md.size(); ++i) {
 								if (d[i] < 0) {
 									d[i] = md[i];
@@ -302,7 +302,7 @@ vector2 linear_layout::measure(const vector2& quotum, const_widget_list& widgets
 					break;
 			}
 
-			info->measured_dims = w.get().measure(child_quotum);
+			info->measured_dims = w.get().measure_cached(child_quotum);
 
 			rigid_length += info->measured_dims[long_index];
 
@@ -400,7 +400,7 @@ vector2 linear_layout::measure(const vector2& quotum, const_widget_list& widgets
 
 			if (quotum[trans_index] < 0) {
 				using std::max;
-				height = max(height, w.get().measure(d)[trans_index]);
+				height = max(height, w.get().measure_cached(d)[trans_index]);
 			}
 
 			++info;
@@ -97,7 +97,7 @@ vector2 pile_layout::measure(const vector2& quotum, const_widget_list& widgets)
 			}
 		}
 
-		d = w.get().measure(d);
+		d = w.get().measure_cached(d);
 
 		for (unsigned j = 0; j != d.size(); ++j) {
 			if (quotum[j] < 0) {
@@ -53,6 +53,7 @@ void path_vao::set(const path::vertices& path)
 
 void path_vao::render(const ruis::matrix4& matrix, uint32_t color) const
 {
+	this->renderer.get().flush();
 	this->renderer.get().shader->color_pos->render(matrix, this->core.get(), color);
 
 	this->renderer.get().shader->color_pos_lum->render(matrix, this->border.get(), color);
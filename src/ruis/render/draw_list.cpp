@@ -0,0 +1,316 @@
+/*
+ruis - GUI framework
+
+Copyright (C) 2012-2024  Ivan Gagis <igagis@gmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* ================ LICENSE END ================ */
+
+#include "draw_list.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <string_view>
+
+using namespace ruis::render;
+
+namespace {
+// how many preceding batches to look through when searching for a batch to merge the quads into
+constexpr size_t max_batch_lookback = 32;
+
+// vertex indices are 16 bit
+constexpr size_t max_batch_vertices = std::numeric_limits<uint16_t>::max() + 1;
+
+constexpr size_t num_quad_vertices = 4;
+} // namespace
+
+namespace {
+bool overlap(const r4::rectangle<float>& a, const r4::rectangle<float>& b)
+{
+	auto a_end = a.x2_y2();
+	auto b_end = b.x2_y2();
+	return a.p.x() < b_end.x() && b.p.x() < a_end.x() && a.p.y() < b_end.y() && b.p.y() < a_end.y();
+}
+
+void unite(r4::rectangle<float>& rect, r4::vector2<float> p)
+{
+	auto end = rect.x2_y2();
+	for (size_t i = 0; i != p.size(); ++i) {
+		rect.p[i] = std::min(rect.p[i], p[i]);
+		end[i] = std::max(end[i], p[i]);
+	}
+	rect.d = end - rect.p;
+}
+} // namespace
+
+draw_list::batch& draw_list::get_batch(
+	pipeline pipe,
+	const std::shared_ptr<const texture_2d>& tex,
+	r4::vector4<float> color,
+	const r4::rectangle<float>& bounding_box
+)
+{
+	const auto& scissor = this->owner.get_scissor_state();
+	const auto& blend = this->owner.get_blending();
+
+	size_t num_looked = 0;
+	for (auto i = this->batches.rbegin(); i != this->batches.rend() && num_looked != max_batch_lookback;
+		 ++i, ++num_looked)
+	{
+		auto& b = *i;
+		if (b.pipe == pipe && b.tex == tex && b.color == color && b.blend == blend && b.scissor == scissor &&
+			b.positions.size() + num_quad_vertices <= max_batch_vertices)
+		{
+			return b;
+		}
+
+		// the quads cannot be moved back past the batch they overlap with,
+		// otherwise the rendering order would be broken
+		if (overlap(b.bounding_box, bounding_box)) {
+			break;
+		}
+	}
+
+	this->batches.push_back(batch{
+		.pipe = pipe,
+		.tex = tex,
+		.color = color,
+		.blend = blend,
+		.scissor = scissor,
+		.bounding_box = bounding_box,
+		.positions = {},
+		.tex_coords = {}
+	});
+
+	return this->batches.back();
+}
+
+void draw_list::push(
+	pipeline pipe,
+	const r4::matrix4<float>& matrix,
+	utki::span<const quad> quads,
+	r4::vector4<float> color,
+	std::shared_ptr<const texture_2d> tex
+)
+{
+	if (pipe == pipeline::color_pos) {
+		// texture does not affect the result, so do not split batches by it
+		tex.reset();
+	} else {
+		ASSERT(tex)
+	}
+
+	if (pipe == pipeline::pos_tex) {
+		// color does not affect the result, so do not split batches by it
+		color = {1, 1, 1, 1};
+	}
+
+	for (const auto& q : quads) {
+		std::array<r4::vector2<float>, num_quad_vertices> positions;
+		auto pos_i = positions.begin();
+		for (const auto& v : q) {
+			*pos_i = matrix * v.pos;
+			++pos_i;
+		}
+
+		r4::rectangle<float> bb = {positions.front(), {0, 0}};
+		for (const auto& p : positions) {
+			unite(bb, p);
+		}
+
+		auto& b = this->get_batch(pipe, tex, color, bb);
+
+		if (b.positions.empty()) {
+			b.bounding_box = bb;
+		} else {
+			unite(b.bounding_box, bb.p);
+			unite(b.bounding_box, bb.x2_y2());
+		}
+
+		b.positions.insert(b.positions.end(), positions.begin(), positions.end());
+
+		if (pipe != pipeline::color_pos) {
+			for (const auto& v : q) {
+				b.tex_coords.push_back(v.tex_coord);
+			}
+		}
+	}
+}
+
+const std::shared_ptr<const index_buffer>& draw_list::get_quad_indices(size_t capacity_log2)
+{
+	if (this->quad_indices.size() <= capacity_log2) {
+		this->quad_indices.resize(capacity_log2 + 1);
+	}
+
+	auto& ib = this->quad_indices[capacity_log2];
+	if (ib) {
+		return ib;
+	}
+
+	size_t num_vertices = num_quad_vertices << capacity_log2;
+	ASSERT(num_vertices <= max_batch_vertices)
+
+	// each quad is rendered as two triangles
+	std::vector<uint16_t> indices;
+	indices.reserve(num_vertices / num_quad_vertices * 6);
+	for (size_t i = 0; i != num_vertices; i += num_quad_vertices) {
+		auto base = uint16_t(i);
+		for (uint16_t j : {0, 1, 2, 0, 2, 3}) {
+			indices.push_back(uint16_t(base + j));
+		}
+	}
+
+	ib = this->owner.factory->create_index_buffer(utki::make_span(indices)).to_shared_ptr();
+	return ib;
+}
+
+namespace {
+size_t hash_vertices(const std::vector<r4::vector2<float>>& v, size_t seed)
+{
+	auto h = std::hash<std::string_view>()(std::string_view(
+		reinterpret_cast<const char*>(v.data()), //
+		v.size() * sizeof(v.front())
+	));
+	// same as boost::hash_combine()
+	return seed ^ (h + 0x9e3779b9 + (seed << 6) + (seed >> 2)); // NOLINT(cppcoreguidelines-avoid-magic-numbers)
+}
+} // namespace
+
+utki::shared_ref<const vertex_array> draw_list::get_vertex_array(batch& b)
+{
+	auto hash = hash_vertices(b.tex_coords, hash_vertices(b.positions, 0));
+
+	auto matches = [&b](const cached_vertex_array& c) {
+		return c.positions == b.positions && c.tex_coords == b.tex_coords;
+	};
+
+	auto range = this->cur_frame_vertex_arrays.equal_range(hash);
+	for (auto i = range.first; i != range.second; ++i) {
+		if (matches(i->second)) {
+			return i->second.vao;
+		}
+	}
+
+	range = this->prev_frame_vertex_arrays.equal_range(hash);
+	for (auto i = range.first; i != range.second; ++i) {
+		if (matches(i->second)) {
+			auto vao = i->second.vao;
+			this->cur_frame_vertex_arrays.insert(this->prev_frame_vertex_arrays.extract(i));
+			return vao;
+		}
+	}
+
+	size_t num_quads = b.positions.size() / num_quad_vertices;
+	size_t capacity_log2 = 0;
+	while ((size_t(1) << capacity_log2) < num_quads) {
+		++capacity_log2;
+	}
+	size_t capacity = num_quad_vertices << capacity_log2;
+
+	auto& f = *this->owner.factory;
+
+	// pad with degenerate quads up to the capacity of the index buffer
+	auto pad = [capacity](std::vector<r4::vector2<float>> v) {
+		v.resize(capacity, v.back());
+		return v;
+	};
+
+	auto positions = pad(b.positions);
+	std::vector<utki::shared_ref<const vertex_buffer>> buffers = {f.create_vertex_buffer(utki::make_span(positions))};
+	if (b.pipe != pipeline::color_pos) {
+		auto tex_coords = pad(b.tex_coords);
+		buffers.push_back(f.create_vertex_buffer(utki::make_span(tex_coords)));
+	}
+
+	auto vao = f.create_vertex_array(
+		std::move(buffers),
+		utki::shared_ref<const index_buffer>(this->get_quad_indices(capacity_log2)),
+		vertex_array::mode::triangles
+	);
+
+	this->cur_frame_vertex_arrays.emplace(
+		hash,
+		cached_vertex_array{
+			.positions = std::move(b.positions),
+			.tex_coords = std::move(b.tex_coords),
+			.vao = vao
+		}
+	);
+
+	return vao;
+}
+
+void draw_list::render_batch(batch& b)
+{
+	ASSERT(!b.positions.empty())
+	ASSERT(b.positions.size() % num_quad_vertices == 0)
+	ASSERT(b.positions.size() <= max_batch_vertices)
+
+	auto vao = this->get_vertex_array(b);
+
+	// vertices are already transformed
+	auto identity = r4::matrix4<float>().set_identity();
+
+	auto& s = *this->owner.shader;
+
+	switch (b.pipe) {
+		case pipeline::color_pos:
+			s.color_pos->render(identity, vao.get(), b.color);
+			break;
+		case pipeline::pos_tex:
+			ASSERT(b.tex)
+			s.pos_tex->render(identity, vao.get(), *b.tex);
+			break;
+		case pipeline::color_pos_tex_alpha:
+			ASSERT(b.tex)
+			s.color_pos_tex_alpha->render(identity, vao.get(), b.color, *b.tex);
+			break;
+		case pipeline::enum_size:
+			ASSERT(false)
+			break;
+	}
+}
+
+void draw_list::flush()
+{
+	auto scissor = this->owner.get_scissor_state();
+
+	auto blending = this->owner.get_blending();
+
+	for (auto& b : this->batches) {
+		this->owner.set_scissor_state(b.scissor);
+
+		this->owner.enable_blend(b.blend.enabled);
+		if (b.blend.enabled) {
+			this->owner.set_blend_func(b.blend.src_color, b.blend.dst_color, b.blend.src_alpha, b.blend.dst_alpha);
+		}
+
+		this->render_batch(b);
+	}
+
+	this->batches.clear();
+
+	this->owner.set_scissor_state(scissor);
+
+	this->owner.set_blending(blending);
+}
+
+void draw_list::finish_frame()
+{
+	this->prev_frame_vertex_arrays = std::move(this->cur_frame_vertex_arrays);
+	this->cur_frame_vertex_arrays.clear();
+}
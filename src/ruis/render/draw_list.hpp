@@ -0,0 +1,179 @@
+/*
+ruis - GUI framework
+
+Copyright (C) 2012-2024  Ivan Gagis <igagis@gmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* ================ LICENSE END ================ */
+
+#pragma once
+
+#include <array>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include <r4/matrix.hpp>
+#include <r4/rectangle.hpp>
+#include <r4/vector.hpp>
+#include <utki/span.hpp>
+
+#include "renderer.hpp"
+
+namespace ruis::render {
+
+/**
+ * @brief Draw list of deferred rendering mode.
+ * The draw list records quads into a per-frame command buffer instead of rendering them right away.
+ * Recorded quads are merged into batches by shader, texture, color, blending and scissor state.
+ * A quad can be merged into one of the preceding batches only if it does not overlap any of the batches
+ * recorded after that one, so the resulting picture is the same as if the quads were rendered in the order
+ * they were recorded.
+ * When flushed, each batch is rendered as a single vertex array with one shader invocation
+ * via the renderer's shaders. Vertex arrays are reused across frames for batches with the same vertices.
+ */
+class draw_list
+{
+public:
+	/**
+	 * @brief Shader to render a batch with.
+	 */
+	enum class pipeline {
+		/**
+		 * @brief factory::shaders::color_pos.
+		 */
+		color_pos,
+
+		/**
+		 * @brief factory::shaders::pos_tex.
+		 */
+		pos_tex,
+
+		/**
+		 * @brief factory::shaders::color_pos_tex_alpha.
+		 */
+		color_pos_tex_alpha,
+
+		enum_size
+	};
+
+	using quad = renderer::quad;
+
+private:
+	renderer& owner;
+
+	struct batch {
+		pipeline pipe;
+		std::shared_ptr<const texture_2d> tex;
+		r4::vector4<float> color;
+		renderer::blending blend;
+		renderer::scissor scissor;
+
+		// bounding box of all the quads of the batch, in clipping coordinates
+		r4::rectangle<float> bounding_box;
+
+		std::vector<r4::vector2<float>> positions;
+		std::vector<r4::vector2<float>> tex_coords;
+	};
+
+	std::vector<batch> batches;
+
+	batch& get_batch(
+		pipeline pipe,
+		const std::shared_ptr<const texture_2d>& tex,
+		r4::vector4<float> color,
+		const r4::rectangle<float>& bounding_box
+	);
+
+	// Index buffers for rendering quads as pairs of triangles, i-th buffer is for 2^i quads.
+	// Batches are padded with degenerate quads up to the nearest power of two, so that
+	// the index buffers can be shared by all batches instead of being created for each batch.
+	std::vector<std::shared_ptr<const index_buffer>> quad_indices;
+
+	const std::shared_ptr<const index_buffer>& get_quad_indices(size_t capacity_log2);
+
+	struct cached_vertex_array {
+		std::vector<r4::vector2<float>> positions;
+		std::vector<r4::vector2<float>> tex_coords;
+		utki::shared_ref<const vertex_array> vao;
+	};
+
+	// Vertex arrays rendered during the current and the previous frames, by hash of the vertex data.
+	// Mostly the same batches are rendered from frame to frame, so the vertex arrays are reused
+	// instead of creating new buffers for each batch on each flush.
+	std::unordered_multimap<size_t, cached_vertex_array> cur_frame_vertex_arrays;
+	std::unordered_multimap<size_t, cached_vertex_array> prev_frame_vertex_arrays;
+
+	utki::shared_ref<const vertex_array> get_vertex_array(batch& b);
+
+	void render_batch(batch& b);
+
+public:
+	draw_list(renderer& owner) :
+		owner(owner)
+	{}
+
+	draw_list(const draw_list&) = delete;
+	draw_list& operator=(const draw_list&) = delete;
+
+	draw_list(draw_list&&) = delete;
+	draw_list& operator=(draw_list&&) = delete;
+
+	~draw_list() = default;
+
+	/**
+	 * @brief Record quads.
+	 * The quads are transformed by the given matrix right away, so the matrix is not needed to be kept alive.
+	 * Current scissor and blending states of the renderer are recorded along with the quads.
+	 * @param pipe - shader to render the quads with.
+	 * @param matrix - transformation matrix.
+	 * @param quads - quads to record.
+	 * @param color - color to render the quads with. Ignored for pipeline::pos_tex.
+	 * @param tex - texture to render the quads with. Ignored for pipeline::color_pos.
+	 */
+	void push(
+		pipeline pipe,
+		const r4::matrix4<float>& matrix,
+		utki::span<const quad> quads,
+		r4::vector4<float> color,
+		std::shared_ptr<const texture_2d> tex
+	);
+
+	/**
+	 * @brief Check if there are no recorded quads.
+	 * @return true if there are no recorded quads.
+	 * @return false otherwise.
+	 */
+	bool empty() const noexcept
+	{
+		return this->batches.empty();
+	}
+
+	/**
+	 * @brief Render all recorded quads and clear the draw list.
+	 * Scissor and blending states of the renderer are restored after rendering.
+	 */
+	void flush();
+
+	/**
+	 * @brief Finish frame.
+	 * Releases vertex arrays which were not rendered during the finished frame.
+	 * Called by renderer::finish_frame().
+	 */
+	void finish_frame();
+};
+
+} // namespace ruis::render
@@ -21,12 +21,241 @@ along with this program. If not, see <http://www.gnu.org/licenses/>.
 
 #include "renderer.hpp"
 
+#include <limits>
+
 #include <rasterimage/image_variant.hpp>
 
+#include "draw_list.hpp"
+
 using namespace ruis::render;
 
+struct renderer::counting {
+	class factory : public ruis::render::factory
+	{
+		std::unique_ptr<ruis::render::factory> f;
+		const renderer& owner;
+
+	public:
+		factory(std::unique_ptr<ruis::render::factory> f, const renderer& owner) :
+			f(std::move(f)),
+			owner(owner)
+		{}
+
+		utki::shared_ref<texture_2d> create_texture_2d(
+			rasterimage::format format,
+			rasterimage::dimensioned::dimensions_type dims,
+			texture_2d_parameters params
+		) override
+		{
+			this->owner.count(&stats::counters::textures_created);
+			return this->f->create_texture_2d(format, dims, params);
+		}
+
+		utki::shared_ref<texture_2d> create_texture_2d(
+			const rasterimage::image_variant& imvar,
+			texture_2d_parameters params
+		) override
+		{
+			this->owner.count(&stats::counters::textures_created);
+			return this->f->create_texture_2d(imvar, params);
+		}
+
+		utki::shared_ref<texture_2d> create_texture_2d(
+			rasterimage::image_variant&& imvar,
+			texture_2d_parameters params
+		) override
+		{
+			this->owner.count(&stats::counters::textures_created);
+			return this->f->create_texture_2d(std::move(imvar), params);
+		}
+
+		utki::shared_ref<texture_depth> create_texture_depth(rasterimage::dimensioned::dimensions_type dims) override
+		{
+			this->owner.count(&stats::counters::textures_created);
+			return this->f->create_texture_depth(dims);
+		}
+
+		utki::shared_ref<texture_cube> create_texture_cube(
+			rasterimage::image_variant&& positive_x,
+			rasterimage::image_variant&& negative_x,
+			rasterimage::image_variant&& positive_y,
+			rasterimage::image_variant&& negative_y,
+			rasterimage::image_variant&& positive_z,
+			rasterimage::image_variant&& negative_z
+		) override
+		{
+			this->owner.count(&stats::counters::textures_created);
+			return this->f->create_texture_cube(
+				std::move(positive_x),
+				std::move(negative_x),
+				std::move(positive_y),
+				std::move(negative_y),
+				std::move(positive_z),
+				std::move(negative_z)
+			);
+		}
+
+		utki::shared_ref<vertex_buffer> create_vertex_buffer(utki::span<const r4::vector4<float>> vertices) override
+		{
+			this->owner.count(&stats::counters::vertex_buffers_created);
+			return this->f->create_vertex_buffer(vertices);
+		}
+
+		utki::shared_ref<vertex_buffer> create_vertex_buffer(utki::span<const r4::vector3<float>> vertices) override
+		{
+			this->owner.count(&stats::counters::vertex_buffers_created);
+			return this->f->create_vertex_buffer(vertices);
+		}
+
+		utki::shared_ref<vertex_buffer> create_vertex_buffer(utki::span<const r4::vector2<float>> vertices) override
+		{
+			this->owner.count(&stats::counters::vertex_buffers_created);
+			return this->f->create_vertex_buffer(vertices);
+		}
+
+		utki::shared_ref<vertex_buffer> create_vertex_buffer(utki::span<const float> vertices) override
+		{
+			this->owner.count(&stats::counters::vertex_buffers_created);
+			return this->f->create_vertex_buffer(vertices);
+		}
+
+		utki::shared_ref<index_buffer> create_index_buffer(utki::span<const uint16_t> indices) override
+		{
+			this->owner.count(&stats::counters::index_buffers_created);
+			return this->f->create_index_buffer(indices);
+		}
+
+		utki::shared_ref<index_buffer> create_index_buffer(utki::span<const uint32_t> indices) override
+		{
+			this->owner.count(&stats::counters::index_buffers_created);
+			return this->f->create_index_buffer(indices);
+		}
+
+		utki::shared_ref<vertex_array> create_vertex_array(
+			std::vector<utki::shared_ref<const ruis::render::vertex_buffer>> buffers,
+			const utki::shared_ref<const ruis::render::index_buffer>& indices,
+			vertex_array::mode rendering_mode
+		) override
+		{
+			this->owner.count(&stats::counters::vertex_arrays_created);
+			return this->f->create_vertex_array(std::move(buffers), indices, rendering_mode);
+		}
+
+		std::unique_ptr<shaders> create_shaders() override;
+
+		utki::shared_ref<frame_buffer> create_framebuffer( //
+			std::shared_ptr<texture_2d> color,
+			std::shared_ptr<texture_depth> depth,
+			std::shared_ptr<texture_stencil> stencil
+		) override
+		{
+			this->owner.count(&stats::counters::framebuffers_created);
+			return this->f->create_framebuffer(std::move(color), std::move(depth), std::move(stencil));
+		}
+	};
+
+	class shader : public ruis::render::shader
+	{
+		std::unique_ptr<ruis::render::shader> s;
+		const renderer& owner;
+
+	public:
+		shader(std::unique_ptr<ruis::render::shader> s, const renderer& owner) :
+			s(std::move(s)),
+			owner(owner)
+		{}
+
+		void render(const r4::matrix4<float>& m, const vertex_array& va) const override
+		{
+			this->owner.count_draw_call(nullptr);
+			this->s->render(m, va);
+		}
+	};
+
+	class coloring_shader : public ruis::render::coloring_shader
+	{
+		std::unique_ptr<ruis::render::coloring_shader> s;
+		const renderer& owner;
+
+	public:
+		coloring_shader(std::unique_ptr<ruis::render::coloring_shader> s, const renderer& owner) :
+			s(std::move(s)),
+			owner(owner)
+		{}
+
+		using ruis::render::coloring_shader::render;
+
+		void render(const r4::matrix4<float>& m, const vertex_array& va, r4::vector4<float> color) const override
+		{
+			this->owner.count_draw_call(nullptr);
+			this->s->render(m, va, color);
+		}
+	};
+
+	class texturing_shader : public ruis::render::texturing_shader
+	{
+		std::unique_ptr<ruis::render::texturing_shader> s;
+		const renderer& owner;
+
+	public:
+		texturing_shader(std::unique_ptr<ruis::render::texturing_shader> s, const renderer& owner) :
+			s(std::move(s)),
+			owner(owner)
+		{}
+
+		void render(const r4::matrix4<float>& m, const vertex_array& va, const texture_2d& tex) const override
+		{
+			this->owner.count_draw_call(&tex);
+			this->s->render(m, va, tex);
+		}
+	};
+
+	class coloring_texturing_shader : public ruis::render::coloring_texturing_shader
+	{
+		std::unique_ptr<ruis::render::coloring_texturing_shader> s;
+		const renderer& owner;
+
+	public:
+		coloring_texturing_shader(std::unique_ptr<ruis::render::coloring_texturing_shader> s, const renderer& owner) :
+			s(std::move(s)),
+			owner(owner)
+		{}
+
+		void render(
+			const r4::matrix4<float>& m,
+			const vertex_array& va,
+			r4::vector4<float> color,
+			const texture_2d& tex
+		) const override
+		{
+			this->owner.count_draw_call(&tex);
+			this->s->render(m, va, color, tex);
+		}
+	};
+};
+
+std::unique_ptr<factory::shaders> renderer::counting::factory::create_shaders()
+{
+	auto s = this->f->create_shaders();
+
+	s->pos_tex = std::make_unique<counting::texturing_shader>(std::move(s->pos_tex), this->owner);
+	s->color_pos = std::make_unique<counting::coloring_shader>(std::move(s->color_pos), this->owner);
+	s->color_pos_lum = std::make_unique<counting::coloring_shader>(std::move(s->color_pos_lum), this->owner);
+	s->pos_clr = std::make_unique<counting::shader>(std::move(s->pos_clr), this->owner);
+	s->color_pos_tex = std::make_unique<counting::coloring_texturing_shader>( //
+		std::move(s->color_pos_tex),
+		this->owner
+	);
+	s->color_pos_tex_alpha = std::make_unique<counting::coloring_texturing_shader>( //
+		std::move(s->color_pos_tex_alpha),
+		this->owner
+	);
+
+	return s;
+}
+
 renderer::renderer(std::unique_ptr<ruis::render::factory> factory, const renderer::params& params) :
-	factory(std::move(factory)),
+	factory(std::make_unique<counting::factory>(std::move(factory), *this)),
 	shader(this->factory->create_shaders()),
 	empty_vertex_array(this->factory->create_vertex_array(
 		{
@@ -70,22 +299,263 @@ renderer::renderer(std::unique_ptr<ruis::render::factory> factory, const rendere
 		}(),
 		{}
 	)),
-	max_texture_size(params.max_texture_size), initial_matrix(params.initial_matrix)
+	max_texture_size(params.max_texture_size), initial_matrix(params.initial_matrix),
+	draw_list(std::make_unique<render::draw_list>(*this))
 {}
 
+renderer::~renderer() = default;
+
+void renderer::count_draw_call(const texture_2d* tex) const
+{
+	auto& s = this->cur_stats;
+
+	this->count(&stats::counters::draw_calls);
+
+	if (tex && tex != s.last_texture) {
+		s.last_texture = tex;
+		this->count(&stats::counters::texture_binds);
+	}
+
+	// use tracked scissor state to avoid querying the rendering context on each draw call
+	const auto& scissor = this->get_scissor_state();
+	if (!(scissor == renderer::scissor{.enabled = s.last_scissor_enabled, .rect = s.last_scissor})) {
+		s.last_scissor_enabled = scissor.enabled;
+		s.last_scissor = scissor.rect;
+		this->count(&stats::counters::scissor_changes);
+	}
+}
+
+void renderer::finish_frame()
+{
+	this->last_frame_stats = this->cur_stats;
+
+	// the frame statistics are not updated anymore, so do not keep pointer to the widget class counters
+	this->last_frame_stats.set_widget_class(nullptr);
+
+	this->cur_stats.clear();
+
+	this->draw_list->finish_frame();
+}
+
 void renderer::set_framebuffer(std::shared_ptr<frame_buffer> fb)
 {
+	this->count(&stats::counters::framebuffer_switches);
+
+	// quads recorded so far belong to the current frame buffer
+	this->flush();
+
 	this->set_framebuffer_internal(fb.get());
 	this->cur_fb = std::move(fb);
 }
 
+void renderer::set_blending(const blending& b)
+{
+	if (!(b == this->cur_blending)) {
+		this->count(&stats::counters::blending_changes);
+	}
+
+	this->cur_blending = b;
+
+	this->enable_blend(b.enabled);
+	if (b.enabled) {
+		this->set_blend_func(b.src_color, b.dst_color, b.src_alpha, b.dst_alpha);
+	}
+}
+
+void renderer::set_scissor_state(const scissor& s)
+{
+	if (s == this->cur_scissor) {
+		return;
+	}
+
+	if (s.enabled) {
+		this->set_scissor(s.rect);
+	}
+	if (s.enabled != this->cur_scissor.enabled) {
+		this->enable_scissor(s.enabled);
+	}
+
+	this->cur_scissor = s;
+}
+
 void renderer::set_simple_alpha_blending()
 {
-	this->enable_blend(true);
-	this->set_blend_func(
-		renderer::blend_factor::src_alpha,
-		renderer::blend_factor::one_minus_src_alpha,
-		renderer::blend_factor::one,
-		renderer::blend_factor::one_minus_src_alpha
+	this->set_blending({
+		.enabled = true,
+		.src_color = renderer::blend_factor::src_alpha,
+		.dst_color = renderer::blend_factor::one_minus_src_alpha,
+		.src_alpha = renderer::blend_factor::one,
+		.dst_alpha = renderer::blend_factor::one_minus_src_alpha
+	});
+}
+
+void renderer::set_deferred(bool enable)
+{
+	if (!enable) {
+		this->flush();
+	}
+	this->deferred = enable;
+}
+
+void renderer::flush() const
+{
+	if (this->draw_list->empty()) {
+		return;
+	}
+	this->draw_list->flush();
+}
+
+namespace {
+// same vertices order as in renderer::quad_01_vbo
+const renderer::quad quad_01 = {
+	{{{0, 0}, {0, 0}}, //
+	 {{0, 1}, {0, 1}},
+	 {{1, 1}, {1, 1}},
+	 {{1, 0}, {1, 0}}}
+};
+} // namespace
+
+void renderer::render_quad(const r4::matrix4<float>& matrix, r4::vector4<float> color) const
+{
+	this->count(&stats::counters::quads);
+
+	if (this->deferred) {
+		this->draw_list->push(
+			render::draw_list::pipeline::color_pos,
+			matrix,
+			utki::make_span(&quad_01, 1),
+			color,
+			nullptr
+		);
+		return;
+	}
+	this->shader->color_pos->render(matrix, this->pos_quad_01_vao.get(), color);
+}
+
+void renderer::render_quad(const r4::matrix4<float>& matrix, const utki::shared_ref<const texture_2d>& tex) const
+{
+	this->count(&stats::counters::quads);
+
+	if (this->deferred) {
+		this->draw_list->push(
+			render::draw_list::pipeline::pos_tex,
+			matrix,
+			utki::make_span(&quad_01, 1),
+			{1, 1, 1, 1},
+			tex.to_shared_ptr()
+		);
+		return;
+	}
+	this->shader->pos_tex->render(matrix, this->pos_tex_quad_01_vao.get(), tex.get());
+}
+
+void renderer::render_quad(
+	const r4::matrix4<float>& matrix,
+	const utki::shared_ref<const texture_2d>& tex,
+	const r4::rectangle<float>& tex_rect
+) const
+{
+	this->count(&stats::counters::quads);
+
+	auto q = quad_01;
+	for (auto& v : q) {
+		v.tex_coord = tex_rect.p + v.tex_coord.comp_mul(tex_rect.d);
+	}
+
+	this->draw_list->push(
+		render::draw_list::pipeline::pos_tex,
+		matrix,
+		utki::make_span(&q, 1),
+		{1, 1, 1, 1},
+		tex.to_shared_ptr()
+	);
+
+	if (!this->deferred) {
+		// there is no vertex array for arbitrary texture coordinates, so render it through the draw list
+		this->draw_list->flush();
+	}
+}
+
+void renderer::render_alpha_quads(
+	const r4::matrix4<float>& matrix,
+	utki::span<const quad> quads,
+	r4::vector4<float> color,
+	const utki::shared_ref<const texture_2d>& tex
+) const
+{
+	this->count(&stats::counters::quads, quads.size());
+
+	this->draw_list->push(
+		render::draw_list::pipeline::color_pos_tex_alpha,
+		matrix,
+		quads,
+		color,
+		tex.to_shared_ptr()
 	);
+
+	if (!this->deferred) {
+		// the quads are rendered as one vertex array anyway, so in immediate mode just flush the draw list right away
+		this->draw_list->flush();
+	}
+}
+
+namespace {
+template <typename index_type>
+std::vector<index_type> make_quad_indices(size_t num_quads)
+{
+	// each quad is rendered as two triangles
+	std::vector<index_type> indices;
+	indices.reserve(num_quads * 6);
+	for (size_t i = 0; i != num_quads; ++i) {
+		auto base = index_type(i * std::tuple_size_v<renderer::quad>);
+		for (index_type j : {0, 1, 2, 0, 2, 3}) {
+			indices.push_back(index_type(base + j));
+		}
+	}
+	return indices;
+}
+} // namespace
+
+utki::shared_ref<const vertex_array> renderer::make_quads_vertex_array(utki::span<const quad> quads) const
+{
+	std::vector<r4::vector2<float>> positions;
+	std::vector<r4::vector2<float>> tex_coords;
+	positions.reserve(quads.size() * std::tuple_size_v<quad>);
+	tex_coords.reserve(positions.capacity());
+
+	for (const auto& q : quads) {
+		for (const auto& v : q) {
+			positions.push_back(v.pos);
+			tex_coords.push_back(v.tex_coord);
+		}
+	}
+
+	auto indices = [&]() -> utki::shared_ref<const index_buffer> {
+		if (positions.size() <= size_t(std::numeric_limits<uint16_t>::max()) + 1) {
+			auto i = make_quad_indices<uint16_t>(quads.size());
+			return this->factory->create_index_buffer(utki::make_span(i));
+		}
+		auto i = make_quad_indices<uint32_t>(quads.size());
+		return this->factory->create_index_buffer(utki::make_span(i));
+	}();
+
+	return this->factory->create_vertex_array(
+		{this->factory->create_vertex_buffer(utki::make_span(positions)),
+		 this->factory->create_vertex_buffer(utki::make_span(tex_coords))},
+		indices,
+		vertex_array::mode::triangles
+	);
+}
+
+void renderer::render_alpha_quads(
+	const r4::matrix4<float>& matrix,
+	const vertex_array& quads,
+	r4::vector4<float> color,
+	const texture_2d& tex
+) const
+{
+	// quads recorded so far have to be rendered before
+	this->flush();
+
+	this->shader->color_pos_tex_alpha->render(matrix, quads, color, tex);
 }
@@ -21,12 +21,32 @@ along with this program. If not, see <http://www.gnu.org/licenses/>.
 
 #pragma once
 
+#include <array>
+#include <memory>
+
 #include "factory.hpp"
+#include "stats.hpp"
 
 namespace ruis::render {
 
+class draw_list;
+
 class renderer
 {
+	// wrappers of the factory and shaders created by the backend, which count statistics
+	struct counting;
+
+	// declared before the factory, because the factory is used during construction
+	mutable render::stats cur_stats;
+	render::stats last_frame_stats;
+
+	void count(size_t stats::counters::*counter, size_t num = 1) const noexcept
+	{
+		this->cur_stats.count(counter, num);
+	}
+
+	void count_draw_call(const texture_2d* tex) const;
+
 public:
 	const std::unique_ptr<ruis::render::factory> factory;
 
@@ -57,7 +77,7 @@ private:
 	std::shared_ptr<frame_buffer> cur_fb;
 
 public:
-	virtual ~renderer() = default;
+	virtual ~renderer();
 
 	renderer(const renderer&) = delete;
 	renderer& operator=(const renderer&) = delete;
@@ -150,6 +170,48 @@ public:
 	 */
 	virtual void set_scissor(r4::rectangle<uint32_t> r) = 0;
 
+	/**
+	 * @brief Scissor state.
+	 */
+	struct scissor {
+		bool enabled = false;
+		r4::rectangle<uint32_t> rect{0, 0};
+
+		bool operator==(const scissor& s) const noexcept
+		{
+			if (this->enabled != s.enabled) {
+				return false;
+			}
+			if (!this->enabled) {
+				return true;
+			}
+			return this->rect.p == s.rect.p && this->rect.d == s.rect.d;
+		}
+	};
+
+private:
+	scissor cur_scissor;
+
+public:
+	/**
+	 * @brief Set scissor state.
+	 * Unlike calling enable_scissor() and set_scissor() directly, this function keeps track of the
+	 * current scissor state, so it can be read back without querying the rendering context.
+	 * The tracked state is recorded along with the quads in deferred rendering mode.
+	 * The rendering context is only updated if the state actually changes.
+	 * @param s - scissor state to set.
+	 */
+	void set_scissor_state(const scissor& s);
+
+	/**
+	 * @brief Get current scissor state.
+	 * @return Scissor state last set with set_scissor_state().
+	 */
+	const scissor& get_scissor_state() const noexcept
+	{
+		return this->cur_scissor;
+	}
+
 	/**
 	 * @brief Get current rendering viewport within application window.
 	 * Get the rendering viewport rectangle in application window coordinates.
@@ -174,6 +236,33 @@ public:
 	 */
 	virtual void set_viewport(r4::rectangle<uint32_t> r) = 0;
 
+private:
+	r4::rectangle<float> cull_rect = {{-1, -1}, {2, 2}};
+
+public:
+	/**
+	 * @brief Get culling rectangle.
+	 * The culling rectangle is the area in normalized device coordinates where the rendering is visible,
+	 * i.e. viewport intersected with all active clipping areas. Unlike scissor rectangle,
+	 * it is renderer-agnostic. Rendering of widgets which do not intersect the culling rectangle is skipped.
+	 * By default, the culling rectangle covers the whole viewport.
+	 * @return Current culling rectangle.
+	 */
+	const r4::rectangle<float>& get_cull_rect() const noexcept
+	{
+		return this->cull_rect;
+	}
+
+	/**
+	 * @brief Set culling rectangle.
+	 * See get_cull_rect() for details.
+	 * @param r - new culling rectangle in normalized device coordinates.
+	 */
+	void set_cull_rect(const r4::rectangle<float>& r) noexcept
+	{
+		this->cull_rect = r;
+	}
+
 	virtual void enable_blend(bool enable) = 0;
 
 	/**
@@ -209,6 +298,53 @@ public:
 		blend_factor dst_alpha
 	) = 0;
 
+	/**
+	 * @brief Blending state.
+	 */
+	struct blending {
+		bool enabled = false;
+		blend_factor src_color = blend_factor::one;
+		blend_factor dst_color = blend_factor::zero;
+		blend_factor src_alpha = blend_factor::one;
+		blend_factor dst_alpha = blend_factor::zero;
+
+		bool operator==(const blending& b) const noexcept
+		{
+			if (this->enabled != b.enabled) {
+				return false;
+			}
+			if (!this->enabled) {
+				return true;
+			}
+			return //
+				this->src_color == b.src_color && //
+				this->dst_color == b.dst_color && //
+				this->src_alpha == b.src_alpha && //
+				this->dst_alpha == b.dst_alpha;
+		}
+	};
+
+private:
+	blending cur_blending;
+
+public:
+	/**
+	 * @brief Set blending state.
+	 * Unlike calling enable_blend() and set_blend_func() directly, this function keeps track of the
+	 * current blending state. The tracked state is recorded along with the quads in deferred rendering mode.
+	 * @param b - blending state to set.
+	 */
+	void set_blending(const blending& b);
+
+	/**
+	 * @brief Get current blending state.
+	 * @return Blending state last set with set_blending().
+	 */
+	const blending& get_blending() const noexcept
+	{
+		return this->cur_blending;
+	}
+
 	/**
 	 * @brief Set simple alpha blending.
 	 * Enables and set simple alpha blending on the rendering context.
@@ -231,6 +367,170 @@ public:
 	 */
 	virtual void enable_depth(bool enable) = 0;
 
+	/**
+	 * @brief Vertex of a quad.
+	 */
+	struct quad_vertex {
+		r4::vector2<float> pos;
+		r4::vector2<float> tex_coord;
+	};
+
+	/**
+	 * @brief Quad given as four vertices in triangle fan order.
+	 */
+	using quad = std::array<quad_vertex, 4>;
+
+private:
+	const std::unique_ptr<render::draw_list> draw_list;
+
+	bool deferred = false;
+
+public:
+	/**
+	 * @brief Enable/disable deferred rendering mode.
+	 * In deferred rendering mode the render_*() functions of the renderer do not render right away,
+	 * but record the quads to the draw list, which merges them into a few big batches.
+	 * The draw list is flushed when the frame buffer is changed, when flush() is called
+	 * and at the end of gui::render().
+	 * Rendering done by calling the shaders directly has to be preceded by a call to flush().
+	 * Disabling the deferred rendering mode flushes the draw list.
+	 * @param enable - whether to enable (true) or disable (false) the deferred rendering mode.
+	 */
+	void set_deferred(bool enable);
+
+	/**
+	 * @brief Check if deferred rendering mode is enabled.
+	 * @return true if deferred rendering mode is enabled.
+	 * @return false otherwise.
+	 */
+	bool is_deferred() const noexcept
+	{
+		return this->deferred;
+	}
+
+	/**
+	 * @brief Render all the quads recorded in deferred rendering mode.
+	 * Does nothing if there are no recorded quads.
+	 */
+	void flush() const;
+
+	/**
+	 * @brief Render a solid color quad.
+	 * Renders the (0, 0) - (1, 1) quad using color_pos shader.
+	 * @param matrix - transformation matrix.
+	 * @param color - color of the quad.
+	 */
+	void render_quad(const r4::matrix4<float>& matrix, r4::vector4<float> color) const;
+
+	/**
+	 * @brief Render a solid color quad.
+	 * @param matrix - transformation matrix.
+	 * @param color - color of the quad in 32 bit ABGR format.
+	 */
+	void render_quad(const r4::matrix4<float>& matrix, uint32_t color) const
+	{
+		this->render_quad(matrix, rasterimage::to_float(rasterimage::from_32bit_pixel(color)));
+	}
+
+	/**
+	 * @brief Render a textured quad.
+	 * Renders the (0, 0) - (1, 1) quad using pos_tex shader,
+	 * texture coordinates are same as vertex coordinates.
+	 * @param matrix - transformation matrix.
+	 * @param tex - texture of the quad.
+	 */
+	void render_quad(const r4::matrix4<float>& matrix, const utki::shared_ref<const texture_2d>& tex) const;
+
+	/**
+	 * @brief Render a part of texture on a quad.
+	 * Renders the (0, 0) - (1, 1) quad using pos_tex shader,
+	 * texture coordinates are mapped to the given rectangle of the texture.
+	 * Used for rendering images packed to texture atlases.
+	 * @param matrix - transformation matrix.
+	 * @param tex - texture of the quad.
+	 * @param tex_rect - rectangle of the texture to render, in normalized texture coordinates, Y axis down.
+	 */
+	void render_quad(
+		const r4::matrix4<float>& matrix,
+		const utki::shared_ref<const texture_2d>& tex,
+		const r4::rectangle<float>& tex_rect
+	) const;
+
+	/**
+	 * @brief Render quads with alpha texture.
+	 * Renders quads using color_pos_tex_alpha shader. Used for rendering glyphs.
+	 * @param matrix - transformation matrix.
+	 * @param quads - vertices of the quads, four vertices per quad, in triangle fan order.
+	 * @param color - color of the quads.
+	 * @param tex - alpha texture of the quads.
+	 */
+	void render_alpha_quads(
+		const r4::matrix4<float>& matrix,
+		utki::span<const quad> quads,
+		r4::vector4<float> color,
+		const utki::shared_ref<const texture_2d>& tex
+	) const;
+
+	/**
+	 * @brief Create vertex array of quads.
+	 * The vertex array can be rendered many times without uploading the quads to the rendering context again.
+	 * @param quads - vertices of the quads, four vertices per quad, in triangle fan order.
+	 * @return Vertex array of the quads with positions and texture coordinates.
+	 */
+	utki::shared_ref<const vertex_array> make_quads_vertex_array(utki::span<const quad> quads) const;
+
+	/**
+	 * @brief Render vertex array of quads with alpha texture.
+	 * Renders vertex array created with make_quads_vertex_array() using color_pos_tex_alpha shader.
+	 * The vertex array is rendered right away, in deferred rendering mode the quads recorded so far are flushed first.
+	 * @param matrix - transformation matrix.
+	 * @param quads - vertex array of the quads.
+	 * @param color - color of the quads.
+	 * @param tex - alpha texture of the quads.
+	 */
+	void render_alpha_quads(
+		const r4::matrix4<float>& matrix,
+		const vertex_array& quads,
+		r4::vector4<float> color,
+		const texture_2d& tex
+	) const;
+
+	/**
+	 * @brief Get statistics collected since the last finished frame.
+	 * @return Current statistics.
+	 */
+	const render::stats& get_stats() const noexcept
+	{
+		return this->cur_stats;
+	}
+
+	/**
+	 * @brief Get statistics collected since the last finished frame.
+	 * Non-const version, for setting the widget class to attribute the counters to.
+	 * @return Current statistics.
+	 */
+	render::stats& get_stats() noexcept
+	{
+		return this->cur_stats;
+	}
+
+	/**
+	 * @brief Get statistics of the last finished frame.
+	 * @return Statistics of the last finished frame.
+	 */
+	const render::stats& get_frame_stats() const noexcept
+	{
+		return this->last_frame_stats;
+	}
+
+	/**
+	 * @brief Finish frame statistics.
+	 * Current statistics become the last frame statistics and current statistics are reset.
+	 * Vertex arrays cached by the draw list which were not rendered during the frame are released.
+	 * Called by gui::render() after rendering a frame.
+	 */
+	void finish_frame();
+
 protected:
 	virtual void set_framebuffer_internal(frame_buffer* fb) = 0;
 };
@@ -0,0 +1,72 @@
+/*
+ruis - GUI framework
+
+Copyright (C) 2012-2024  Ivan Gagis <igagis@gmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* ================ LICENSE END ================ */
+
+#include "device.hpp"
+
+#include "texture_depth.hpp"
+
+using namespace ruis::render::software;
+
+device::device(r4::vector2<uint32_t> dims, unsigned num_threads) :
+	// the calling thread also rasterizes, so one worker thread less is needed
+	pool(num_threads > 1 ? std::make_unique<worker_pool>(num_threads - 1) : nullptr),
+	rast(this->pool.get())
+{
+	this->resize(dims);
+}
+
+void device::resize(r4::vector2<uint32_t> dims)
+{
+	this->screen = texture_2d::image_type(dims);
+	for (uint32_t y = 0; y != dims.y(); ++y) {
+		auto line = this->screen[y];
+		std::fill(line.begin(), line.end(), texture_2d::image_type::pixel_type{0, 0, 0, 0});
+	}
+
+	this->screen_depth.assign(size_t(dims.x()) * size_t(dims.y()), 1);
+}
+
+rasterizer::target device::get_target()
+{
+	if (!this->fb) {
+		return {.color = &this->screen, .depth = &this->screen_depth};
+	}
+
+	rasterizer::target ret;
+
+	ASSERT(this->fb->color)
+	ret.color = &static_cast<texture_2d&>(*this->fb->color).image;
+
+	if (this->fb->depth) {
+		ret.depth = &static_cast<texture_depth&>(*this->fb->depth).data;
+	}
+
+	return ret;
+}
+
+void device::draw(
+	const r4::matrix4<float>& matrix, //
+	const ruis::render::vertex_array& va,
+	const rasterizer::program& p
+)
+{
+	this->rast.draw(this->state, this->get_target(), matrix, va, p);
+}
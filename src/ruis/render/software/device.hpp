@@ -0,0 +1,73 @@
+/*
+ruis - GUI framework
+
+Copyright (C) 2012-2024  Ivan Gagis <igagis@gmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* ================ LICENSE END ================ */
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "../../util/worker_pool.hpp"
+#include "../frame_buffer.hpp"
+
+#include "rasterizer.hpp"
+#include "texture_2d.hpp"
+
+namespace ruis::render::software {
+
+/**
+ * @brief Rendering device.
+ * Holds the rendering state and the screen buffer.
+ * Shared by the renderer and the shaders.
+ */
+class device
+{
+	std::unique_ptr<worker_pool> pool;
+
+	software::rasterizer rast;
+
+public:
+	rasterizer::state state;
+
+	texture_2d::image_type screen;
+	std::vector<float> screen_depth;
+
+	// current frame buffer, nullptr means screen
+	ruis::render::frame_buffer* fb = nullptr;
+
+	/**
+	 * @brief Create rendering device.
+	 * @param dims - dimensions of the screen buffer.
+	 * @param num_threads - number of threads to rasterize with.
+	 */
+	device(r4::vector2<uint32_t> dims, unsigned num_threads);
+
+	void resize(r4::vector2<uint32_t> dims);
+
+	rasterizer::target get_target();
+
+	void draw(
+		const r4::matrix4<float>& matrix, //
+		const ruis::render::vertex_array& va,
+		const rasterizer::program& p
+	);
+};
+
+} // namespace ruis::render::software
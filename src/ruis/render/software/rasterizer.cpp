@@ -0,0 +1,528 @@
+/*
+ruis - GUI framework
+
+Copyright (C) 2012-2024  Ivan Gagis <igagis@gmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* ================ LICENSE END ================ */
+
+#include "rasterizer.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include <utki/debug.hpp>
+#include <utki/span.hpp>
+
+#include "index_buffer.hpp"
+#include "vertex_buffer.hpp"
+
+using namespace ruis::render::software;
+
+namespace {
+constexpr float half = 0.5f;
+constexpr float max_channel_value = 0xff;
+
+// depth and varyings
+constexpr size_t num_attributes = 5;
+using attributes = std::array<float, num_attributes>;
+
+r4::vector4<float> to_float(const texture_2d::image_type::pixel_type& p) noexcept
+{
+	return r4::vector4<float>{float(p[0]), float(p[1]), float(p[2]), float(p[3])} / max_channel_value;
+}
+
+texture_2d::image_type::pixel_type to_pixel(const r4::vector4<float>& c) noexcept
+{
+	auto conv = [](float v) {
+		return uint8_t(std::clamp(v, 0.0f, 1.0f) * max_channel_value + half);
+	};
+	return {conv(c[0]), conv(c[1]), conv(c[2]), conv(c[3])};
+}
+
+r4::vector4<float> blend_factor_value(
+	ruis::render::renderer::blend_factor f, //
+	const r4::vector4<float>& src,
+	const r4::vector4<float>& dst
+) noexcept
+{
+	using ruis::render::renderer;
+
+	switch (f) {
+		case renderer::blend_factor::one:
+			return {1, 1, 1, 1};
+		case renderer::blend_factor::src_color:
+			return src;
+		case renderer::blend_factor::one_minus_src_color:
+			return r4::vector4<float>{1, 1, 1, 1} - src;
+		case renderer::blend_factor::dst_color:
+			return dst;
+		case renderer::blend_factor::one_minus_dst_color:
+			return r4::vector4<float>{1, 1, 1, 1} - dst;
+		case renderer::blend_factor::src_alpha:
+			return r4::vector4<float>(src.w());
+		case renderer::blend_factor::one_minus_src_alpha:
+			return r4::vector4<float>(1 - src.w());
+		case renderer::blend_factor::dst_alpha:
+			return r4::vector4<float>(dst.w());
+		case renderer::blend_factor::one_minus_dst_alpha:
+			return r4::vector4<float>(1 - dst.w());
+		case renderer::blend_factor::src_alpha_saturate:
+			{
+				auto v = std::min(src.w(), 1 - dst.w());
+				return {v, v, v, 1};
+			}
+		// there is no API to set the constant blend color, so it is always (0, 0, 0, 0)
+		case renderer::blend_factor::one_minus_constant_color:
+		case renderer::blend_factor::one_minus_constant_alpha:
+			return {1, 1, 1, 1};
+		case renderer::blend_factor::zero:
+		case renderer::blend_factor::constant_color:
+		case renderer::blend_factor::constant_alpha:
+		default:
+			return {0, 0, 0, 0};
+	}
+}
+
+bool is_simple_alpha_blending(const ruis::render::renderer::blending& b) noexcept
+{
+	using ruis::render::renderer;
+	return b.src_color == renderer::blend_factor::src_alpha &&
+		b.dst_color == renderer::blend_factor::one_minus_src_alpha &&
+		b.src_alpha == renderer::blend_factor::one && b.dst_alpha == renderer::blend_factor::one_minus_src_alpha;
+}
+
+// compute colors of the span pixels
+void shade(
+	const rasterizer::program& p, //
+	const attributes& start,
+	const attributes& step,
+	utki::span<r4::vector4<float>> out
+)
+{
+	using type = rasterizer::program::type;
+
+	auto uv = [&](size_t i) {
+		auto fi = float(i);
+		return r4::vector2<float>{start[1] + step[1] * fi, start[2] + step[2] * fi};
+	};
+
+	switch (p.t) {
+		case type::color:
+			std::fill(out.begin(), out.end(), p.color);
+			break;
+		case type::color_lum:
+			for (size_t i = 0; i != out.size(); ++i) {
+				float lum = start[1] + step[1] * float(i);
+				out[i] = {p.color.x(), p.color.y(), p.color.z(), p.color.w() * lum};
+			}
+			break;
+		case type::vertex_color:
+			for (size_t i = 0; i != out.size(); ++i) {
+				auto fi = float(i);
+				out[i] = {
+					start[1] + step[1] * fi, //
+					start[2] + step[2] * fi,
+					start[3] + step[3] * fi,
+					start[4] + step[4] * fi
+				};
+			}
+			break;
+		case type::texture:
+			ASSERT(p.tex)
+			for (size_t i = 0; i != out.size(); ++i) {
+				out[i] = p.tex->sample(uv(i));
+			}
+			break;
+		case type::color_texture:
+			ASSERT(p.tex)
+			for (size_t i = 0; i != out.size(); ++i) {
+				out[i] = p.color.comp_mul(p.tex->sample(uv(i)));
+			}
+			break;
+		case type::color_texture_alpha:
+			ASSERT(p.tex)
+			for (size_t i = 0; i != out.size(); ++i) {
+				auto t = p.tex->sample(uv(i));
+				out[i] = {p.color.x(), p.color.y(), p.color.z(), p.color.w() * (p.tex->grey ? t.x() : t.w())};
+			}
+			break;
+	}
+}
+
+// render span of pixels of a row, the pixels are [x_begin, x_end)
+void fill_span(
+	const rasterizer::state& s,
+	const rasterizer::target& t,
+	const rasterizer::program& p,
+	int y,
+	int x_begin,
+	int x_end,
+	const attributes& start,
+	const attributes& step
+)
+{
+	ASSERT(x_begin < x_end)
+
+	auto n = size_t(x_end - x_begin);
+
+	thread_local std::vector<r4::vector4<float>> src;
+	src.resize(n);
+
+	thread_local std::vector<uint8_t> passed;
+	passed.assign(n, 1);
+
+	shade(p, start, step, utki::make_span(src));
+
+	auto& image = *t.color;
+	auto width = size_t(image.dims().x());
+
+	if (s.depth_test && t.depth) {
+		float* depth_row = &(*t.depth)[size_t(y) * width + size_t(x_begin)];
+		for (size_t i = 0; i != n; ++i) {
+			float z = start[0] + step[0] * float(i);
+			if (z < depth_row[i]) {
+				depth_row[i] = z;
+			} else {
+				passed[i] = 0;
+			}
+		}
+	}
+
+	auto row = image[y];
+	auto* dst = &row[size_t(x_begin)];
+
+	const auto& b = s.blending;
+
+	if (!b.enabled) {
+		for (size_t i = 0; i != n; ++i) {
+			if (passed[i]) {
+				dst[i] = to_pixel(src[i]);
+			}
+		}
+	} else if (is_simple_alpha_blending(b)) {
+		for (size_t i = 0; i != n; ++i) {
+			if (!passed[i]) {
+				continue;
+			}
+			auto d = to_float(dst[i]);
+			const auto& c = src[i];
+			float a = c.w();
+			float ia = 1 - a;
+			dst[i] = to_pixel({
+				c.x() * a + d.x() * ia, //
+				c.y() * a + d.y() * ia,
+				c.z() * a + d.z() * ia,
+				a + d.w() * ia
+			});
+		}
+	} else {
+		for (size_t i = 0; i != n; ++i) {
+			if (!passed[i]) {
+				continue;
+			}
+			auto d = to_float(dst[i]);
+			const auto& c = src[i];
+
+			auto sc = blend_factor_value(b.src_color, c, d);
+			auto dc = blend_factor_value(b.dst_color, c, d);
+			auto sa = blend_factor_value(b.src_alpha, c, d);
+			auto da = blend_factor_value(b.dst_alpha, c, d);
+
+			dst[i] = to_pixel({
+				c.x() * sc.x() + d.x() * dc.x(), //
+				c.y() * sc.y() + d.y() * dc.y(),
+				c.z() * sc.z() + d.z() * dc.z(),
+				c.w() * sa.w() + d.w() * da.w()
+			});
+		}
+	}
+}
+} // namespace
+
+void rasterizer::set_up_triangle(const vertex& v0, const vertex& v1, const vertex& v2, const box& clip)
+{
+	std::array<const vertex*, 3> v = {&v0, &v1, &v2};
+
+	triangle tr{};
+
+	std::array<float, 3> dists{};
+
+	for (size_t i = 0; i != v.size(); ++i) {
+		const auto& p = v[(i + 1) % v.size()]->pos;
+		const auto& q = v[(i + 2) % v.size()]->pos;
+
+		edge e{
+			.a = p.y() - q.y(), //
+			.b = q.x() - p.x(),
+			.c = p.x() * q.y() - p.y() * q.x()
+		};
+
+		float d = e.a * v[i]->pos.x() + e.b * v[i]->pos.y() + e.c;
+		if (d == 0) {
+			// degenerate triangle
+			return;
+		}
+		if (d < 0) {
+			e = {-e.a, -e.b, -e.c};
+			d = -d;
+		}
+
+		tr.edges[i] = e;
+		dists[i] = d;
+	}
+
+	// attribute value at a point is a sum of vertex values weighted by barycentric coordinates,
+	// barycentric coordinate of a vertex is the normalized edge function of the opposite edge
+	for (size_t j = 0; j != tr.planes.size(); ++j) {
+		auto& pl = tr.planes[j];
+		pl = {0, 0, 0};
+		for (size_t i = 0; i != v.size(); ++i) {
+			float f = j == 0 ? v[i]->pos.z() : v[i]->varyings[j - 1];
+			float w = f / dists[i];
+			pl.base += tr.edges[i].c * w;
+			pl.dx += tr.edges[i].a * w;
+			pl.dy += tr.edges[i].b * w;
+		}
+	}
+
+	using std::max;
+	using std::min;
+
+	tr.bounding_box = {
+		.x1 = max(clip.x1, int(std::floor(min({v0.pos.x(), v1.pos.x(), v2.pos.x()})))),
+		.y1 = max(clip.y1, int(std::floor(min({v0.pos.y(), v1.pos.y(), v2.pos.y()})))),
+		.x2 = min(clip.x2, int(std::ceil(max({v0.pos.x(), v1.pos.x(), v2.pos.x()})))),
+		.y2 = min(clip.y2, int(std::ceil(max({v0.pos.y(), v1.pos.y(), v2.pos.y()}))))
+	};
+
+	if (tr.bounding_box.x1 >= tr.bounding_box.x2 || tr.bounding_box.y1 >= tr.bounding_box.y2) {
+		return;
+	}
+
+	this->triangles.push_back(tr);
+}
+
+void rasterizer::rasterize(
+	const state& s,
+	const target& t,
+	const program& p,
+	const box& clip,
+	int y_begin,
+	int y_end
+) const
+{
+	for (const auto& tr : this->triangles) {
+		int ys = std::max(tr.bounding_box.y1, y_begin);
+		int ye = std::min(tr.bounding_box.y2, y_end);
+
+		for (int y = ys; y < ye; ++y) {
+			float cy = float(y) + half;
+
+			int x_begin = tr.bounding_box.x1;
+			int x_end = tr.bounding_box.x2;
+
+			bool empty = false;
+			for (const auto& e : tr.edges) {
+				float r = e.b * cy + e.c;
+				if (e.a == 0) {
+					// horizontal edge, pixel centers lying on top edges are inside
+					if (r < 0 || (r == 0 && e.b < 0)) {
+						empty = true;
+						break;
+					}
+					continue;
+				}
+
+				// pixel centers lying on left edges are inside, on right edges are outside
+				int boundary = int(std::ceil(-r / e.a - half));
+				if (e.a > 0) {
+					x_begin = std::max(x_begin, boundary);
+				} else {
+					x_end = std::min(x_end, boundary);
+				}
+			}
+
+			if (empty || x_begin >= x_end) {
+				continue;
+			}
+
+			attributes start{};
+			attributes step{};
+			float cx = float(x_begin) + half;
+			for (size_t j = 0; j != num_attributes; ++j) {
+				const auto& pl = tr.planes[j];
+				start[j] = pl.base + pl.dx * cx + pl.dy * cy;
+				step[j] = pl.dx;
+			}
+
+			fill_span(s, t, p, y, x_begin, x_end, start, step);
+		}
+	}
+
+	for (const auto& l : this->lines) {
+		const auto& a = l.ends[0];
+		const auto& b = l.ends[1];
+
+		auto d = b.pos - a.pos;
+		auto num_steps = std::max(1, int(std::ceil(std::max(std::abs(d.x()), std::abs(d.y())))));
+
+		for (int k = 0; k != num_steps; ++k) {
+			float f = float(k) / float(num_steps);
+
+			int x = int(std::floor(a.pos.x() + d.x() * f));
+			int y = int(std::floor(a.pos.y() + d.y() * f));
+
+			if (y < std::max(clip.y1, y_begin) || y >= std::min(clip.y2, y_end) || x < clip.x1 || x >= clip.x2) {
+				continue;
+			}
+
+			attributes attrs{};
+			attrs[0] = a.pos.z() + d.z() * f;
+			for (size_t j = 0; j != num_varyings; ++j) {
+				attrs[j + 1] = a.varyings[j] + (b.varyings[j] - a.varyings[j]) * f;
+			}
+
+			fill_span(s, t, p, y, x, x + 1, attrs, {});
+		}
+	}
+}
+
+void rasterizer::draw(
+	const state& s,
+	const target& t,
+	const r4::matrix4<float>& matrix,
+	const ruis::render::vertex_array& va,
+	const program& p
+)
+{
+	ASSERT(t.color)
+
+	const auto& positions = static_cast<const vertex_buffer&>(va.buffers.front().get());
+	const auto* varyings =
+		va.buffers.size() > 1 ? &static_cast<const vertex_buffer&>(va.buffers[1].get()) : nullptr;
+	const auto& indices = static_cast<const index_buffer&>(va.indices.get()).indices;
+
+	// clipping rectangle is the intersection of target image, viewport and scissor rectangles
+	auto dims = t.color->dims();
+	box clip = {0, 0, int(dims.x()), int(dims.y())};
+	auto intersect = [&clip](const r4::rectangle<uint32_t>& r) {
+		clip.x1 = std::max(clip.x1, int(r.p.x()));
+		clip.y1 = std::max(clip.y1, int(r.p.y()));
+		clip.x2 = std::min(clip.x2, int(r.p.x() + r.d.x()));
+		clip.y2 = std::min(clip.y2, int(r.p.y() + r.d.y()));
+	};
+	intersect(s.viewport);
+	if (s.scissor_enabled) {
+		intersect(s.scissor);
+	}
+	if (clip.x1 >= clip.x2 || clip.y1 >= clip.y2) {
+		return;
+	}
+
+	// transform vertices to window coordinates
+	this->vertices.clear();
+	for (size_t i = 0; i != positions.size; ++i) {
+		auto pos = matrix * positions.get(i);
+
+		float w = pos.w() == 0 ? 1 : pos.w();
+		r4::vector3<float> ndc = {pos.x() / w, pos.y() / w, pos.z() / w};
+
+		vertex v{};
+		v.pos = {
+			float(s.viewport.p.x()) + (ndc.x() + 1) * half * float(s.viewport.d.x()),
+			float(s.viewport.p.y()) + (ndc.y() + 1) * half * float(s.viewport.d.y()),
+			(ndc.z() + 1) * half
+		};
+		if (varyings) {
+			auto var = varyings->get(i);
+			std::copy(var.begin(), var.end(), v.varyings.begin());
+		}
+		this->vertices.push_back(v);
+	}
+
+	auto get_vertex = [&](size_t i) -> const vertex& {
+		if (indices.empty()) {
+			// no index buffer, vertices go in order
+			return this->vertices[i];
+		}
+		return this->vertices[indices[i]];
+	};
+	size_t num_indices = indices.empty() ? this->vertices.size() : indices.size();
+
+	// assemble primitives
+	this->triangles.clear();
+	this->lines.clear();
+	switch (va.rendering_mode) {
+		case ruis::render::vertex_array::mode::triangles:
+			for (size_t i = 0; i + 2 < num_indices; i += 3) {
+				this->set_up_triangle(get_vertex(i), get_vertex(i + 1), get_vertex(i + 2), clip);
+			}
+			break;
+		case ruis::render::vertex_array::mode::triangle_fan:
+			for (size_t i = 1; i + 1 < num_indices; ++i) {
+				this->set_up_triangle(get_vertex(0), get_vertex(i), get_vertex(i + 1), clip);
+			}
+			break;
+		case ruis::render::vertex_array::mode::triangle_strip:
+			for (size_t i = 0; i + 2 < num_indices; ++i) {
+				this->set_up_triangle(get_vertex(i), get_vertex(i + 1), get_vertex(i + 2), clip);
+			}
+			break;
+		case ruis::render::vertex_array::mode::line_loop:
+			for (size_t i = 0; i != num_indices; ++i) {
+				this->lines.push_back({
+					{get_vertex(i), get_vertex((i + 1) % num_indices)}
+				});
+			}
+			break;
+		default:
+			break;
+	}
+
+	if (this->triangles.empty() && this->lines.empty()) {
+		return;
+	}
+
+	// estimate amount of work to decide whether it is worth to split it between threads
+	size_t num_pixels = 0;
+	for (const auto& tr : this->triangles) {
+		const auto& bb = tr.bounding_box;
+		num_pixels += size_t(bb.x2 - bb.x1) * size_t(bb.y2 - bb.y1);
+	}
+
+	constexpr size_t min_pixels_per_thread = 0x4000;
+	constexpr int min_band_height = 16;
+
+	int num_rows = clip.y2 - clip.y1;
+
+	// worker threads and the calling thread
+	unsigned num_threads = this->pool ? this->pool->size() + 1 : 1;
+
+	if (num_threads > 1 && num_pixels >= min_pixels_per_thread * num_threads &&
+		num_rows >= min_band_height * int(num_threads))
+	{
+		int num_bands = int(num_threads);
+		int band_height = (num_rows + num_bands - 1) / num_bands;
+
+		this->pool->run(unsigned(num_bands), [&](unsigned band) {
+			int y_begin = clip.y1 + int(band) * band_height;
+			this->rasterize(s, t, p, clip, y_begin, std::min(y_begin + band_height, clip.y2));
+		});
+	} else {
+		this->rasterize(s, t, p, clip, clip.y1, clip.y2);
+	}
+}
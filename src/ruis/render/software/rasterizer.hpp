@@ -0,0 +1,174 @@
+/*
+ruis - GUI framework
+
+Copyright (C) 2012-2024  Ivan Gagis <igagis@gmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* ================ LICENSE END ================ */
+
+#pragma once
+
+#include <array>
+#include <vector>
+
+#include <r4/matrix.hpp>
+#include <r4/rectangle.hpp>
+#include <r4/vector.hpp>
+
+#include "../../util/worker_pool.hpp"
+#include "../renderer.hpp"
+
+#include "texture_2d.hpp"
+
+namespace ruis::render::software {
+
+/**
+ * @brief Triangle and line rasterizer.
+ * Rasterizes triangles row by row, filling horizontal spans of pixels.
+ * Span loops work on contiguous arrays, so that the compiler can vectorize them.
+ * Large draw calls can be split into horizontal bands which are rasterized in parallel.
+ */
+class rasterizer
+{
+public:
+	struct target {
+		texture_2d::image_type* color = nullptr;
+
+		// can be nullptr
+		std::vector<float>* depth = nullptr;
+	};
+
+	struct state {
+		r4::rectangle<uint32_t> viewport{0, 0};
+		bool scissor_enabled = false;
+		r4::rectangle<uint32_t> scissor{0, 0};
+		renderer::blending blending;
+		bool depth_test = false;
+	};
+
+	/**
+	 * @brief Fragment program.
+	 * Defines how the color of a pixel is computed.
+	 */
+	struct program {
+		enum class type {
+			// uniform color
+			color,
+
+			// uniform color with alpha multiplied by per vertex luminance
+			color_lum,
+
+			// per vertex color
+			vertex_color,
+
+			// texture
+			texture,
+
+			// uniform color multiplied by texture
+			color_texture,
+
+			// uniform color with alpha multiplied by texture alpha
+			color_texture_alpha
+		};
+
+		type t = type::color;
+		r4::vector4<float> color = {1, 1, 1, 1};
+		const texture_2d* tex = nullptr;
+	};
+
+private:
+	worker_pool* pool;
+
+	constexpr static size_t num_varyings = 4;
+
+	struct vertex {
+		r4::vector3<float> pos;
+		std::array<float, num_varyings> varyings;
+	};
+
+	// plane equation of an attribute in window coordinates: value(x, y) = base + dx * x + dy * y
+	struct plane {
+		float base;
+		float dx;
+		float dy;
+	};
+
+	// edge function: value(x, y) = a * x + b * y + c, positive inside of the triangle
+	struct edge {
+		float a;
+		float b;
+		float c;
+	};
+
+	// pixel rectangle, right and bottom edges are exclusive
+	struct box {
+		int x1;
+		int y1;
+		int x2;
+		int y2;
+	};
+
+	struct triangle {
+		std::array<edge, 3> edges;
+
+		// depth and varyings
+		std::array<plane, num_varyings + 1> planes;
+
+		box bounding_box;
+	};
+
+	struct line {
+		std::array<vertex, 2> ends;
+	};
+
+	std::vector<vertex> vertices;
+	std::vector<triangle> triangles;
+	std::vector<line> lines;
+
+	void set_up_triangle(const vertex& v0, const vertex& v1, const vertex& v2, const box& clip);
+
+	void rasterize(
+		const state& s,
+		const target& t,
+		const program& p,
+		const box& clip,
+		int y_begin,
+		int y_end
+	) const;
+
+public:
+	rasterizer(worker_pool* pool) :
+		pool(pool)
+	{}
+
+	/**
+	 * @brief Render vertex array.
+	 * @param s - rendering state.
+	 * @param t - render target.
+	 * @param matrix - vertex transformation matrix.
+	 * @param va - vertex array to render.
+	 * @param p - fragment program.
+	 */
+	void draw(
+		const state& s,
+		const target& t,
+		const r4::matrix4<float>& matrix,
+		const ruis::render::vertex_array& va,
+		const program& p
+	);
+};
+
+} // namespace ruis::render::software
@@ -0,0 +1,162 @@
+/*
+ruis - GUI framework
+
+Copyright (C) 2012-2024  Ivan Gagis <igagis@gmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* ================ LICENSE END ================ */
+
+#include "renderer.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "factory.hpp"
+
+using namespace ruis::render::software;
+
+renderer::renderer(const parameters& params) :
+	renderer(std::make_shared<device>(params.dims, params.num_threads), params.max_texture_size)
+{
+	this->set_viewport({{0, 0}, params.dims});
+}
+
+renderer::renderer(std::shared_ptr<device> dev, unsigned max_texture_size) :
+	ruis::render::renderer(
+		std::make_unique<factory>(dev),
+		{
+			.max_texture_size = max_texture_size,
+			// screen image rows go from top to bottom, so do window coordinates
+			.initial_matrix = r4::matrix4<float>().set_identity().translate(-1, -1).scale(2, 2)
+		}
+	),
+	dev(std::move(dev))
+{}
+
+void renderer::resize(r4::vector2<uint32_t> dims)
+{
+	this->dev->resize(dims);
+}
+
+void renderer::clear_framebuffer_color()
+{
+	auto t = this->dev->get_target();
+	auto& image = *t.color;
+
+	// same as in OpenGL, clearing is limited by scissor rectangle
+	r4::rectangle<uint32_t> rect = {{0, 0}, image.dims()};
+	if (this->dev->state.scissor_enabled) {
+		rect.intersect(this->dev->state.scissor);
+	}
+
+	for (uint32_t y = rect.p.y(); y < rect.p.y() + rect.d.y(); ++y) {
+		auto line = image[y];
+		std::fill(
+			utki::next(line.begin(), rect.p.x()),
+			utki::next(line.begin(), rect.p.x() + rect.d.x()),
+			texture_2d::image_type::pixel_type{0, 0, 0, 0}
+		);
+	}
+}
+
+void renderer::clear_framebuffer_depth()
+{
+	auto t = this->dev->get_target();
+	if (!t.depth) {
+		return;
+	}
+	std::fill(t.depth->begin(), t.depth->end(), 1.0f);
+}
+
+void renderer::clear_framebuffer_stencil()
+{
+	// stencil is not supported
+}
+
+r4::vector2<uint32_t> renderer::to_window_coords(ruis::vec2 point) const
+{
+	const auto& vp = this->dev->state.viewport;
+
+	point = ((point + ruis::vec2(1)) / 2).comp_mul(vp.d.to<real>()) + vp.p.to<real>();
+
+	using std::max;
+	using std::round;
+	return {uint32_t(max(round(point.x()), real(0))), uint32_t(max(round(point.y()), real(0)))};
+}
+
+bool renderer::is_scissor_enabled() const noexcept
+{
+	return this->dev->state.scissor_enabled;
+}
+
+void renderer::enable_scissor(bool enable)
+{
+	this->dev->state.scissor_enabled = enable;
+}
+
+r4::rectangle<uint32_t> renderer::get_scissor() const
+{
+	return this->dev->state.scissor;
+}
+
+void renderer::set_scissor(r4::rectangle<uint32_t> r)
+{
+	this->dev->state.scissor = r;
+}
+
+r4::rectangle<uint32_t> renderer::get_viewport() const
+{
+	return this->dev->state.viewport;
+}
+
+void renderer::set_viewport(r4::rectangle<uint32_t> r)
+{
+	this->dev->state.viewport = r;
+}
+
+void renderer::enable_blend(bool enable)
+{
+	this->dev->state.blending.enabled = enable;
+}
+
+void renderer::set_blend_func(
+	blend_factor src_color,
+	blend_factor dst_color,
+	blend_factor src_alpha,
+	blend_factor dst_alpha
+)
+{
+	auto& b = this->dev->state.blending;
+	b.src_color = src_color;
+	b.dst_color = dst_color;
+	b.src_alpha = src_alpha;
+	b.dst_alpha = dst_alpha;
+}
+
+bool renderer::is_depth_enabled() const noexcept
+{
+	return this->dev->state.depth_test;
+}
+
+void renderer::enable_depth(bool enable)
+{
+	this->dev->state.depth_test = enable;
+}
+
+void renderer::set_framebuffer_internal(ruis::render::frame_buffer* fb)
+{
+	this->dev->fb = fb;
+}
@@ -0,0 +1,115 @@
+/*
+ruis - GUI framework
+
+Copyright (C) 2012-2024  Ivan Gagis <igagis@gmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* ================ LICENSE END ================ */
+
+#pragma once
+
+#include <memory>
+
+#include "../renderer.hpp"
+
+#include "device.hpp"
+
+namespace ruis::render::software {
+
+/**
+ * @brief Software renderer.
+ * Renders on CPU into an in-memory RGBA image.
+ * Useful for headless environments, like CI or server side image generation.
+ * The screen image rows go from top to bottom, i.e. the first row of the image is the top one.
+ */
+class renderer : public ruis::render::renderer
+{
+	std::shared_ptr<device> dev;
+
+	renderer(std::shared_ptr<device> dev, unsigned max_texture_size);
+
+public:
+	struct parameters {
+		/**
+		 * @brief Dimensions of the screen image in pixels.
+		 */
+		r4::vector2<uint32_t> dims;
+
+		/**
+		 * @brief Number of threads to rasterize with.
+		 * Large draw calls are split into horizontal bands which are rasterized in parallel.
+		 */
+		unsigned num_threads = 1;
+
+		unsigned max_texture_size = ruis::render::renderer::params::default_max_texture_size;
+	};
+
+	renderer(const parameters& params);
+
+	/**
+	 * @brief Get screen image.
+	 * @return Screen image.
+	 */
+	const texture_2d::image_type& get_image() const noexcept
+	{
+		return this->dev->screen;
+	}
+
+	/**
+	 * @brief Resize screen image.
+	 * Contents of the screen image are cleared. Viewport is not changed.
+	 * @param dims - new dimensions of the screen image.
+	 */
+	void resize(r4::vector2<uint32_t> dims);
+
+	void clear_framebuffer_color() override;
+
+	void clear_framebuffer_depth() override;
+
+	void clear_framebuffer_stencil() override;
+
+	r4::vector2<uint32_t> to_window_coords(ruis::vec2 point) const override;
+
+	bool is_scissor_enabled() const noexcept override;
+
+	void enable_scissor(bool enable) override;
+
+	r4::rectangle<uint32_t> get_scissor() const override;
+
+	void set_scissor(r4::rectangle<uint32_t> r) override;
+
+	r4::rectangle<uint32_t> get_viewport() const override;
+
+	void set_viewport(r4::rectangle<uint32_t> r) override;
+
+	void enable_blend(bool enable) override;
+
+	void set_blend_func(
+		blend_factor src_color,
+		blend_factor dst_color,
+		blend_factor src_alpha,
+		blend_factor dst_alpha
+	) override;
+
+	bool is_depth_enabled() const noexcept override;
+
+	void enable_depth(bool enable) override;
+
+protected:
+	void set_framebuffer_internal(ruis::render::frame_buffer* fb) override;
+};
+
+} // namespace ruis::render::software
@@ -0,0 +1,127 @@
+/*
+ruis - GUI framework
+
+Copyright (C) 2012-2024  Ivan Gagis <igagis@gmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* ================ LICENSE END ================ */
+
+#include "shaders.hpp"
+
+#include <utki/debug.hpp>
+
+using namespace ruis::render::software;
+
+namespace {
+const texture_2d& to_software(const ruis::render::texture_2d& tex)
+{
+	return static_cast<const texture_2d&>(tex);
+}
+
+class pos_tex_shader : public ruis::render::texturing_shader
+{
+	std::shared_ptr<device> dev;
+
+public:
+	pos_tex_shader(std::shared_ptr<device> dev) :
+		dev(std::move(dev))
+	{}
+
+	void render(
+		const r4::matrix4<float>& m,
+		const ruis::render::vertex_array& va,
+		const ruis::render::texture_2d& tex
+	) const override
+	{
+		this->dev->draw(m, va, {.t = rasterizer::program::type::texture, .tex = &to_software(tex)});
+	}
+};
+
+class color_pos_shader : public ruis::render::coloring_shader
+{
+	std::shared_ptr<device> dev;
+	rasterizer::program::type type;
+
+public:
+	color_pos_shader(std::shared_ptr<device> dev, rasterizer::program::type type) :
+		dev(std::move(dev)),
+		type(type)
+	{}
+
+	using ruis::render::coloring_shader::render;
+
+	void render(const r4::matrix4<float>& m, const ruis::render::vertex_array& va, r4::vector4<float> color)
+		const override
+	{
+		this->dev->draw(m, va, {.t = this->type, .color = color});
+	}
+};
+
+class pos_clr_shader : public ruis::render::shader
+{
+	std::shared_ptr<device> dev;
+
+public:
+	pos_clr_shader(std::shared_ptr<device> dev) :
+		dev(std::move(dev))
+	{}
+
+	void render(const r4::matrix4<float>& m, const ruis::render::vertex_array& va) const override
+	{
+		this->dev->draw(m, va, {.t = rasterizer::program::type::vertex_color});
+	}
+};
+
+class color_pos_tex_shader : public ruis::render::coloring_texturing_shader
+{
+	std::shared_ptr<device> dev;
+	rasterizer::program::type type;
+
+public:
+	color_pos_tex_shader(std::shared_ptr<device> dev, rasterizer::program::type type) :
+		dev(std::move(dev)),
+		type(type)
+	{}
+
+	void render(
+		const r4::matrix4<float>& m,
+		const ruis::render::vertex_array& va,
+		r4::vector4<float> color,
+		const ruis::render::texture_2d& tex
+	) const override
+	{
+		this->dev->draw(m, va, {.t = this->type, .color = color, .tex = &to_software(tex)});
+	}
+};
+} // namespace
+
+std::unique_ptr<ruis::render::factory::shaders> ruis::render::software::make_shaders(
+	const std::shared_ptr<device>& dev
+)
+{
+	using type = rasterizer::program::type;
+
+	auto ret = std::make_unique<ruis::render::factory::shaders>();
+
+	ret->pos_tex = std::make_unique<pos_tex_shader>(dev);
+	ret->color_pos = std::make_unique<color_pos_shader>(dev, type::color);
+	ret->color_pos_lum = std::make_unique<color_pos_shader>(dev, type::color_lum);
+	ret->pos_clr = std::make_unique<pos_clr_shader>(dev);
+	ret->color_pos_tex = std::make_unique<color_pos_tex_shader>(dev, type::color_texture);
+	ret->color_pos_tex_alpha = std::make_unique<color_pos_tex_shader>(dev, type::color_texture_alpha);
+
+	return ret;
+}
@@ -0,0 +1,39 @@
+/*
+ruis - GUI framework
+
+Copyright (C) 2012-2024  Ivan Gagis <igagis@gmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* ================ LICENSE END ================ */
+
+#pragma once
+
+#include <memory>
+
+#include "../factory.hpp"
+
+#include "device.hpp"
+
+namespace ruis::render::software {
+
+/**
+ * @brief Create shaders which render via the rendering device.
+ * @param dev - rendering device.
+ * @return Shaders.
+ */
+std::unique_ptr<ruis::render::factory::shaders> make_shaders(const std::shared_ptr<device>& dev);
+
+} // namespace ruis::render::software
@@ -0,0 +1,171 @@
+/*
+ruis - GUI framework
+
+Copyright (C) 2012-2024  Ivan Gagis <igagis@gmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* ================ LICENSE END ================ */
+
+#include "texture_2d.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include <utki/util.hpp>
+
+using namespace ruis::render::software;
+
+namespace {
+texture_2d::image_type to_rgba(const rasterimage::image_variant& imvar)
+{
+	if (imvar.get_depth() != rasterimage::depth::uint_8_bit) {
+		throw std::invalid_argument("software::texture_2d: only 8 bit images are supported");
+	}
+
+	texture_2d::image_type ret(imvar.dims());
+
+	auto convert = [&ret](const auto& im, auto to_rgba) {
+		for (uint32_t y = 0; y != im.dims().y(); ++y) {
+			auto src_line = im[y];
+			auto dst_line = ret[y];
+			std::transform(src_line.begin(), src_line.end(), dst_line.begin(), to_rgba);
+		}
+	};
+
+	using pixel_type = texture_2d::image_type::pixel_type;
+	constexpr uint8_t opaque = 0xff;
+
+	switch (imvar.get_format()) {
+		case rasterimage::format::grey:
+			convert(imvar.get<rasterimage::format::grey, rasterimage::depth::uint_8_bit>(), [](const auto& p) {
+				return pixel_type{p[0], p[0], p[0], opaque};
+			});
+			break;
+		case rasterimage::format::greya:
+			convert(imvar.get<rasterimage::format::greya, rasterimage::depth::uint_8_bit>(), [](const auto& p) {
+				return pixel_type{p[0], p[0], p[0], p[1]};
+			});
+			break;
+		case rasterimage::format::rgb:
+			convert(imvar.get<rasterimage::format::rgb, rasterimage::depth::uint_8_bit>(), [](const auto& p) {
+				return pixel_type{p[0], p[1], p[2], opaque};
+			});
+			break;
+		case rasterimage::format::rgba:
+			convert(imvar.get<rasterimage::format::rgba, rasterimage::depth::uint_8_bit>(), [](const auto& p) {
+				return pixel_type{p[0], p[1], p[2], p[3]};
+			});
+			break;
+		default:
+			throw std::invalid_argument("software::texture_2d: unsupported image format");
+	}
+
+	return ret;
+}
+
+texture_2d::image_type make_blank_image(r4::vector2<uint32_t> dims)
+{
+	texture_2d::image_type ret(dims);
+	for (uint32_t y = 0; y != dims.y(); ++y) {
+		auto line = ret[y];
+		std::fill(line.begin(), line.end(), texture_2d::image_type::pixel_type{0, 0, 0, 0});
+	}
+	return ret;
+}
+
+r4::vector4<float> to_float(const texture_2d::image_type::pixel_type& p) noexcept
+{
+	constexpr float max_value = 0xff;
+	return r4::vector4<float>{float(p[0]), float(p[1]), float(p[2]), float(p[3])} / max_value;
+}
+} // namespace
+
+texture_2d::texture_2d(
+	rasterimage::format format, //
+	r4::vector2<uint32_t> dims,
+	ruis::render::factory::texture_2d_parameters params
+) :
+	ruis::render::texture_2d(dims),
+	image(make_blank_image(dims)),
+	grey(format == rasterimage::format::grey),
+	params(params)
+{}
+
+texture_2d::texture_2d(
+	const rasterimage::image_variant& imvar, //
+	ruis::render::factory::texture_2d_parameters params
+) :
+	ruis::render::texture_2d(imvar.dims()),
+	image(to_rgba(imvar)),
+	grey(imvar.get_format() == rasterimage::format::grey),
+	params(params)
+{}
+
+bool texture_2d::update(r4::vector2<uint32_t> pos, const rasterimage::image_variant& imvar)
+{
+	auto src = to_rgba(imvar);
+
+	if (pos.x() + src.dims().x() > this->image.dims().x() || pos.y() + src.dims().y() > this->image.dims().y()) {
+		throw std::invalid_argument("software::texture_2d::update(): the image does not fit into the texture");
+	}
+
+	for (uint32_t y = 0; y != src.dims().y(); ++y) {
+		auto src_line = src[y];
+		std::copy(src_line.begin(), src_line.end(), utki::next(this->image[pos.y() + y].begin(), pos.x()));
+	}
+
+	return true;
+}
+
+r4::vector4<float> texture_2d::sample(r4::vector2<float> uv) const noexcept
+{
+	auto dims = this->image.dims();
+	if (dims.x() == 0 || dims.y() == 0) {
+		return {0, 0, 0, 0};
+	}
+
+	auto max_x = int(dims.x()) - 1;
+	auto max_y = int(dims.y()) - 1;
+
+	// texel coordinates, texel centers are at half integers
+	float tx = uv.x() * float(dims.x());
+	float ty = uv.y() * float(dims.y());
+
+	if (this->params.mag_filter == filter::nearest) {
+		auto x = std::clamp(int(std::floor(tx)), 0, max_x);
+		auto y = std::clamp(int(std::floor(ty)), 0, max_y);
+		return to_float(this->image[y][x]);
+	}
+
+	tx -= 0.5f; // NOLINT(cppcoreguidelines-avoid-magic-numbers)
+	ty -= 0.5f; // NOLINT(cppcoreguidelines-avoid-magic-numbers)
+
+	float fx = std::floor(tx);
+	float fy = std::floor(ty);
+
+	float wx = tx - fx;
+	float wy = ty - fy;
+
+	auto x0 = std::clamp(int(fx), 0, max_x);
+	auto y0 = std::clamp(int(fy), 0, max_y);
+	auto x1 = std::clamp(int(fx) + 1, 0, max_x);
+	auto y1 = std::clamp(int(fy) + 1, 0, max_y);
+
+	auto top = to_float(this->image[y0][x0]) * (1 - wx) + to_float(this->image[y0][x1]) * wx;
+	auto bottom = to_float(this->image[y1][x0]) * (1 - wx) + to_float(this->image[y1][x1]) * wx;
+
+	return top * (1 - wy) + bottom * wy;
+}
@@ -0,0 +1,76 @@
+/*
+ruis - GUI framework
+
+Copyright (C) 2012-2024  Ivan Gagis <igagis@gmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* ================ LICENSE END ================ */
+
+#pragma once
+
+#include <rasterimage/image.hpp>
+#include <rasterimage/image_variant.hpp>
+#include <r4/vector.hpp>
+
+#include "../factory.hpp"
+#include "../texture_2d.hpp"
+
+namespace ruis::render::software {
+
+class texture_2d : public ruis::render::texture_2d
+{
+public:
+	using image_type = rasterimage::image<uint8_t, 4>;
+
+	/**
+	 * @brief Texture image.
+	 * Images of all formats are stored as 8 bit RGBA. Grey images are expanded to (grey, grey, grey, 1),
+	 * same way as OpenGL samples luminance textures.
+	 * The image is rendered to when the texture is attached to a frame buffer.
+	 */
+	image_type image;
+
+	/**
+	 * @brief Whether the original image had no alpha channel and was grey.
+	 * Alpha of such textures is taken from the grey channel by the alpha texturing shader.
+	 */
+	const bool grey;
+
+	const ruis::render::factory::texture_2d_parameters params;
+
+	texture_2d(
+		rasterimage::format format, //
+		r4::vector2<uint32_t> dims,
+		ruis::render::factory::texture_2d_parameters params
+	);
+
+	texture_2d(
+		const rasterimage::image_variant& imvar, //
+		ruis::render::factory::texture_2d_parameters params
+	);
+
+	bool update(r4::vector2<uint32_t> pos, const rasterimage::image_variant& imvar) override;
+
+	/**
+	 * @brief Sample the texture.
+	 * Texture coordinates are clamped to the edge.
+	 * @param uv - texture coordinates.
+	 * @return Sampled color, components are in [0:1] range.
+	 */
+	r4::vector4<float> sample(r4::vector2<float> uv) const noexcept;
+};
+
+} // namespace ruis::render::software
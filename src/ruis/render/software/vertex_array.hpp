@@ -0,0 +1,40 @@
+/*
+ruis - GUI framework
+
+Copyright (C) 2012-2024  Ivan Gagis <igagis@gmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* ================ LICENSE END ================ */
+
+#pragma once
+
+#include "../vertex_array.hpp"
+
+namespace ruis::render::software {
+
+class vertex_array : public ruis::render::vertex_array
+{
+public:
+	vertex_array(
+		buffers_type buffers, //
+		const utki::shared_ref<const ruis::render::index_buffer>& indices,
+		mode rendering_mode
+	) :
+		ruis::render::vertex_array(std::move(buffers), indices, rendering_mode)
+	{}
+};
+
+} // namespace ruis::render::software
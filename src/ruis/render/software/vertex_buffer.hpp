@@ -0,0 +1,83 @@
+/*
+ruis - GUI framework
+
+Copyright (C) 2012-2024  Ivan Gagis <igagis@gmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* ================ LICENSE END ================ */
+
+#pragma once
+
+#include <type_traits>
+#include <vector>
+
+#include <r4/vector.hpp>
+#include <utki/span.hpp>
+
+#include "../vertex_buffer.hpp"
+
+namespace ruis::render::software {
+
+class vertex_buffer : public ruis::render::vertex_buffer
+{
+public:
+	/**
+	 * @brief Number of components per vertex, from 1 to 4.
+	 */
+	const unsigned num_components;
+
+	/**
+	 * @brief Vertex data.
+	 * Components of vertices go one after another.
+	 */
+	const std::vector<float> data;
+
+	template <typename vertex_type>
+	vertex_buffer(utki::span<const vertex_type> vertices, unsigned num_components) :
+		ruis::render::vertex_buffer(vertices.size()),
+		num_components(num_components),
+		data([&]() {
+			std::vector<float> ret;
+			ret.reserve(vertices.size() * num_components);
+			for (const auto& v : vertices) {
+				if constexpr (std::is_arithmetic_v<vertex_type>) {
+					ret.push_back(v);
+				} else {
+					ret.insert(ret.end(), v.begin(), v.end());
+				}
+			}
+			return ret;
+		}())
+	{}
+
+	/**
+	 * @brief Get vertex attribute.
+	 * Missing components are filled same way as OpenGL does, i.e. with (0, 0, 0, 1).
+	 * @param index - index of the vertex.
+	 * @return Vertex attribute.
+	 */
+	r4::vector4<float> get(size_t index) const noexcept
+	{
+		r4::vector4<float> ret = {0, 0, 0, 1};
+		const float* v = &this->data[index * this->num_components];
+		for (unsigned i = 0; i != this->num_components; ++i) {
+			ret[i] = v[i];
+		}
+		return ret;
+	}
+};
+
+} // namespace ruis::render::software
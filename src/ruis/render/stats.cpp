@@ -0,0 +1,106 @@
+/*
+ruis - GUI framework
+
+Copyright (C) 2012-2024  Ivan Gagis <igagis@gmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* ================ LICENSE END ================ */
+
+#include "stats.hpp"
+
+using namespace ruis::render;
+
+stats::counters& stats::counters::operator+=(const counters& c) noexcept
+{
+	this->draw_calls += c.draw_calls;
+	this->quads += c.quads;
+	this->texture_binds += c.texture_binds;
+	this->framebuffer_switches += c.framebuffer_switches;
+	this->scissor_changes += c.scissor_changes;
+	this->blending_changes += c.blending_changes;
+	this->textures_created += c.textures_created;
+	this->vertex_buffers_created += c.vertex_buffers_created;
+	this->index_buffers_created += c.index_buffers_created;
+	this->vertex_arrays_created += c.vertex_arrays_created;
+	this->framebuffers_created += c.framebuffers_created;
+	return *this;
+}
+
+stats::counters stats::get(const std::type_info& widget_class) const
+{
+	auto i = this->widget_class_counters.find(widget_class);
+	if (i == this->widget_class_counters.end()) {
+		return {};
+	}
+	return i->second;
+}
+
+const std::type_info* stats::set_widget_class(const std::type_info* widget_class)
+{
+	auto ret = this->cur_widget_class;
+
+	this->cur_widget_class = widget_class;
+
+	if (widget_class) {
+		this->cur_widget_class_counters = &this->widget_class_counters[*widget_class];
+	} else {
+		this->cur_widget_class_counters = nullptr;
+	}
+
+	return ret;
+}
+
+void stats::clear() noexcept
+{
+	this->total_counters = {};
+	this->widget_class_counters.clear();
+
+	// keep attributing to the current widget class, if any
+	this->cur_widget_class_counters = nullptr;
+	if (this->cur_widget_class) {
+		this->set_widget_class(this->cur_widget_class);
+	}
+}
+
+namespace {
+void write_counters(std::ostream& o, const stats::counters& c)
+{
+	o << " draw_calls=" << c.draw_calls //
+	  << " quads=" << c.quads //
+	  << " texture_binds=" << c.texture_binds //
+	  << " framebuffer_switches=" << c.framebuffer_switches //
+	  << " scissor_changes=" << c.scissor_changes //
+	  << " blending_changes=" << c.blending_changes //
+	  << " textures_created=" << c.textures_created //
+	  << " vertex_buffers_created=" << c.vertex_buffers_created //
+	  << " index_buffers_created=" << c.index_buffers_created //
+	  << " vertex_arrays_created=" << c.vertex_arrays_created //
+	  << " framebuffers_created=" << c.framebuffers_created;
+}
+} // namespace
+
+void stats::write_summary(std::ostream& o) const
+{
+	o << "total";
+	write_counters(o, this->total_counters);
+	o << '\n';
+
+	for (const auto& c : this->widget_class_counters) {
+		o << c.first.name();
+		write_counters(o, c.second);
+		o << '\n';
+	}
+}
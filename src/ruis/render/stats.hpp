@@ -0,0 +1,168 @@
+/*
+ruis - GUI framework
+
+Copyright (C) 2012-2024  Ivan Gagis <igagis@gmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* ================ LICENSE END ================ */
+
+#pragma once
+
+#include <cstddef>
+#include <ostream>
+#include <typeindex>
+#include <typeinfo>
+#include <unordered_map>
+
+#include <r4/rectangle.hpp>
+
+namespace ruis::render {
+
+/**
+ * @brief Rendering statistics.
+ * Counts draw calls, state changes and creation of renderer objects.
+ * Counters are also attributed to the class of the widget which is being rendered at the moment,
+ * see widget::render_internal().
+ */
+class stats
+{
+	friend class renderer;
+
+public:
+	struct counters {
+		/**
+		 * @brief Number of shader invocations.
+		 * In deferred rendering mode the draw calls are done when the draw list is flushed,
+		 * so these are mostly attributed to the widget which caused the flush.
+		 */
+		size_t draw_calls = 0;
+
+		/**
+		 * @brief Number of quads submitted via renderer::render_quad() and renderer::render_alpha_quads().
+		 */
+		size_t quads = 0;
+
+		/**
+		 * @brief Number of draw calls which used different texture than the preceding draw call.
+		 */
+		size_t texture_binds = 0;
+
+		/**
+		 * @brief Number of renderer::set_framebuffer() calls.
+		 */
+		size_t framebuffer_switches = 0;
+
+		/**
+		 * @brief Number of draw calls done with different scissor state than the preceding draw call.
+		 */
+		size_t scissor_changes = 0;
+
+		/**
+		 * @brief Number of renderer::set_blending() calls which changed the blending state.
+		 */
+		size_t blending_changes = 0;
+
+		size_t textures_created = 0;
+		size_t vertex_buffers_created = 0;
+		size_t index_buffers_created = 0;
+		size_t vertex_arrays_created = 0;
+		size_t framebuffers_created = 0;
+
+		counters& operator+=(const counters& c) noexcept;
+	};
+
+private:
+	counters total_counters;
+
+	std::unordered_map<std::type_index, counters> widget_class_counters;
+
+	const std::type_info* cur_widget_class = nullptr;
+
+	// points into the widget_class_counters
+	counters* cur_widget_class_counters = nullptr;
+
+	// state of the last draw call
+	const void* last_texture = nullptr;
+	bool last_scissor_enabled = false;
+	r4::rectangle<uint32_t> last_scissor{0, 0};
+
+	void count(size_t counters::*counter, size_t num = 1) noexcept
+	{
+		this->total_counters.*counter += num;
+		if (this->cur_widget_class_counters) {
+			this->cur_widget_class_counters->*counter += num;
+		}
+	}
+
+public:
+	/**
+	 * @brief Get counters of all rendering.
+	 * @return Total counters.
+	 */
+	const counters& total() const noexcept
+	{
+		return this->total_counters;
+	}
+
+	/**
+	 * @brief Get counters attributed to widget classes.
+	 * @return Map of widget class to its counters.
+	 */
+	const std::unordered_map<std::type_index, counters>& per_widget_class() const noexcept
+	{
+		return this->widget_class_counters;
+	}
+
+	/**
+	 * @brief Get counters attributed to a widget class.
+	 * @param widget_class - widget class to get counters for.
+	 * @return Counters attributed to the given widget class. All zeros if nothing was attributed to the class.
+	 */
+	counters get(const std::type_info& widget_class) const;
+
+	/**
+	 * @brief Get counters attributed to a widget class.
+	 * @tparam widget_type - widget class to get counters for.
+	 * @return Counters attributed to the given widget class. All zeros if nothing was attributed to the class.
+	 */
+	template <class widget_type>
+	counters get() const
+	{
+		return this->get(typeid(widget_type));
+	}
+
+	/**
+	 * @brief Set widget class to attribute counters to.
+	 * @param widget_class - widget class to attribute counters to. nullptr to not attribute to any class.
+	 * @return Previously set widget class.
+	 */
+	const std::type_info* set_widget_class(const std::type_info* widget_class);
+
+	/**
+	 * @brief Reset all counters.
+	 */
+	void clear() noexcept;
+
+	/**
+	 * @brief Write summary in human and machine readable form.
+	 * First line is 'total' followed by the total counters as name=value pairs separated by spaces.
+	 * Each next line is a widget class name followed by its counters in the same form.
+	 * @param o - stream to write the summary to.
+	 */
+	void write_summary(std::ostream& o) const;
+};
+
+} // namespace ruis::render
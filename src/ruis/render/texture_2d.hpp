@@ -22,6 +22,7 @@ along with this program. If not, see <http://www.gnu.org/licenses/>.
 #pragma once
 
 #include <rasterimage/dimensioned.hpp>
+#include <rasterimage/image_variant.hpp>
 
 #include "../config.hpp"
 
@@ -55,6 +56,21 @@ public:
 
 	virtual ~texture_2d() = default;
 
+	/**
+	 * @brief Update part of the texture.
+	 * Replaces contents of the rectangular area of the texture with the given image.
+	 * Renderer backends which do not support partial texture updates do not override this function,
+	 * in that case the texture has to be created again with the new contents.
+	 * @param pos - position of the area to update within the texture, in pixels.
+	 * @param imvar - new contents of the area. Must fit into the texture.
+	 * @return true if the texture was updated.
+	 * @return false if partial texture updates are not supported by the renderer backend.
+	 */
+	virtual bool update(r4::vector2<uint32_t> pos, const rasterimage::image_variant& imvar)
+	{
+		return false;
+	}
+
 	// TODO: add functions to change filtering
 	// TODO: add virtual generate_mipmap()
 };
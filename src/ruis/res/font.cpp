@@ -22,6 +22,8 @@ along with this program. If not, see <http://www.gnu.org/licenses/>.
 #include "font.hpp"
 
 #include <memory>
+#include <optional>
+#include <tuple>
 
 #include <utki/unicode.hpp>
 
@@ -32,6 +34,17 @@ along with this program. If not, see <http://www.gnu.org/licenses/>.
 using namespace ruis;
 using namespace ruis::res;
 
+namespace {
+utki::shared_ref<const freetype_face> load_face(const ruis::context& ctx, const papki::file& fi)
+{
+	// use font file contents directly from memory mapped file if possible
+	if (auto mf = ctx.loader.map_file(fi)) {
+		return freetype_face::load(utki::shared_ref<const mapped_file>(std::move(mf)));
+	}
+	return freetype_face::load(fi);
+}
+} // namespace
+
 res::font::font(
 	utki::shared_ref<ruis::context> context,
 	const papki::file& file_normal,
@@ -46,7 +59,7 @@ res::font::font(
 	// NOLINTNEXTLINE(bugprone-unused-return-value, "false positive")
 	this->fonts[unsigned(style::normal)] = std::make_unique<texture_font_provider>(
 		this->context,
-		utki::make_shared<freetype_face>(file_normal),
+		freetype_face::load(file_normal),
 		max_cached
 	);
 
@@ -54,7 +67,7 @@ res::font::font(
 		// NOLINTNEXTLINE(bugprone-unused-return-value, "false positive")
 		this->fonts[unsigned(style::bold)] = std::make_unique<texture_font_provider>(
 			this->context,
-			utki::make_shared<freetype_face>(*file_bold),
+			freetype_face::load(*file_bold),
 			max_cached
 		);
 	}
@@ -62,7 +75,7 @@ res::font::font(
 		// NOLINTNEXTLINE(bugprone-unused-return-value, "false positive")
 		this->fonts[unsigned(style::italic)] = std::make_unique<texture_font_provider>(
 			this->context,
-			utki::make_shared<freetype_face>(*file_italic),
+			freetype_face::load(*file_italic),
 			max_cached
 		);
 	}
@@ -70,52 +83,132 @@ res::font::font(
 		// NOLINTNEXTLINE(bugprone-unused-return-value, "false positive")
 		this->fonts[unsigned(style::bold_italic)] = std::make_unique<texture_font_provider>(
 			this->context,
-			utki::make_shared<freetype_face>(*file_bold_italic),
+			freetype_face::load(*file_bold_italic),
 			max_cached
 		);
 	}
 }
 
+res::font::font(
+	utki::shared_ref<ruis::context> context,
+	const std::array<std::shared_ptr<const freetype_face>, size_t(style::enum_size)>& faces,
+	unsigned max_cached
+) :
+	resource(std::move(context))
+{
+	ASSERT(faces[unsigned(style::normal)])
+
+	for (size_t i = 0; i != faces.size(); ++i) {
+		// NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-constant-array-index)
+		const auto& f = faces[i];
+		if (!f) {
+			continue;
+		}
+		// NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-constant-array-index)
+		this->fonts[i] = std::make_unique<texture_font_provider>(
+			this->context,
+			utki::shared_ref<const freetype_face>(f),
+			max_cached
+		);
+	}
+}
+
+resource_loader::decoded_resource res::font::decode(
+	const tml::forest& desc, //
+	const resource_loader::resource_files& files
+)
+{
+	unsigned max_cached = std::numeric_limits<unsigned>::max();
+
+	std::array<std::shared_ptr<const freetype_face>, size_t(style::enum_size)> faces;
+
+	// the size property needs the context to be parsed
+	const ::tml::leaf* size = nullptr;
+
+	for (auto& p : desc) {
+		auto face_style = style::enum_size;
+		if (p.value == "size") {
+			size = &get_property_value(p);
+		} else if (p.value == "max_cached") {
+			max_cached = unsigned(get_property_value(p).to_uint32());
+		} else if (p.value == "normal") {
+			face_style = style::normal;
+		} else if (p.value == "bold") {
+			face_style = style::bold;
+		} else if (p.value == "italic") {
+			face_style = style::italic;
+		} else if (p.value == "bold_italic") {
+			face_style = style::bold_italic;
+		}
+
+		if (face_style == style::enum_size) {
+			continue;
+		}
+
+		auto i = files.find(get_property_value(p).string);
+		if (i == files.end()) {
+			// the file could not be read, loading on UI thread will report the error
+			return nullptr;
+		}
+		// NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-constant-array-index)
+		faces[size_t(face_style)] = freetype_face::load(i->second).to_shared_ptr();
+	}
+
+	if (!faces[size_t(style::normal)]) {
+		// the normal face file is not given, loading on UI thread will handle it
+		return nullptr;
+	}
+
+	return [faces, max_cached, size = size ? std::make_optional(*size) : std::nullopt](
+			   const utki::shared_ref<ruis::context>& ctx
+		   ) -> utki::shared_ref<resource> {
+		if (size) {
+			// TODO: font size is not used anymore, remove
+			std::ignore = parse_dimension_value(*size, ctx.get().units).get(ctx);
+		}
+		return utki::make_shared<font>(ctx, faces, max_cached);
+	};
+}
+
 utki::shared_ref<res::font> res::font::load(
 	utki::shared_ref<ruis::context> ctx,
 	const tml::forest& desc,
 	const papki::file& fi
 )
 {
-	constexpr auto default_font_size = 13;
-	unsigned font_size = default_font_size;
 	unsigned max_cached = std::numeric_limits<unsigned>::max();
 
-	std::unique_ptr<const papki::file> file_bold;
-	std::unique_ptr<const papki::file> file_italic;
-	std::unique_ptr<const papki::file> file_bold_italic;
+	std::array<std::string, size_t(style::enum_size)> files;
+	files[size_t(style::normal)] = fi.path();
 
 	for (auto& p : desc) {
 		if (p.value == "size") {
-			font_size = unsigned(parse_dimension_value(get_property_value(p), ctx.get().units).get(ctx));
+			// TODO: font size is not used anymore, remove
+			std::ignore = parse_dimension_value(get_property_value(p), ctx.get().units).get(ctx);
 		} else if (p.value == "max_cached") {
 			max_cached = unsigned(get_property_value(p).to_uint32());
 		} else if (p.value == "normal") {
-			fi.set_path(get_property_value(p).string);
+			files[size_t(style::normal)] = get_property_value(p).string;
 		} else if (p.value == "bold") {
-			// NOLINTNEXTLINE(bugprone-unused-return-value, "false positive")
-			file_bold = fi.spawn(get_property_value(p).string);
+			files[size_t(style::bold)] = get_property_value(p).string;
 		} else if (p.value == "italic") {
-			// NOLINTNEXTLINE(bugprone-unused-return-value, "false positive")
-			file_italic = fi.spawn(get_property_value(p).string);
+			files[size_t(style::italic)] = get_property_value(p).string;
 		} else if (p.value == "bold_italic") {
-			// NOLINTNEXTLINE(bugprone-unused-return-value, "false positive")
-			file_bold_italic = fi.spawn(get_property_value(p).string);
+			files[size_t(style::bold_italic)] = get_property_value(p).string;
 		}
 	}
 
-	return utki::make_shared<font>(
-		std::move(ctx),
-		fi,
-		std::move(file_bold),
-		std::move(file_italic),
-		std::move(file_bold_italic),
-		font_size,
-		max_cached
-	);
+	std::array<std::shared_ptr<const freetype_face>, size_t(style::enum_size)> faces;
+	for (size_t i = 0; i != files.size(); ++i) {
+		// NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-constant-array-index)
+		const auto& file = files[i];
+		if (file.empty()) {
+			continue;
+		}
+		fi.set_path(file);
+		// NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-constant-array-index)
+		faces[i] = load_face(ctx.get(), fi).to_shared_ptr();
+	}
+
+	return utki::make_shared<font>(std::move(ctx), faces, max_cached);
 }
@@ -29,6 +29,10 @@ along with this program. If not, see <http://www.gnu.org/licenses/>.
 #include "../resource_loader.hpp"
 #include "../util/util.hpp"
 
+namespace ruis {
+class freetype_face;
+} // namespace ruis
+
 namespace ruis::res {
 
 /**
@@ -79,6 +83,19 @@ public:
 		unsigned max_cached
 	);
 
+	/**
+	 * @brief Constructor.
+	 * @param context - context.
+	 * @param faces - font faces for each font style. The normal style face must not be null,
+	 *                other styles fall back to the normal style if null.
+	 * @param max_cached - maximum number of cached glyphs per font size.
+	 */
+	font(
+		utki::shared_ref<ruis::context> context,
+		const std::array<std::shared_ptr<const freetype_face>, size_t(style::enum_size)>& faces,
+		unsigned max_cached
+	);
+
 	font(const font&) = delete;
 	font& operator=(const font&) = delete;
 
@@ -103,6 +120,18 @@ public:
 	}
 
 private:
+	constexpr static std::array<std::string_view, 4> file_properties = {
+		"normal",
+		"bold",
+		"italic",
+		"bold_italic"
+	};
+
+	static resource_loader::decoded_resource decode(
+		const ::tml::forest& desc, //
+		const resource_loader::resource_files& files
+	);
+
 	static utki::shared_ref<font> load(
 		utki::shared_ref<ruis::context> ctx,
 		const ::tml::forest& desc,
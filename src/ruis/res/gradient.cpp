@@ -115,5 +115,7 @@ utki::shared_ref<gradient> gradient::load(
 
 void gradient::render(const ruis::matrix4& m) const
 {
-	this->context.get().renderer.get().shader->pos_clr->render(m, this->vao.get());
+	auto& r = this->context.get().renderer.get();
+	r.flush();
+	r.shader->pos_clr->render(m, this->vao.get());
 }
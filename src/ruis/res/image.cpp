@@ -19,8 +19,11 @@ along with this program. If not, see <http://www.gnu.org/licenses/>.
 
 /* ================ LICENSE END ================ */
 
+#include <limits>
 #include <memory>
+#include <mutex>
 
+#include <papki/span_file.hpp>
 #include <svgren/render.hpp>
 
 // Some bad stuff defines OVERFLOW macro and there is an enum value with same name in svgdom/dom.h.
@@ -31,6 +34,7 @@ along with this program. If not, see <http://www.gnu.org/licenses/>.
 #include <svgdom/dom.hpp>
 
 #include "../context.hpp"
+#include "../util/raster_cache.hpp"
 #include "../util/util.hpp"
 
 #include "image.hpp"
@@ -103,7 +107,9 @@ utki::shared_ref<atlas_image> atlas_image::load(
 
 void atlas_image::render(const matrix4& matrix, const render::vertex_array& vao) const
 {
-	this->context.get().renderer.get().shader->pos_tex->render(matrix, this->vao.get(), this->tex.get().tex());
+	auto& r = this->context.get().renderer.get();
+	r.flush();
+	r.shader->pos_tex->render(matrix, this->vao.get(), this->tex.get().tex());
 }
 
 utki::shared_ref<const image::texture> atlas_image::get(vector2 for_dims) const
@@ -112,37 +118,90 @@ utki::shared_ref<const image::texture> atlas_image::get(vector2 for_dims) const
 }
 
 namespace {
-class fixed_texture : public image::texture
+// bitmap of an image, packed to the texture atlas if it is small enough, otherwise stored in a texture of its own
+class bitmap_texture
 {
-protected:
-	const utki::shared_ref<const render::texture_2d> tex_2d;
+	std::shared_ptr<const texture_atlas::entry> atlas_entry;
 
-	fixed_texture(utki::shared_ref<const ruis::render::renderer> r, utki::shared_ref<const render::texture_2d> tex) :
-		image::texture(std::move(r), tex.get().dims()),
-		tex_2d(std::move(tex))
-	{}
+	// for atlas packed bitmaps it is created only when rendering with custom vertex array is requested
+	mutable std::shared_ptr<const render::texture_2d> tex_2d;
 
 public:
-	void render(const matrix4& matrix, const render::vertex_array& vao) const override
+	bitmap_texture() = default;
+
+	bitmap_texture(utki::shared_ref<const render::texture_2d> tex) :
+		tex_2d(tex.to_shared_ptr())
+	{}
+
+	bitmap_texture(ruis::context& ctx, rasterimage::image<uint8_t, 4> im) :
+		atlas_entry(ctx.texture_atlas.add(im))
 	{
-		this->renderer.get().shader->pos_tex->render(matrix, vao, this->tex_2d.get());
+		if (!this->atlas_entry) {
+			this->tex_2d = ctx.renderer.get().factory->create_texture_2d(std::move(im), {}).to_shared_ptr();
+		}
+	}
+
+	bool empty() const noexcept
+	{
+		return !this->atlas_entry && !this->tex_2d;
+	}
+
+	r4::vector2<uint32_t> dims() const noexcept
+	{
+		if (this->atlas_entry) {
+			return this->atlas_entry->dims();
+		}
+		ASSERT(this->tex_2d)
+		return this->tex_2d->dims();
+	}
+
+	texture_region get_region(const render::renderer& r) const
+	{
+		if (!this->atlas_entry) {
+			return {};
+		}
+		return this->atlas_entry->get_region(*r.factory);
+	}
+
+	void render(const render::renderer& r, const matrix4& matrix, const render::vertex_array& vao) const
+	{
+		ASSERT(!this->empty())
+
+		if (&vao == &r.pos_tex_quad_01_vao.get()) {
+			if (this->atlas_entry) {
+				auto region = this->atlas_entry->get_region(*r.factory);
+				r.render_quad(matrix, utki::shared_ref<const render::texture_2d>(region.tex), region.tex_rect);
+			} else {
+				r.render_quad(matrix, utki::shared_ref<const render::texture_2d>(this->tex_2d));
+			}
+			return;
+		}
+
+		// custom vertex array has texture coordinates for the whole texture, so render from separate texture
+		if (!this->tex_2d) {
+			ASSERT(this->atlas_entry)
+			this->tex_2d = r.factory->create_texture_2d(this->atlas_entry->get_image(), {}).to_shared_ptr();
+		}
+
+		r.flush();
+		r.shader->pos_tex->render(matrix, vao, *this->tex_2d);
 	}
 };
 
 class res_raster_image :
 	public image, //
-	public fixed_texture
+	public image::texture
 {
+	const bitmap_texture bitmap;
+
 public:
 	res_raster_image( //
 		utki::shared_ref<ruis::context> c,
-		utki::shared_ref<const render::texture_2d> tex
+		bitmap_texture bitmap
 	) :
 		image(std::move(c)),
-		fixed_texture( //
-			this->context.get().renderer,
-			std::move(tex)
-		)
+		image::texture(this->context.get().renderer, bitmap.dims()),
+		bitmap(std::move(bitmap))
 	{}
 
 	utki::shared_ref<const image::texture> get(vector2 for_dims) const override
@@ -152,7 +211,17 @@ public:
 
 	r4::vector2<uint32_t> dims() const noexcept override
 	{
-		return this->tex_2d.get().dims();
+		return this->bitmap.dims();
+	}
+
+	void render(const matrix4& matrix, const render::vertex_array& vao) const override
+	{
+		this->bitmap.render(this->renderer.get(), matrix, vao);
+	}
+
+	texture_region get_region() const override
+	{
+		return this->bitmap.get_region(this->renderer.get());
 	}
 
 	static utki::shared_ref<res_raster_image> load( //
@@ -160,29 +229,73 @@ public:
 		const papki::file& fi
 	)
 	{
-		return utki::make_shared<res_raster_image>(
-			std::move(ctx),
-			ctx.get().renderer.get().factory->create_texture_2d(
-				rasterimage::read(fi),
-				{
-					// TODO: what about params?
-				}
-			)
+		auto imvar = ctx.get().loader.read_file(fi, [](const papki::file& f) {
+			return rasterimage::read(f);
+		});
+
+		return make(std::move(ctx), std::move(imvar));
+	}
+
+	// decodes the image file on a worker thread, the texture is created on UI thread
+	static resource_loader::decoded_resource decode(const papki::file& fi)
+	{
+		auto imvar = std::make_shared<rasterimage::image_variant>(rasterimage::read(fi));
+
+		// the decoded resource is used only once, so the image can be moved out
+		return [imvar](const utki::shared_ref<ruis::context>& ctx) -> utki::shared_ref<resource> {
+			return make(ctx, std::move(*imvar));
+		};
+	}
+
+private:
+	static utki::shared_ref<res_raster_image> make( //
+		utki::shared_ref<ruis::context> ctx,
+		rasterimage::image_variant imvar
+	)
+	{
+		// only 8 bit RGBA images are packed to the atlas, since all atlas pages are of that format
+		if (imvar.get_format() == rasterimage::format::rgba && imvar.get_depth() == rasterimage::depth::uint_8_bit) {
+			auto& ctx_ref = ctx.get();
+			return utki::make_shared<res_raster_image>(
+				std::move(ctx),
+				bitmap_texture(
+					ctx_ref,
+					std::move(imvar.get<rasterimage::format::rgba, rasterimage::depth::uint_8_bit>())
+				)
+			);
+		}
+
+		auto tex = ctx.get().renderer.get().factory->create_texture_2d(
+			std::move(imvar),
+			{
+				// TODO: what about params?
+			}
 		);
+
+		return utki::make_shared<res_raster_image>(std::move(ctx), bitmap_texture(std::move(tex)));
 	}
 };
 
 class res_svg_image : public image
 {
-	std::unique_ptr<svgdom::svg_element> dom;
+	std::shared_ptr<const svgdom::svg_element> dom;
+
+	// hash of the SVG file contents, for raster cache keys
+	const uint64_t content_hash;
+
+	// the DOM is rasterized by worker threads in asynchronous rasterization mode,
+	// make sure it is not rasterized by several threads at the same time
+	const std::shared_ptr<std::mutex> dom_mutex = std::make_shared<std::mutex>();
 
 public:
 	res_svg_image( //
 		utki::shared_ref<ruis::context> c,
-		decltype(dom) dom
+		decltype(dom) dom,
+		uint64_t content_hash
 	) :
 		image(std::move(c)),
-		dom(std::move(dom))
+		dom(std::move(dom)),
+		content_hash(content_hash)
 	{}
 
 	r4::vector2<uint32_t> dims() const noexcept override
@@ -195,18 +308,27 @@ public:
 		return ceil(wh).to<uint32_t>();
 	}
 
-	class svg_texture : public fixed_texture
+	class svg_texture : public image::texture
 	{
 		std::weak_ptr<const res_svg_image> parent;
 
+		const r4::vector2<unsigned> cache_key;
+
+		// in asynchronous rasterization mode this is a bitmap of nearest rasterized size or empty,
+		// until the rasterization of requested size is finished
+		bitmap_texture bitmap;
+
 	public:
 		svg_texture(
 			utki::shared_ref<const ruis::render::renderer> r,
 			utki::shared_ref<const res_svg_image> parent,
-			utki::shared_ref<const render::texture_2d> tex
+			r4::vector2<unsigned> cache_key,
+			bitmap_texture bitmap
 		) :
-			fixed_texture(std::move(r), std::move(tex)),
-			parent(parent.to_shared_ptr())
+			image::texture(std::move(r), cache_key.to<uint32_t>()),
+			parent(parent.to_shared_ptr()),
+			cache_key(cache_key),
+			bitmap(std::move(bitmap))
 		{}
 
 		svg_texture(const svg_texture&) = delete;
@@ -219,18 +341,65 @@ public:
 		~svg_texture() override
 		{
 			if (auto p = this->parent.lock()) {
-				r4::vector2<unsigned> d = this->tex_2d.get().dims().to<unsigned>();
-				p->cache.erase(d);
+				p->cache.erase(this->cache_key);
 			}
 		}
+
+		const bitmap_texture& get_bitmap() const noexcept
+		{
+			return this->bitmap;
+		}
+
+		// called on UI thread when asynchronous rasterization is finished
+		void on_rasterized(rasterimage::image<uint8_t, 4> im)
+		{
+			auto p = this->parent.lock();
+			if (!p) {
+				// the image resource is gone, but the texture can still be in use
+				this->bitmap = bitmap_texture(this->renderer.get().factory->create_texture_2d(std::move(im), {}));
+				return;
+			}
+
+			this->bitmap = bitmap_texture(p->context.get(), std::move(im));
+			p->context.get().invalidate_appearance();
+		}
+
+		void render(const matrix4& matrix, const render::vertex_array& vao) const override
+		{
+			if (this->bitmap.empty()) {
+				// asynchronous rasterization has not finished yet
+				return;
+			}
+
+			this->bitmap.render(this->renderer.get(), matrix, vao);
+		}
+
+		texture_region get_region() const override
+		{
+			return this->bitmap.get_region(this->renderer.get());
+		}
 	};
 
 	utki::shared_ref<const texture> get(vector2 for_dims) const override
 	{
 		//		TRACE(<< "forDim = " << forDim << std::endl)
 
+		ASSERT(this->dom)
+
+		// in ruis, SVG dimensions are in pp, this is why we cannot use 0 to use native dimension of SVG.
+		if (for_dims.x() == 0 || for_dims.y() == 0) {
+			auto svg_dims = this->dims().to<real>();
+			for (unsigned i = 0; i != 2; ++i) {
+				if (for_dims[i] == 0) {
+					for_dims[i] = svg_dims[i];
+				}
+			}
+		}
+
+		auto dims = for_dims.to<unsigned>();
+
 		{ // check if in cache
-			auto i = this->cache.find(for_dims.to<unsigned>());
+			auto i = this->cache.find(dims);
 			if (i != this->cache.end()) {
 				if (auto p = i->second.lock()) {
 					ASSERT(p)
@@ -242,21 +411,21 @@ public:
 
 		auto& ctx = this->context.get();
 
-		ASSERT(this->dom)
-
-		// in ruis, SVG dimensions are in pp, this is why we cannot use 0 to use native dimension of SVG.
-		auto svg_dims = this->dims().to<real>();
-		for (unsigned i = 0; i != 2; ++i) {
-			if (for_dims[i] == 0) {
-				for_dims[i] = svg_dims[i];
-			}
-		}
-
 		svgren::parameters svg_params;
 		svg_params.dpi = unsigned(ctx.units.dots_per_inch());
-		svg_params.dims_request = for_dims.to<unsigned>();
+		svg_params.dims_request = dims;
 
-		auto im = svgren::rasterize(*this->dom, svg_params);
+		if (ctx.async_rasterization) {
+			return this->rasterize_async(dims, svg_params);
+		}
+
+		auto im = rasterize(
+			*this->dom,
+			*this->dom_mutex,
+			svg_params,
+			ctx.raster_cache.get(),
+			this->make_cache_key(svg_params)
+		);
 
 		ASSERT(im.dims().x() != 0)
 		ASSERT(im.dims().y() != 0)
@@ -264,17 +433,11 @@ public:
 			o << "im.dims = " << im.dims() << " pixels.size() = " << im.pixels().size();
 		})
 
-		auto dims = im.dims();
-
 		auto img = utki::make_shared<svg_texture>(
-			this->context.get().renderer,
+			ctx.renderer,
 			utki::make_shared_from(*this),
-			this->context.get().renderer.get().factory->create_texture_2d(
-				std::move(im),
-				{.min_filter = render::texture_2d::filter::nearest,
-				 .mag_filter = render::texture_2d::filter::nearest,
-				 .mipmap = render::texture_2d::mipmap::none}
-			)
+			dims,
+			bitmap_texture(ctx, std::move(im))
 		);
 
 		this->cache[dims] = img.to_shared_ptr();
@@ -282,20 +445,183 @@ public:
 		return img;
 	}
 
-	mutable std::map<r4::vector2<unsigned>, std::weak_ptr<texture>> cache;
+	mutable std::map<r4::vector2<unsigned>, std::weak_ptr<svg_texture>> cache;
+
+	// returns the SVG DOM and the hash of the file contents
+	static auto read(const papki::file& fi)
+	{
+		auto data = fi.load();
+		papki::span_file svg_file(utki::make_span(data));
+		return std::make_pair(svgdom::load(svg_file), raster_cache::hash(data));
+	}
 
 	static utki::shared_ref<res_svg_image> load( //
 		utki::shared_ref<ruis::context> ctx,
 		const papki::file& fi
 	)
 	{
-		auto dom = svgdom::load(fi);
+		auto [dom, content_hash] = ctx.get().loader.read_file(fi, [](const papki::file& f) {
+			return read(f);
+		});
+		ASSERT(dom)
+		return utki::make_shared<res_svg_image>(std::move(ctx), std::move(dom), content_hash);
+	}
+
+	// parses the SVG file on a worker thread
+	static resource_loader::decoded_resource decode(const papki::file& fi)
+	{
+		auto [dom, content_hash] = read(fi);
 		ASSERT(dom)
-		return utki::make_shared<res_svg_image>(std::move(ctx), std::move(dom));
+		return [dom = std::shared_ptr<const svgdom::svg_element>(std::move(dom)),
+				content_hash = content_hash](const utki::shared_ref<ruis::context>& ctx) -> utki::shared_ref<resource> {
+			return utki::make_shared<res_svg_image>(ctx, dom, content_hash);
+		};
+	}
+
+private:
+	uint64_t make_cache_key(const svgren::parameters& svg_params) const noexcept
+	{
+		return raster_cache::make_key(this->content_hash, "svg", svg_params.dims_request, svg_params.dpi);
+	}
+
+	// takes the bitmap from raster cache if possible, otherwise rasterizes the DOM and puts the bitmap to the cache
+	static rasterimage::image<uint8_t, 4> rasterize(
+		const svgdom::svg_element& dom,
+		std::mutex& dom_mutex,
+		const svgren::parameters& svg_params,
+		const raster_cache* cache,
+		uint64_t cache_key
+	)
+	{
+		if (cache) {
+			if (auto im = cache->get<4>(cache_key)) {
+				return std::move(im.value());
+			}
+		}
+
+		auto im = [&]() {
+			std::lock_guard lock(dom_mutex);
+			return svgren::rasterize(dom, svg_params);
+		}();
+
+		if (cache) {
+			cache->put(cache_key, im);
+		}
+
+		return im;
+	}
+
+	// returns bitmap of cached size nearest to the given one, empty bitmap if there are no rasterized sizes in cache
+	bitmap_texture find_nearest_bitmap(r4::vector2<unsigned> dims) const
+	{
+		bitmap_texture ret;
+		unsigned min_distance = std::numeric_limits<unsigned>::max();
+
+		for (const auto& [key, weak_tex] : this->cache) {
+			auto t = weak_tex.lock();
+			if (!t || t->get_bitmap().empty()) {
+				continue;
+			}
+
+			auto distance = [](unsigned a, unsigned b) {
+				return a > b ? a - b : b - a;
+			};
+
+			auto d = distance(key.x(), dims.x()) + distance(key.y(), dims.y());
+			if (d < min_distance) {
+				min_distance = d;
+				ret = t->get_bitmap();
+			}
+		}
+
+		return ret;
+	}
+
+	utki::shared_ref<const texture> rasterize_async(
+		r4::vector2<unsigned> dims,
+		const svgren::parameters& svg_params
+	) const
+	{
+		auto& ctx = this->context.get();
+
+		auto img = utki::make_shared<svg_texture>(
+			ctx.renderer,
+			utki::make_shared_from(*this),
+			dims,
+			this->find_nearest_bitmap(dims)
+		);
+
+		// the texture is also used to find out if the rasterization is still needed once it is finished
+		this->cache[dims] = img.to_shared_ptr();
+
+		// NOTE: the task must not hold references to the context, otherwise the context could be destroyed
+		//       from the worker thread, which would then wait for itself to finish
+		ctx.workers.push([dom = this->dom,
+						  dom_mutex = this->dom_mutex,
+						  svg_params,
+						  cache = ctx.raster_cache,
+						  cache_key = this->make_cache_key(svg_params),
+						  weak_img = std::weak_ptr<svg_texture>(img.to_shared_ptr()),
+						  post_to_ui_thread = ctx.post_to_ui_thread]() {
+			if (weak_img.expired()) {
+				// the texture is not needed anymore
+				return;
+			}
+
+			std::shared_ptr<rasterimage::image<uint8_t, 4>> im;
+			try {
+				im = std::make_shared<rasterimage::image<uint8_t, 4>>(
+					rasterize(*dom, *dom_mutex, svg_params, cache.get(), cache_key)
+				);
+			} catch (std::exception& e) {
+				LOG([&](auto& o) {
+					o << "res_svg_image: asynchronous rasterization failed: " << e.what() << std::endl;
+				})
+				return;
+			}
+
+			post_to_ui_thread([weak_img, im]() {
+				// textures are destroyed only on UI thread, so it is safe to lock the weak pointer here
+				if (auto img = weak_img.lock()) {
+					img->on_rasterized(std::move(*im));
+				}
+			});
+		});
+
+		return img;
 	}
 };
 } // namespace
 
+resource_loader::decoded_resource image::decode( //
+	const tml::forest& desc,
+	const resource_loader::resource_files& files
+)
+{
+	for (auto& p : desc) {
+		if (p.value == "file") {
+			auto i = files.find(get_property_value(p).string);
+			if (i == files.end()) {
+				// the file could not be read, loading on UI thread will report the error
+				return nullptr;
+			}
+
+			papki::span_file fi(i->second.get().data());
+			// the image format is determined by file name suffix
+			fi.set_path(i->first);
+
+			if (fi.suffix().compare("svg") == 0) {
+				return res_svg_image::decode(fi);
+			} else {
+				return res_raster_image::decode(fi);
+			}
+		}
+	}
+
+	// atlas images are loaded on UI thread
+	return nullptr;
+}
+
 utki::shared_ref<image> image::load( //
 	utki::shared_ref<ruis::context> ctx,
 	const tml::forest& desc,
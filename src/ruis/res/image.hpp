@@ -30,6 +30,7 @@ along with this program. If not, see <http://www.gnu.org/licenses/>.
 #include "../resource_loader.hpp"
 
 #include "texture_2d.hpp"
+#include "texture_atlas.hpp"
 
 namespace ruis::res {
 
@@ -99,6 +100,18 @@ public:
 		 * @param vao - vertex array to use for rendering.
 		 */
 		virtual void render(const matrix4& matrix, const render::vertex_array& vao) const = 0;
+
+		/**
+		 * @brief Get texture region of this texture's image.
+		 * In case the image is packed to a texture atlas, returns the region of the atlas texture occupied
+		 * by the image. Such regions are only valid until the atlas is modified, so they are not to be stored.
+		 * @return Texture region of the image.
+		 * @return Region with no texture in case the image is not packed to an atlas.
+		 */
+		virtual texture_region get_region() const
+		{
+			return {};
+		}
 	};
 
 	/**
@@ -116,6 +129,13 @@ public:
 	virtual utki::shared_ref<const texture> get(vector2 for_dims = 0) const = 0;
 
 private:
+	constexpr static std::array<std::string_view, 1> file_properties = {"file"};
+
+	static resource_loader::decoded_resource decode(
+		const ::tml::forest& desc, //
+		const resource_loader::resource_files& files
+	);
+
 	static utki::shared_ref<image> load(
 		utki::shared_ref<ruis::context> ctx,
 		const ::tml::forest& desc,
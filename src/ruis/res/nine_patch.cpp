@@ -40,7 +40,11 @@ class res_subimage :
 
 	const utki::shared_ref<const res::image::texture> tex;
 
-	const utki::shared_ref<const render::vertex_array> vao;
+	// rectangle on the texture in normalized texture coordinates, Y axis down
+	const r4::rectangle<float> tex_rect;
+
+	// created only if the texture is not packed to a texture atlas
+	mutable std::shared_ptr<const render::vertex_array> vao;
 
 public:
 	// rect is a rectangle on the texture, Y axis down.
@@ -60,24 +64,10 @@ public:
 			}()
 		),
 		tex(std::move(tex)),
-		vao([&]() {
-			std::array<vector2, 4> tex_coords = {
-				rect.p.comp_div(this->tex.get().dims().to<real>()),
-				rect.x1_y2().comp_div(this->tex.get().dims().to<real>()),
-				rect.x2_y2().comp_div(this->tex.get().dims().to<real>()),
-				rect.x2_y1().comp_div(this->tex.get().dims().to<real>()),
-			};
-
-			// TRACE(<< "this->tex_coords = (" << tex_coords[0] << ", " << tex_coords[1] << ", " << tex_coords[2] << ",
-			// " << tex_coords[3] << ")" << std::endl)
-
-			const auto& r = this->context.get().renderer.get();
-			return r.factory->create_vertex_array(
-				{r.quad_01_vbo, r.factory->create_vertex_buffer(tex_coords)},
-				r.quad_indices,
-				render::vertex_array::mode::triangle_fan
-			);
-		}())
+		tex_rect(
+			rect.p.comp_div(this->tex.get().dims().to<real>()), //
+			rect.d.comp_div(this->tex.get().dims().to<real>())
+		)
 	{}
 
 	res_subimage(const res_subimage&) = delete;
@@ -100,7 +90,48 @@ public:
 
 	void render(const matrix4& matrix, const render::vertex_array& vao) const override
 	{
-		this->tex.get().render(matrix, this->vao.get());
+		// in case the texture is packed to an atlas, render the sub-rectangle of its atlas region,
+		// so that all parts of the nine-patch are rendered from the same texture without extra vertex arrays
+		if (auto region = this->get_region(); region.tex) {
+			this->renderer.get().render_quad(
+				matrix,
+				utki::shared_ref<const render::texture_2d>(std::move(region.tex)),
+				region.tex_rect
+			);
+			return;
+		}
+
+		if (!this->vao) {
+			std::array<vector2, 4> tex_coords = {
+				this->tex_rect.p,
+				this->tex_rect.x1_y2(),
+				this->tex_rect.x2_y2(),
+				this->tex_rect.x2_y1(),
+			};
+
+			const auto& r = this->renderer.get();
+			this->vao = r.factory
+							->create_vertex_array(
+								{r.quad_01_vbo, r.factory->create_vertex_buffer(tex_coords)},
+								r.quad_indices,
+								render::vertex_array::mode::triangle_fan
+							)
+							.to_shared_ptr();
+		}
+
+		this->tex.get().render(matrix, *this->vao);
+	}
+
+	texture_region get_region() const override
+	{
+		auto region = this->tex.get().get_region();
+		if (region.tex) {
+			region.tex_rect = {
+				region.tex_rect.p + this->tex_rect.p.comp_mul(region.tex_rect.d),
+				this->tex_rect.d.comp_mul(region.tex_rect.d)
+			};
+		}
+		return region;
 	}
 };
 
@@ -114,6 +114,8 @@ public:
 private:
 	mutable std::map<real, std::weak_ptr<image_matrix>> cache;
 
+	constexpr static std::array<std::string_view, 1> file_properties = {"file"};
+
 	static utki::shared_ref<nine_patch> load(
 		utki::shared_ref<ruis::context> ctx,
 		const ::tml::forest& desc,
@@ -92,7 +92,12 @@ utki::shared_ref<texture_2d> texture_2d::load(
 	}
 
 	auto tex = ctx.get().renderer.get().factory->create_texture_2d( //
-		rasterimage::read(fi),
+		ctx.get().loader.read_file(
+			fi,
+			[](const papki::file& f) {
+				return rasterimage::read(f);
+			}
+		),
 		std::move(params)
 	);
 
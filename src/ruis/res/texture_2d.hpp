@@ -84,6 +84,8 @@ public:
 	}
 
 private:
+	constexpr static std::array<std::string_view, 1> file_properties = {"file"};
+
 	static utki::shared_ref<texture_2d> load( //
 		utki::shared_ref<ruis::context> ctx,
 		const ::tml::forest& desc,
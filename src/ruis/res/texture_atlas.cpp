@@ -0,0 +1,546 @@
+/*
+ruis - GUI framework
+
+Copyright (C) 2012-2024  Ivan Gagis <igagis@gmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* ================ LICENSE END ================ */
+
+#include "texture_atlas.hpp"
+
+#include <algorithm>
+#include <limits>
+
+#include <rasterimage/image_variant.hpp>
+#include <utki/debug.hpp>
+
+using namespace ruis;
+using namespace ruis::res;
+
+namespace {
+// width of the border around each image, filled with the image's edge pixels
+constexpr uint32_t border = 1;
+
+// pages start small and grow on demand up to the maximum page size
+constexpr uint32_t initial_page_size = 256;
+
+using rgba_image = rasterimage::image<uint8_t, 4>;
+
+rasterimage::image_variant make_page_image(r4::vector2<uint32_t> dims)
+{
+	rasterimage::image_variant ret(
+		dims, //
+		rasterimage::format::rgba,
+		rasterimage::depth::uint_8_bit
+	);
+
+	auto& im = ret.get<rasterimage::format::rgba, rasterimage::depth::uint_8_bit>();
+	using pixel_type = std::remove_reference_t<decltype(im)>::pixel_type;
+	for (uint32_t y = 0; y != im.dims().y(); ++y) {
+		auto line = im[y];
+		std::fill(line.begin(), line.end(), pixel_type{});
+	}
+
+	return ret;
+}
+
+// copies the image to the given position along with the border made of the image's edge pixels,
+// pos is the position of the image's top left corner without border
+void blit_with_border(rgba_image& dst, r4::vector2<uint32_t> pos, const rgba_image& src)
+{
+	ASSERT(pos.x() >= border && pos.y() >= border)
+	ASSERT(pos.x() + src.dims().x() + border <= dst.dims().x())
+	ASSERT(pos.y() + src.dims().y() + border <= dst.dims().y())
+
+	auto clamp = [](uint32_t v, uint32_t max) {
+		return std::min(v, max - 1);
+	};
+
+	for (uint32_t y = 0; y != src.dims().y() + 2 * border; ++y) {
+		auto src_line = src[clamp(y > border ? y - border : 0, src.dims().y())];
+		auto dst_line = dst[pos.y() - border + y];
+		auto dst_i = utki::next(dst_line.begin(), pos.x() - border);
+
+		std::fill_n(dst_i, border, src_line.front());
+		dst_i = std::copy(src_line.begin(), src_line.end(), utki::next(dst_i, border));
+		std::fill_n(dst_i, border, src_line.back());
+	}
+}
+
+// copies the rectangle of the source image to the given position of the destination image
+void copy_rect(rgba_image& dst, r4::vector2<uint32_t> pos, const rgba_image& src, r4::rectangle<uint32_t> rect)
+{
+	for (uint32_t y = 0; y != rect.d.y(); ++y) {
+		auto src_line = src[rect.p.y() + y];
+		auto src_begin = utki::next(src_line.begin(), rect.p.x());
+		std::copy(src_begin, utki::next(src_begin, rect.d.x()), utki::next(dst[pos.y() + y].begin(), pos.x()));
+	}
+}
+
+/**
+ * Skyline rectangle packer.
+ * Keeps the skyline, i.e. the top edge of the packed rectangles, as a list of horizontal segments.
+ * Places each new rectangle where its bottom edge is the lowest.
+ */
+class skyline
+{
+	r4::vector2<uint32_t> dims;
+
+	struct node {
+		uint32_t x;
+		uint32_t y;
+		uint32_t width;
+	};
+
+	// sorted by x, cover the whole width
+	std::vector<node> nodes;
+
+	// returns y position of the rectangle placed at the node, std::nullopt if it does not fit there
+	std::optional<uint32_t> fit(size_t i, r4::vector2<uint32_t> d) const
+	{
+		if (this->nodes[i].x + d.x() > this->dims.x()) {
+			return std::nullopt;
+		}
+
+		uint32_t y = 0;
+		for (uint32_t width_left = d.x(); width_left != 0; ++i) {
+			ASSERT(i < this->nodes.size())
+			y = std::max(y, this->nodes[i].y);
+			if (y + d.y() > this->dims.y()) {
+				return std::nullopt;
+			}
+			width_left -= std::min(width_left, this->nodes[i].width);
+		}
+
+		return y;
+	}
+
+public:
+	skyline(r4::vector2<uint32_t> dims) :
+		dims(dims),
+		nodes{{.x = 0, .y = 0, .width = dims.x()}}
+	{}
+
+	// enlarges the packing area, already packed rectangles stay where they are
+	void grow(r4::vector2<uint32_t> new_dims)
+	{
+		ASSERT(new_dims.x() >= this->dims.x() && new_dims.y() >= this->dims.y())
+
+		if (new_dims.x() != this->dims.x()) {
+			if (this->nodes.back().y == 0) {
+				this->nodes.back().width += new_dims.x() - this->dims.x();
+			} else {
+				this->nodes.push_back({.x = this->dims.x(), .y = 0, .width = new_dims.x() - this->dims.x()});
+			}
+		}
+
+		this->dims = new_dims;
+	}
+
+	std::optional<r4::vector2<uint32_t>> add(r4::vector2<uint32_t> d)
+	{
+		size_t best = this->nodes.size();
+		uint32_t best_y = 0;
+		uint32_t best_bottom = std::numeric_limits<uint32_t>::max();
+		uint32_t best_width = std::numeric_limits<uint32_t>::max();
+
+		for (size_t i = 0; i != this->nodes.size(); ++i) {
+			auto y = this->fit(i, d);
+			if (!y) {
+				continue;
+			}
+
+			auto bottom = y.value() + d.y();
+			if (bottom < best_bottom || (bottom == best_bottom && this->nodes[i].width < best_width)) {
+				best = i;
+				best_y = y.value();
+				best_bottom = bottom;
+				best_width = this->nodes[i].width;
+			}
+		}
+
+		if (best == this->nodes.size()) {
+			return std::nullopt;
+		}
+
+		r4::vector2<uint32_t> pos = {this->nodes[best].x, best_y};
+
+		this->nodes.insert(
+			utki::next(this->nodes.begin(), best),
+			{.x = pos.x(), .y = best_bottom, .width = d.x()}
+		);
+
+		// cut the segments covered by the new one
+		for (size_t i = best + 1; i != this->nodes.size();) {
+			const auto& prev = this->nodes[i - 1];
+			auto& n = this->nodes[i];
+
+			auto prev_end = prev.x + prev.width;
+			if (n.x >= prev_end) {
+				break;
+			}
+
+			auto overlap = prev_end - n.x;
+			if (n.width <= overlap) {
+				this->nodes.erase(utki::next(this->nodes.begin(), i));
+				continue;
+			}
+
+			n.x += overlap;
+			n.width -= overlap;
+			break;
+		}
+
+		// merge neighbour segments of same height
+		for (size_t i = 0; i + 1 < this->nodes.size();) {
+			if (this->nodes[i].y == this->nodes[i + 1].y) {
+				this->nodes[i].width += this->nodes[i + 1].width;
+				this->nodes.erase(utki::next(this->nodes.begin(), i + 1));
+			} else {
+				++i;
+			}
+		}
+
+		return pos;
+	}
+};
+
+size_t area(r4::vector2<uint32_t> d)
+{
+	return size_t(d.x()) * size_t(d.y());
+}
+
+r4::vector2<uint32_t> with_border(r4::vector2<uint32_t> d)
+{
+	return d + r4::vector2<uint32_t>(2 * border);
+}
+} // namespace
+
+class texture_atlas::page
+{
+public:
+	const uint32_t max_size;
+
+	skyline packer;
+
+	rasterimage::image_variant image;
+
+	std::vector<entry*> entries;
+
+	// area of live images, including borders
+	size_t used_area = 0;
+
+	// area packed since the last repacking, including borders of removed images
+	size_t packed_area = 0;
+
+	std::shared_ptr<render::texture_2d> tex;
+
+	// area of the image changed since the texture was uploaded
+	std::optional<r4::rectangle<uint32_t>> dirty_rect;
+
+	page(uint32_t max_size) :
+		max_size(max_size),
+		packer(r4::vector2<uint32_t>(std::min(initial_page_size, max_size))),
+		image(make_page_image(r4::vector2<uint32_t>(std::min(initial_page_size, max_size))))
+	{}
+
+	r4::vector2<uint32_t> dims() const noexcept
+	{
+		return this->image.dims();
+	}
+
+	rgba_image& get_image()
+	{
+		return this->image.get<rasterimage::format::rgba, rasterimage::depth::uint_8_bit>();
+	}
+
+	void mark_dirty(const r4::rectangle<uint32_t>& rect)
+	{
+		if (!this->dirty_rect.has_value()) {
+			this->dirty_rect = rect;
+			return;
+		}
+
+		auto& d = this->dirty_rect.value();
+		auto end = d.x2_y2();
+		auto rect_end = rect.x2_y2();
+		for (size_t i = 0; i != d.p.size(); ++i) {
+			d.p[i] = std::min(d.p[i], rect.p[i]);
+			end[i] = std::max(end[i], rect_end[i]);
+		}
+		d.d = end - d.p;
+	}
+
+	// doubles the page dimensions, returns false if the page cannot grow anymore
+	bool grow()
+	{
+		auto dims = this->dims();
+		if (dims.x() >= this->max_size && dims.y() >= this->max_size) {
+			return false;
+		}
+
+		r4::vector2<uint32_t> new_dims = {
+			std::min(dims.x() * 2, this->max_size), //
+			std::min(dims.y() * 2, this->max_size)
+		};
+
+		auto new_image = make_page_image(new_dims);
+		copy_rect(
+			new_image.get<rasterimage::format::rgba, rasterimage::depth::uint_8_bit>(),
+			{0, 0},
+			this->get_image(),
+			{{0, 0}, dims}
+		);
+
+		this->packer.grow(new_dims);
+		this->image = std::move(new_image);
+
+		// texture of different dimensions is needed
+		this->tex.reset();
+		this->dirty_rect.reset();
+
+		return true;
+	}
+
+	// returns position of the image without border, std::nullopt if there is no room for the image
+	std::optional<r4::vector2<uint32_t>> add(const rgba_image& im)
+	{
+		auto pos = this->packer.add(with_border(im.dims()));
+		while (!pos) {
+			if (!this->grow()) {
+				return std::nullopt;
+			}
+			pos = this->packer.add(with_border(im.dims()));
+		}
+
+		auto image_pos = pos.value() + r4::vector2<uint32_t>(border);
+
+		blit_with_border(this->get_image(), image_pos, im);
+
+		auto a = area(with_border(im.dims()));
+		this->used_area += a;
+		this->packed_area += a;
+
+		this->mark_dirty({pos.value(), with_border(im.dims())});
+
+		return image_pos;
+	}
+
+	bool is_fragmented() const noexcept
+	{
+		return this->used_area * 2 < this->packed_area;
+	}
+
+	// repacks live images to reclaim space of removed ones
+	void repack()
+	{
+		// pack higher images first, this gives better packing
+		auto sorted = this->entries;
+		std::sort(sorted.begin(), sorted.end(), [](const entry* a, const entry* b) {
+			return a->rect.d.y() > b->rect.d.y();
+		});
+
+		skyline new_packer(this->dims());
+
+		std::vector<r4::vector2<uint32_t>> positions;
+		positions.reserve(sorted.size());
+		for (const auto* e : sorted) {
+			auto pos = new_packer.add(with_border(e->rect.d));
+			if (!pos) {
+				// should not normally happen, leave the page as is
+				return;
+			}
+			positions.push_back(pos.value());
+		}
+
+		auto new_image = make_page_image(this->dims());
+		auto& dst = new_image.get<rasterimage::format::rgba, rasterimage::depth::uint_8_bit>();
+		const auto& src = this->get_image();
+
+		for (size_t i = 0; i != sorted.size(); ++i) {
+			auto* e = sorted[i];
+			auto border_vec = r4::vector2<uint32_t>(border);
+
+			copy_rect(dst, positions[i], src, {e->rect.p - border_vec, with_border(e->rect.d)});
+			e->rect.p = positions[i] + border_vec;
+		}
+
+		this->packer = std::move(new_packer);
+		this->image = std::move(new_image);
+		this->packed_area = this->used_area;
+
+		// Live images have moved, so the old texture cannot be updated in place:
+		// quads recorded to a deferred draw list earlier this frame still sample it with old texture coordinates.
+		this->tex.reset();
+		this->dirty_rect.reset();
+	}
+
+	// uploads changes of the page image to the texture
+	void upload(render::factory& f)
+	{
+		if (this->tex && this->dirty_rect.has_value()) {
+			const auto& d = this->dirty_rect.value();
+
+			rasterimage::image_variant part(d.d, rasterimage::format::rgba, rasterimage::depth::uint_8_bit);
+			copy_rect(
+				part.get<rasterimage::format::rgba, rasterimage::depth::uint_8_bit>(),
+				{0, 0},
+				this->get_image(),
+				d
+			);
+
+			if (!this->tex->update(d.p, part)) {
+				// the renderer backend does not support partial texture updates
+				this->tex.reset();
+			}
+		}
+
+		this->dirty_rect.reset();
+
+		if (!this->tex) {
+			auto t = f.create_texture_2d(
+				this->image,
+				{.min_filter = render::texture_2d::filter::nearest,
+				 .mag_filter = render::texture_2d::filter::nearest,
+				 .mipmap = render::texture_2d::mipmap::none}
+			);
+			this->tex = t.to_shared_ptr();
+		}
+	}
+};
+
+texture_atlas::texture_atlas(uint32_t max_page_size, uint32_t max_image_size) :
+	max_page_size(max_page_size),
+	max_image_size(std::min(max_image_size, max_page_size - 2 * border))
+{}
+
+texture_atlas::~texture_atlas() = default;
+
+void texture_atlas::remove_page(const page& p)
+{
+	auto i = std::find_if(this->pages.begin(), this->pages.end(), [&p](const auto& pg) {
+		return pg.get() == &p;
+	});
+	if (i != this->pages.end()) {
+		this->pages.erase(i);
+	}
+}
+
+std::shared_ptr<const texture_atlas::entry> texture_atlas::add(const rasterimage::image<uint8_t, 4>& im)
+{
+	if (im.dims().x() > this->max_image_size || im.dims().y() > this->max_image_size) {
+		return nullptr;
+	}
+
+	if (im.dims().x() == 0 || im.dims().y() == 0) {
+		return nullptr;
+	}
+
+	auto make_entry = [&](const std::shared_ptr<page>& p, r4::vector2<uint32_t> pos) {
+		auto e = std::make_shared<entry>(*this, p, r4::rectangle<uint32_t>(pos, im.dims()));
+		p->entries.push_back(e.get());
+		return e;
+	};
+
+	for (const auto& p : this->pages) {
+		if (auto pos = p->add(im)) {
+			return make_entry(p, pos.value());
+		}
+	}
+
+	// compact the pages which have removed images
+	for (const auto& p : this->pages) {
+		if (p->packed_area == p->used_area) {
+			continue;
+		}
+		p->repack();
+		if (auto pos = p->add(im)) {
+			return make_entry(p, pos.value());
+		}
+	}
+
+	auto p = std::make_shared<page>(this->max_page_size);
+	this->pages.push_back(p);
+
+	auto pos = p->add(im);
+	ASSERT(pos)
+	return make_entry(p, pos.value());
+}
+
+void texture_atlas::compact()
+{
+	for (const auto& p : this->pages) {
+		if (p->is_fragmented()) {
+			p->repack();
+		}
+	}
+}
+
+texture_atlas::entry::entry(
+	texture_atlas& atlas,
+	const std::shared_ptr<page>& owner_page,
+	r4::rectangle<uint32_t> rect
+) :
+	atlas(atlas),
+	owner_page(owner_page),
+	rect(rect)
+{}
+
+texture_atlas::entry::~entry()
+{
+	auto p = this->owner_page.lock();
+	if (!p) {
+		return;
+	}
+
+	auto i = std::find(p->entries.begin(), p->entries.end(), this);
+	ASSERT(i != p->entries.end())
+	p->entries.erase(i);
+
+	// the freed space is reclaimed later, by texture_atlas::add() or texture_atlas::compact()
+	p->used_area -= area(with_border(this->rect.d));
+
+	if (p->entries.empty()) {
+		this->atlas.remove_page(*p);
+	}
+}
+
+texture_region texture_atlas::entry::get_region(render::factory& f) const
+{
+	auto p = this->owner_page.lock();
+	ASSERT(p)
+
+	if (!p->tex || p->dirty_rect.has_value()) {
+		p->upload(f);
+	}
+
+	auto page_dims = p->dims().to<float>();
+
+	return {
+		.tex = p->tex,
+		.tex_rect = {this->rect.p.to<float>().comp_div(page_dims), this->rect.d.to<float>().comp_div(page_dims)}
+	};
+}
+
+rasterimage::image<uint8_t, 4> texture_atlas::entry::get_image() const
+{
+	auto p = this->owner_page.lock();
+	ASSERT(p)
+
+	rgba_image ret(this->rect.d);
+	copy_rect(ret, {0, 0}, p->get_image(), this->rect);
+	return ret;
+}
@@ -0,0 +1,169 @@
+/*
+ruis - GUI framework
+
+Copyright (C) 2012-2024  Ivan Gagis <igagis@gmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* ================ LICENSE END ================ */
+
+#pragma once
+
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include <r4/rectangle.hpp>
+#include <rasterimage/image.hpp>
+
+#include "../render/factory.hpp"
+#include "../render/texture_2d.hpp"
+
+namespace ruis::res {
+
+/**
+ * @brief Part of a 2d texture.
+ */
+struct texture_region {
+	/**
+	 * @brief The texture.
+	 */
+	std::shared_ptr<const render::texture_2d> tex;
+
+	/**
+	 * @brief Texture coordinates of the region.
+	 * Normalized texture coordinates, Y axis down.
+	 */
+	r4::rectangle<float> tex_rect{0, 1};
+};
+
+/**
+ * @brief Texture atlas for small images.
+ * Small images are packed into shared atlas pages, so that rendering of many small images,
+ * like icons, does not require switching textures.
+ * The images are packed with skyline packing algorithm. Each image is surrounded by one pixel wide
+ * border of its edge pixels, so that filtering of the texture does not bleed neighbouring images.
+ * Pages start small and grow on demand, up to the maximum page size.
+ * When images are removed from the atlas, the freed space is not reused right away. The images of the page
+ * are repacked when a new image does not fit into the page, or by compact().
+ * Pages are kept in memory and uploaded to textures lazily, when their textures are requested
+ * after images were added or repacked. When images were added, only the changed area of the page is uploaded,
+ * in case the renderer backend supports partial texture updates. Repacked or grown pages get new textures,
+ * so that the quads already rendered with the old texture regions are not affected.
+ */
+class texture_atlas
+{
+	class page;
+
+	std::vector<std::shared_ptr<page>> pages;
+
+	const uint32_t max_page_size;
+	const uint32_t max_image_size;
+
+	void remove_page(const page& p);
+
+public:
+	/**
+	 * @brief Image packed to the atlas.
+	 * The image stays in the atlas as long as the entry object is alive.
+	 */
+	class entry
+	{
+		friend class texture_atlas;
+		friend class page;
+
+		texture_atlas& atlas;
+		std::weak_ptr<page> owner_page;
+
+		// position of the image within the page, without border
+		r4::rectangle<uint32_t> rect;
+
+	public:
+		entry(texture_atlas& atlas, const std::shared_ptr<page>& owner_page, r4::rectangle<uint32_t> rect);
+
+		entry(const entry&) = delete;
+		entry& operator=(const entry&) = delete;
+
+		entry(entry&&) = delete;
+		entry& operator=(entry&&) = delete;
+
+		~entry();
+
+		/**
+		 * @brief Get image dimensions.
+		 * @return Image dimensions in pixels.
+		 */
+		r4::vector2<uint32_t> dims() const noexcept
+		{
+			return this->rect.d;
+		}
+
+		/**
+		 * @brief Get texture region of the image.
+		 * Uploads changes of the atlas page to its texture in case it has changed since last upload.
+		 * Since the images can be repacked, the region is only valid until the atlas is modified.
+		 * @param f - factory to create the texture with.
+		 * @return Texture region of the image.
+		 */
+		texture_region get_region(render::factory& f) const;
+
+		/**
+		 * @brief Get image pixels.
+		 * @return Copy of the image.
+		 */
+		rasterimage::image<uint8_t, 4> get_image() const;
+	};
+
+	/**
+	 * @brief Constructor.
+	 * @param max_page_size - maximum width and height of atlas pages.
+	 * @param max_image_size - maximum width and height of images to pack to the atlas.
+	 */
+	texture_atlas(uint32_t max_page_size, uint32_t max_image_size);
+
+	texture_atlas(const texture_atlas&) = delete;
+	texture_atlas& operator=(const texture_atlas&) = delete;
+
+	texture_atlas(texture_atlas&&) = delete;
+	texture_atlas& operator=(texture_atlas&&) = delete;
+
+	~texture_atlas();
+
+	/**
+	 * @brief Add image to the atlas.
+	 * @param im - image to add.
+	 * @return Atlas entry of the image.
+	 * @return nullptr if the image is too big for the atlas.
+	 */
+	std::shared_ptr<const entry> add(const rasterimage::image<uint8_t, 4>& im);
+
+	/**
+	 * @brief Repack fragmented pages.
+	 * Reclaims the space of removed images in pages where less than half of the packed area
+	 * is used by live images. Texture regions of the images of repacked pages become invalid.
+	 */
+	void compact();
+
+	/**
+	 * @brief Get number of atlas pages.
+	 * @return Number of atlas pages.
+	 */
+	size_t num_pages() const noexcept
+	{
+		return this->pages.size();
+	}
+};
+
+} // namespace ruis::res
@@ -82,13 +82,20 @@ utki::shared_ref<texture_cube> texture_cube::load(
 		}
 	}
 
+	auto read = [&](std::string_view file, std::string_view field_name) {
+		fi.set_path(check_not_empty(file, field_name));
+		return ctx.get().loader.read_file(fi, [](const papki::file& f) {
+			return rasterimage::read(f);
+		});
+	};
+
 	auto tex = ctx.get().renderer.get().factory->create_texture_cube( //
-		rasterimage::read(fi.set_path(check_not_empty(file_px, file_px_param))),
-		rasterimage::read(fi.set_path(check_not_empty(file_nx, file_nx_param))),
-		rasterimage::read(fi.set_path(check_not_empty(file_py, file_py_param))),
-		rasterimage::read(fi.set_path(check_not_empty(file_ny, file_ny_param))),
-		rasterimage::read(fi.set_path(check_not_empty(file_pz, file_pz_param))),
-		rasterimage::read(fi.set_path(check_not_empty(file_nz, file_nz_param)))
+		read(file_px, file_px_param),
+		read(file_nx, file_nx_param),
+		read(file_py, file_py_param),
+		read(file_ny, file_ny_param),
+		read(file_pz, file_pz_param),
+		read(file_nz, file_nz_param)
 	);
 
 	return utki::make_shared<texture_cube>( //
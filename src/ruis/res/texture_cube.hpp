@@ -90,6 +90,15 @@ public:
 	}
 
 private:
+	constexpr static std::array<std::string_view, 6> file_properties = {
+		"file_px",
+		"file_nx",
+		"file_py",
+		"file_ny",
+		"file_pz",
+		"file_nz"
+	};
+
 	static utki::shared_ref<texture_cube> load( //
 		utki::shared_ref<ruis::context> ctx,
 		const ::tml::forest& desc,
@@ -21,9 +21,17 @@ along with this program. If not, see <http://www.gnu.org/licenses/>.
 
 #include "resource_loader.hpp"
 
+#include <algorithm>
+#include <tuple>
+
+#include <papki/fs_file.hpp>
 #include <papki/root_dir.hpp>
 #include <papki/util.hpp>
 
+#include "context.hpp"
+#include "util/binary_tml.hpp"
+#include "util/mapped_file.hpp"
+#include "util/raster_cache.hpp"
 #include "util/util.hpp"
 
 using namespace ruis;
@@ -31,6 +39,52 @@ using namespace ruis;
 namespace {
 constexpr const char* wording_include = "include";
 constexpr const char* wording_include_subdirs = "include_subdirs";
+
+constexpr std::string_view compiled_script_suffix = ".bin";
+
+// hash of the resource pack script text, compiled script is only valid for the text with the same hash
+uint64_t hash_res_script(const papki::file& fi)
+{
+	return raster_cache::hash(mapped_file::load(fi).get().data());
+}
+
+// reads resource pack script, compiled version of the script is used instead if there is a valid one
+// which is compiled from the current script text
+tml::forest read_res_script(const papki::file& fi)
+{
+	auto path = fi.path();
+
+	fi.set_path(path + std::string(compiled_script_suffix));
+	if (fi.exists()) {
+		try {
+			auto compiled = mapped_file::load(fi);
+			fi.set_path(path);
+			return from_binary_tml(compiled.get().data(), hash_res_script(fi));
+		} catch (std::exception& e) {
+			LOG([&](auto& o) {
+				o << "could not read compiled resource script " << fi.path() << ": " << e.what() << std::endl;
+			})
+		}
+	}
+
+	fi.set_path(path);
+	return tml::read(fi);
+}
+
+// makes sure that contents of the memory mapped file are actually read from the storage
+void touch_pages(utki::span<const uint8_t> data)
+{
+	constexpr size_t min_page_size = 4096;
+
+	uint8_t sum = 0;
+	for (size_t i = 0; i < data.size(); i += min_page_size) {
+		sum ^= data[i];
+	}
+
+	// prevent the loop from being optimized out
+	volatile uint8_t sink = sum;
+	std::ignore = sink;
+}
 } // namespace
 
 decltype(resource_loader::res_packs)::const_iterator resource_loader::mount_res_pack(const papki::file& fi)
@@ -43,7 +97,7 @@ decltype(resource_loader::res_packs)::const_iterator resource_loader::mount_res_
 		fi.set_path(dir + "main.res");
 	}
 
-	auto script = tml::read(fi);
+	auto script = read_res_script(fi);
 	ASSERT(!fi.is_open())
 
 	// handle includes
@@ -64,19 +118,326 @@ decltype(resource_loader::res_packs)::const_iterator resource_loader::mount_res_
 		}
 	}
 
-	this->res_packs.emplace_back(papki::root_dir::make(fi.spawn(), dir), std::move(script));
+	std::optional<std::string> fs_dir;
+	if (dynamic_cast<const papki::fs_file*>(&fi)) {
+		fs_dir = dir;
+	}
+
+	this->res_packs.emplace_back(papki::root_dir::make(fi.spawn(), dir), std::move(script), std::move(fs_dir));
 
 	ASSERT(this->res_packs.back().fi)
 	ASSERT(!this->res_packs.back().script.empty())
 
+	this->add_to_res_index(this->res_packs.back());
+
 	return std::prev(this->res_packs.end());
 }
 
+std::vector<uint8_t> resource_loader::compile_res_script(const papki::file& fi)
+{
+	return to_binary_tml(tml::read(fi), hash_res_script(fi));
+}
+
 void resource_loader::unmount_res_pack(decltype(res_packs)::const_iterator id)
 {
+	this->remove_from_res_index(*id);
+
+	for (auto i = this->prefetched_files.begin(); i != this->prefetched_files.end();) {
+		if (i->first.first == id->fi.get()) {
+			i = this->prefetched_files.erase(i);
+		} else {
+			++i;
+		}
+	}
+
+	for (auto i = this->prefetched_resources.begin(); i != this->prefetched_resources.end();) {
+		if (i->second.pack_fi == id->fi.get()) {
+			i = this->prefetched_resources.erase(i);
+		} else {
+			++i;
+		}
+	}
+
+	for (auto i = this->prefetched_ids.begin(); i != this->prefetched_ids.end();) {
+		auto& keys = i->second;
+		keys.erase(
+			std::remove_if(
+				keys.begin(),
+				keys.end(),
+				[&](const auto& k) {
+					return k.first == id->fi.get();
+				}
+			),
+			keys.end()
+		);
+		if (keys.empty()) {
+			i = this->prefetched_ids.erase(i);
+		} else {
+			++i;
+		}
+	}
+
 	this->res_packs.erase(id);
 }
 
+void resource_loader::prefetch(
+	std::string_view id,
+	utki::span<const std::string_view> file_properties,
+	decoder_type decode,
+	std::function<void()> on_ready
+)
+{
+	if (auto p = this->pending_prefetches.find(id); p != this->pending_prefetches.end()) {
+		p->second.push_back(std::move(on_ready));
+		return;
+	}
+
+	auto i = this->res_index.find(id);
+	if (i == this->res_index.end() || i->second.pack->find_resource_in_res_map(id)) {
+		// nothing to read, the resource is already loaded or it is not found and loading will report an error
+		if (on_ready) {
+			this->ctx.post_to_ui_thread([weak_ctx = std::weak_ptr<context>(this->ctx.shared_from_this()),
+										 on_ready = std::move(on_ready)]() {
+				// the callback can refer to the context, so make sure it is still alive
+				if (auto c = weak_ctx.lock()) {
+					on_ready();
+				}
+			});
+		}
+		return;
+	}
+
+	const auto& pack = *i->second.pack;
+
+	std::vector<std::string> paths;
+	for (const auto& p : i->second.desc->children) {
+		// malformed properties are reported by loading of the resource
+		if (p.children.size() != 1 ||
+			std::find(file_properties.begin(), file_properties.end(), p.value.string) == file_properties.end())
+		{
+			continue;
+		}
+		const auto& path = get_property_value(p).string;
+		if (path.empty()) {
+			continue;
+		}
+		paths.push_back(path);
+	}
+
+	this->pending_prefetches[std::string(id)].push_back(std::move(on_ready));
+
+	// NOTE: the task must not hold references to the context, otherwise the context could be destroyed
+	//       from the worker thread, which would then wait for itself to finish
+	this->ctx.workers.push([file = std::shared_ptr<papki::file>(pack.fi->spawn()),
+							fs_dir = pack.fs_dir,
+							paths = std::move(paths),
+							desc = i->second.desc->children,
+							decode = std::move(decode),
+							pack_fi = pack.fi.get(),
+							id = std::string(id),
+							weak_ctx = std::weak_ptr<context>(this->ctx.shared_from_this()),
+							post_to_ui_thread = this->ctx.post_to_ui_thread]() {
+		resource_files files;
+
+		for (const auto& path : paths) {
+			try {
+				if (fs_dir.has_value()) {
+					auto mf = mapped_file::map(fs_dir.value() + path);
+					touch_pages(mf.get().data());
+					files.insert_or_assign(path, std::move(mf));
+					continue;
+				}
+
+				file->set_path(path);
+				files.insert_or_assign(path, utki::make_shared<mapped_file>(file->load()));
+			} catch (std::exception&) {
+				// the file cannot be read, loading of the resource will report the error
+			}
+		}
+
+		decoded_resource decoded;
+		if (decode) {
+			try {
+				decoded = decode(desc, files);
+			} catch (std::exception& e) {
+				// the resource will be loaded on UI thread, which will report the error
+				LOG([&](auto& o) {
+					o << "could not decode resource " << id << ": " << e.what() << std::endl;
+				})
+			}
+		}
+
+		post_to_ui_thread([weak_ctx, pack_fi, id, files = std::move(files), decoded = std::move(decoded)]() {
+			if (auto c = weak_ctx.lock()) {
+				c->loader.on_prefetched(pack_fi, id, files, decoded);
+			}
+		});
+	});
+}
+
+void resource_loader::on_prefetched(
+	const papki::file* pack_fi,
+	std::string_view id,
+	resource_files files,
+	decoded_resource decoded
+)
+{
+	auto p = this->pending_prefetches.find(id);
+	ASSERT(p != this->pending_prefetches.end())
+	auto callbacks = std::move(p->second);
+	this->pending_prefetches.erase(p);
+
+	// the resource pack could have been unmounted meanwhile
+	if (std::any_of(this->res_packs.begin(), this->res_packs.end(), [&](const auto& rp) {
+			return rp.fi.get() == pack_fi;
+		}))
+	{
+		auto& keys = this->prefetched_ids[std::string(id)];
+		for (auto& [path, mf] : files) {
+			auto key = std::make_pair(pack_fi, path);
+			keys.push_back(key);
+			this->prefetched_files.insert_or_assign(std::move(key), mf.to_shared_ptr());
+		}
+
+		if (decoded) {
+			this->prefetched_resources.insert_or_assign(
+				std::string(id),
+				prefetched_resource{.pack_fi = pack_fi, .finish_loading = std::move(decoded)}
+			);
+		}
+	}
+
+	for (const auto& c : callbacks) {
+		if (c) {
+			c();
+		}
+	}
+}
+
+void resource_loader::add_to_res_index(res_pack_entry& pack)
+{
+	for (const auto& [id, desc] : pack.descriptions) {
+		auto i = this->res_index.find(id);
+		if (i == this->res_index.end()) {
+			this->res_index.emplace(id, res_index_entry{.pack = &pack, .desc = desc});
+			continue;
+		}
+
+		// the new resource pack overrides the resource description,
+		// the key has to be replaced as well, since it refers to the script of the overridden resource pack
+		auto node = this->res_index.extract(i);
+		node.key() = id;
+		node.mapped() = {.pack = &pack, .desc = desc};
+		this->res_index.insert(std::move(node));
+	}
+}
+
+void resource_loader::remove_from_res_index(const res_pack_entry& pack)
+{
+	for (const auto& [id, desc] : pack.descriptions) {
+		auto i = this->res_index.find(id);
+		ASSERT(i != this->res_index.end())
+		if (i->second.pack != &pack) {
+			// the resource description is overridden by another resource pack
+			continue;
+		}
+
+		auto node = this->res_index.extract(i);
+
+		// find the resource description in the remaining resource packs, last mounted one wins
+		for (auto j = this->res_packs.rbegin(); j != this->res_packs.rend(); ++j) {
+			if (&*j == &pack) {
+				continue;
+			}
+			if (auto d = j->find_resource_in_script(id)) {
+				node.key() = d->value.string;
+				node.mapped() = {.pack = &*j, .desc = d};
+				this->res_index.insert(std::move(node));
+				break;
+			}
+		}
+	}
+}
+
+void resource_loader::drop_prefetched_files(std::string_view id)
+{
+	if (auto r = this->prefetched_resources.find(id); r != this->prefetched_resources.end()) {
+		this->prefetched_resources.erase(r);
+	}
+
+	auto i = this->prefetched_ids.find(id);
+	if (i == this->prefetched_ids.end()) {
+		return;
+	}
+
+	for (const auto& k : i->second) {
+		this->prefetched_files.erase(k);
+	}
+
+	this->prefetched_ids.erase(i);
+}
+
+resource_loader::decoded_resource resource_loader::take_decoded_resource(
+	std::string_view id, //
+	const papki::file& pack_fi
+)
+{
+	auto i = this->prefetched_resources.find(id);
+	if (i == this->prefetched_resources.end() || i->second.pack_fi != &pack_fi) {
+		return nullptr;
+	}
+
+	auto ret = std::move(i->second.finish_loading);
+	this->prefetched_resources.erase(i);
+	return ret;
+}
+
+std::shared_ptr<const mapped_file> resource_loader::map_file(const papki::file& fi) const
+{
+	if (!this->prefetched_files.empty()) {
+		auto i = this->prefetched_files.find(std::make_pair(&fi, fi.path()));
+		if (i != this->prefetched_files.end()) {
+			auto ret = std::move(i->second);
+			this->prefetched_files.erase(i);
+			return ret;
+		}
+	}
+
+	for (const auto& rp : this->res_packs) {
+		if (rp.fi.get() != &fi) {
+			continue;
+		}
+		if (!rp.fs_dir.has_value()) {
+			return nullptr;
+		}
+		return mapped_file::map(rp.fs_dir.value() + fi.path()).to_shared_ptr();
+	}
+
+	if (dynamic_cast<const papki::fs_file*>(&fi)) {
+		return mapped_file::map(fi.path()).to_shared_ptr();
+	}
+
+	return nullptr;
+}
+
+resource_loader::res_pack_entry::res_pack_entry(
+	decltype(fi) fi, //
+	tml::forest script,
+	decltype(fs_dir) fs_dir
+) :
+	fi(std::move(fi)),
+	script(std::move(script)),
+	fs_dir(std::move(fs_dir))
+{
+	for (const auto& t : this->script) {
+		if (t.value == wording_include || t.value == wording_include_subdirs) {
+			continue;
+		}
+		// in case of duplicate resource ids the first description is used
+		this->descriptions.try_emplace(t.value.string, &t);
+	}
+}
+
 void resource_loader::res_pack_entry::add_resource_to_res_map(
 	const utki::shared_ref<resource>& res,
 	std::string_view id
@@ -106,12 +467,12 @@ std::shared_ptr<resource> resource_loader::res_pack_entry::find_resource_in_res_
 	return nullptr; // no resource found with given id, return invalid reference
 }
 
-const tml::forest* resource_loader::res_pack_entry::find_resource_in_script(std::string_view id) const
+const tml::tree* resource_loader::res_pack_entry::find_resource_in_script(std::string_view id) const
 {
-	auto j = std::find(this->script.begin(), this->script.end(), id);
-	if (j != this->script.end()) {
-		ASSERT(j->value.string == id)
-		return &j->children;
+	auto i = this->descriptions.find(id);
+	if (i != this->descriptions.end()) {
+		ASSERT(i->second->value.string == id)
+		return i->second;
 	}
 
 	return nullptr;
@@ -21,12 +21,23 @@ along with this program. If not, see <http://www.gnu.org/licenses/>.
 
 #pragma once
 
+#include <array>
+#include <exception>
+#include <functional>
 #include <list>
 #include <map>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
 
 #include <papki/file.hpp>
+#include <papki/span_file.hpp>
 #include <tml/tree.hpp>
 #include <utki/shared.hpp>
+#include <utki/span.hpp>
+#include <utki/util.hpp>
+
+#include "util/mapped_file.hpp"
 
 namespace ruis {
 
@@ -75,13 +86,17 @@ class resource_loader
 
 		std::unique_ptr<const papki::file> fi;
 
-		// TODO: use std::map/std::unordered_map?
-		tml::forest script;
+		const tml::forest script;
+
+		// resource descriptions of the script by resource id,
+		// the keys refer to the strings of the script
+		std::unordered_map<std::string_view, const tml::tree*> descriptions;
+
+		// directory of the resource pack on the local file system,
+		// std::nullopt if the resource pack is not on the local file system
+		std::optional<std::string> fs_dir;
 
-		res_pack_entry(decltype(fi) fi, decltype(script) script) :
-			fi(std::move(fi)),
-			script(std::move(script))
-		{}
+		res_pack_entry(decltype(fi) fi, tml::forest script, decltype(fs_dir) fs_dir);
 
 		~res_pack_entry() = default;
 
@@ -92,12 +107,95 @@ class resource_loader
 
 		void add_resource_to_res_map(const utki::shared_ref<resource>& res, std::string_view id);
 		std::shared_ptr<resource> find_resource_in_res_map(std::string_view id);
-		const tml::forest* find_resource_in_script(std::string_view id) const;
+		const tml::tree* find_resource_in_script(std::string_view id) const;
 	};
 
 	// use std::list to be able to use iterator as resource pack id
 	std::list<res_pack_entry> res_packs;
 
+	struct res_index_entry {
+		res_pack_entry* pack;
+		const tml::tree* desc;
+	};
+
+	// index of resource descriptions of all mounted resource packs,
+	// for each resource id refers to the last mounted resource pack which has the resource description,
+	// the keys refer to the strings of that resource pack's script
+	std::unordered_map<std::string_view, res_index_entry> res_index;
+
+	void add_to_res_index(res_pack_entry& pack);
+	void remove_from_res_index(const res_pack_entry& pack);
+
+	// files read in advance on worker threads, by resource pack file interface and path within the resource pack,
+	// each file is used only once and then removed
+	mutable std::map<std::pair<const papki::file*, std::string>, std::shared_ptr<const mapped_file>> prefetched_files;
+
+	// keys of prefetched_files by resource id, to drop the files not consumed by the resource once it is loaded
+	std::map<std::string, std::vector<decltype(prefetched_files)::key_type>, std::less<>> prefetched_ids;
+
+public:
+	/**
+	 * @brief Files of a resource read in advance.
+	 * Maps file paths within the resource pack, as given in the resource description, to the file contents.
+	 */
+	using resource_files = std::map<std::string, utki::shared_ref<const mapped_file>, std::less<>>;
+
+	/**
+	 * @brief Decoded resource.
+	 * Function which finishes loading of the resource decoded on a worker thread, called on UI thread.
+	 * It creates GPU objects of the resource.
+	 */
+	using decoded_resource = std::function<utki::shared_ref<resource>(const utki::shared_ref<context>& ctx)>;
+
+private:
+	struct prefetched_resource {
+		const papki::file* pack_fi;
+		decoded_resource finish_loading;
+	};
+
+	// resources decoded in advance on worker threads, by resource id
+	std::map<std::string, prefetched_resource, std::less<>> prefetched_resources;
+
+	// drops the prefetched files and the decoded resource of the resource id
+	void drop_prefetched_files(std::string_view id);
+
+	// returns the resource decoded in advance, nullptr if there is none
+	decoded_resource take_decoded_resource(std::string_view id, const papki::file& pack_fi);
+
+	// callbacks waiting for resource files to be read on worker threads, by resource id
+	std::map<std::string, std::vector<std::function<void()>>, std::less<>> pending_prefetches;
+
+	using decoder_type = std::function<decoded_resource(const tml::forest& desc, const resource_files& files)>;
+
+	// reads files of the resource, given by the file properties of the resource description,
+	// and decodes the resource on a worker thread, calls on_ready on UI thread once it is done
+	void prefetch(
+		std::string_view id,
+		utki::span<const std::string_view> file_properties,
+		decoder_type decode,
+		std::function<void()> on_ready
+	);
+
+	template <class resource_type>
+	void prefetch(std::string_view id, std::function<void()> on_ready)
+	{
+		this->prefetch(
+			id,
+			utki::make_span(resource_type::file_properties),
+			[](const tml::forest& desc, const resource_files& files) {
+				return resource_type::decode(desc, files);
+			},
+			std::move(on_ready)
+		);
+	}
+
+	void on_prefetched(
+		const papki::file* pack_fi,
+		std::string_view id,
+		resource_files files,
+		decoded_resource decoded
+	);
+
 private:
 	context& ctx;
 
@@ -111,6 +209,10 @@ public:
 	 * This function adds a resource pack to the list of known resource packs.
 	 * It loads the resource description and uses it when searching for resource
 	 * when resource loading is needed.
+	 * In case there is a compiled version of the description script next to it, with ".bin" suffix
+	 * appended to the script file name, see compile_res_script(), then the compiled script is used
+	 * instead of parsing the text script. In case the compiled script is of unsupported version,
+	 * is corrupted or is compiled from a different version of the text script, the text script is used.
 	 * @param fi - file interface pointing to the resource pack's description script.
 	 *             If file interface points to a directory instead of a file then
 	 *             resource description filename is assumed to be "main.res".
@@ -118,12 +220,54 @@ public:
 	 */
 	decltype(res_packs)::const_iterator mount_res_pack(const papki::file& fi);
 
+	/**
+	 * @brief Compile resource pack description script.
+	 * Converts the resource description script to pre-parsed binary form which is faster to load.
+	 * The compiled script holds a hash of the script text, so it is not used after the text script is edited.
+	 * The result is to be saved next to the script file, with ".bin" suffix appended to the script file name,
+	 * e.g. "main.res.bin". Included resource pack scripts are to be compiled separately.
+	 * Normally, this is done as a step of application build process.
+	 * @param fi - file interface pointing to the resource pack's description script.
+	 * @return Compiled script.
+	 */
+	static std::vector<uint8_t> compile_res_script(const papki::file& fi);
+
 	/**
 	 * @brief Unmount mounted resource pack.
 	 * @param id - id of the resource pack to unmount.
 	 */
 	void unmount_res_pack(decltype(res_packs)::const_iterator id);
 
+	/**
+	 * @brief Memory map a resource file.
+	 * Resource loaders can use this function to access resource files without copying their contents.
+	 * @param fi - file interface of a mounted resource pack, as passed to the resource loading function,
+	 *             pointing to a file within the resource pack.
+	 * @return Memory mapped file.
+	 * @return nullptr if the file is not on the local file system and thus cannot be memory mapped.
+	 */
+	std::shared_ptr<const mapped_file> map_file(const papki::file& fi) const;
+
+	/**
+	 * @brief Read a resource file.
+	 * In case the file can be memory mapped, see map_file(), the reader function reads the file contents
+	 * directly from memory, otherwise it reads from the given file interface.
+	 * @param fi - file interface of a mounted resource pack pointing to a file within the resource pack.
+	 * @param read - reader function, accepts const papki::file& and returns the read result.
+	 * @return Result of the reader function.
+	 */
+	template <typename reader_type>
+	auto read_file(const papki::file& fi, const reader_type& read) const
+	{
+		if (auto mf = this->map_file(fi)) {
+			papki::span_file mapped(mf->data());
+			// readers can determine file format by file name suffix
+			mapped.set_path(fi.path());
+			return read(static_cast<const papki::file&>(mapped));
+		}
+		return read(fi);
+	}
+
 	/**
 	 * @brief Load a resource.
 	 * This is a template function. Resource types are not indicated anyhow in
@@ -142,7 +286,54 @@ public:
 	template <class resource_type>
 	utki::shared_ref<resource_type> load(std::string_view id);
 
-private:
+	/**
+	 * @brief Preload resources.
+	 * Reads and decodes files of the resources on worker threads of the context in advance,
+	 * so that later loading of the resources only has to create GPU objects.
+	 * The files to read are given by the resource type, see resource::file_properties,
+	 * decoding is done by resource::decode() of the resource type.
+	 * The read files and decoded resources are kept in memory until the resources are loaded
+	 * or the resource pack is unmounted.
+	 * @param ids - ids of the resources to preload.
+	 */
+	template <class resource_type>
+	void preload(utki::span<const std::string_view> ids)
+	{
+		for (auto id : ids) {
+			this->prefetch<resource_type>(id, nullptr);
+		}
+	}
+
+	/**
+	 * @brief Load a resource asynchronously.
+	 * Files of the resource are read and decoded on worker threads of the context, see preload(),
+	 * then the resource is loaded on UI thread, where GPU resources can be created,
+	 * and the callback is called on UI thread with the result.
+	 * Concurrent requests for the same resource id share the file reading.
+	 * The callback is always called from the UI thread message queue, even if the resource is already loaded.
+	 * @param id - id of the resource as it appears in resource description.
+	 * @param on_loaded - callback to call with the loaded resource. In case of failure the resource is nullptr
+	 *                    and the exception which occurred during loading is passed.
+	 */
+	template <class resource_type>
+	void load_async(
+		std::string_view id,
+		std::function<void(std::shared_ptr<resource_type> res, std::exception_ptr error)> on_loaded
+	)
+	{
+		this->prefetch<resource_type>(id, [this, id = std::string(id), on_loaded = std::move(on_loaded)]() {
+			std::shared_ptr<resource_type> res;
+			std::exception_ptr error;
+			try {
+				res = this->load<resource_type>(id).to_shared_ptr();
+			} catch (...) {
+				error = std::current_exception();
+			}
+			if (on_loaded) {
+				on_loaded(std::move(res), error);
+			}
+		});
+	}
 };
 
 /**
@@ -162,6 +353,31 @@ protected:
 		context(std::move(c))
 	{}
 
+	/**
+	 * @brief Names of resource description properties which are file paths.
+	 * The files are read on worker threads in advance by resource_loader::preload() and resource_loader::load_async().
+	 * Resource types which read files hide this member with their own list of properties.
+	 */
+	constexpr static std::array<std::string_view, 0> file_properties = {};
+
+	/**
+	 * @brief Decode resource on a worker thread.
+	 * Called on a worker thread by resource_loader::preload() and resource_loader::load_async(),
+	 * so it must not use the context. Resource types which can decode their files without the context
+	 * hide this function with their own implementation.
+	 * @param desc - resource description.
+	 * @param files - files read in advance, as given by file_properties.
+	 * @return Function to finish loading of the resource on UI thread.
+	 * @return nullptr if the resource is to be loaded on UI thread by the resource type's load() function.
+	 */
+	static resource_loader::decoded_resource decode(
+		const tml::forest& desc, //
+		const resource_loader::resource_files& files
+	)
+	{
+		return nullptr;
+	}
+
 public:
 	resource(const resource&) = delete;
 	resource& operator=(const resource&) = delete;
@@ -180,41 +396,54 @@ public:
 template <class resource_type>
 utki::shared_ref<resource_type> resource_loader::load(std::string_view id)
 {
-	for (auto i = this->res_packs.rbegin(); i != this->res_packs.rend(); ++i) {
-		if (auto r = i->find_resource_in_res_map(id)) {
-			return utki::shared_ref<resource_type>(std::dynamic_pointer_cast<resource_type>(r));
-		}
-
-		auto desc = i->find_resource_in_script(id);
-		if (!desc) {
-			continue;
-		}
-
-		try {
-			ASSERT(i->fi)
-			auto resource = resource_type::load(utki::make_shared_from(this->ctx), *desc, *i->fi);
+	auto i = this->res_index.find(id);
+	if (i == this->res_index.end()) {
+		LOG([&](auto& o) {
+			o << "resource id not found in mounted resource packs: " << id << std::endl;
+		})
+		std::stringstream ss;
+		ss << "resource id not found in mounted resource packs: " << id;
+		throw std::logic_error(ss.str());
+	}
 
-			// resource need to know its id so that it would be possible to reload the resource
-			// using the id in case mounted resource packs change
-			resource.get().id = id;
+	auto& pack = *i->second.pack;
 
-			i->add_resource_to_res_map(resource, id);
+	// files read in advance for the resource are not needed anymore once the resource is loaded,
+	// also in case the resource type does not read its files via map_file()/read_file() or loading fails
+	utki::scope_exit prefetched_files_scope_exit([this, id]() {
+		this->drop_prefetched_files(id);
+	});
 
-			return resource;
-		} catch (...) {
-			utki::log([&](auto& o) {
-				o << "could not load resource, id = " << id << std::endl;
-			});
-			throw;
-		}
+	if (auto r = pack.find_resource_in_res_map(id)) {
+		return utki::shared_ref<resource_type>(std::dynamic_pointer_cast<resource_type>(r));
 	}
 
-	LOG([&](auto& o) {
-		o << "resource id not found in mounted resource packs: " << id << std::endl;
-	})
-	std::stringstream ss;
-	ss << "resource id not found in mounted resource packs: " << id;
-	throw std::logic_error(ss.str());
+	try {
+		ASSERT(pack.fi)
+		auto resource = [&]() -> utki::shared_ref<resource_type> {
+			if (auto decoded = this->take_decoded_resource(id, *pack.fi)) {
+				auto r = decoded(utki::make_shared_from(this->ctx)).to_shared_ptr();
+				// the resource could have been decoded for another resource type
+				if (auto rt = std::dynamic_pointer_cast<resource_type>(std::move(r))) {
+					return utki::shared_ref<resource_type>(std::move(rt));
+				}
+			}
+			return resource_type::load(utki::make_shared_from(this->ctx), i->second.desc->children, *pack.fi);
+		}();
+
+		// resource need to know its id so that it would be possible to reload the resource
+		// using the id in case mounted resource packs change
+		resource.get().id = id;
+
+		pack.add_resource_to_res_map(resource, id);
+
+		return resource;
+	} catch (...) {
+		utki::log([&](auto& o) {
+			o << "could not load resource, id = " << id << std::endl;
+		});
+		throw;
+	}
 }
 
 } // namespace ruis
@@ -54,10 +54,12 @@ private:
 	// pointer to the queue the updateable is inserted into
 	updater::update_queue* queue = nullptr;
 
-	updater::update_queue::iterator iter; // iterator into the queue.
+	size_t queue_index = 0; // position within the queue
 
 	bool pending_addition = false;
 
+	size_t to_add_index = 0; // position within the pending addition list
+
 public:
 	/**
 	 * @brief Check if the object is currently subscribed for updates.
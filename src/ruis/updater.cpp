@@ -46,15 +46,14 @@ void updater::start(
 	u.get().dt = dt_ms;
 	u.get().started_at = this->get_ticks_ms();
 	u.get().updating = true;
-	u.get().pending_addition = true;
 
-	this->to_add.push_front(u.to_shared_ptr()); // TODO: add weak_ptr
+	this->push_to_add(u.to_shared_ptr()); // TODO: add weak_ptr
 }
 
 void updater::stop(updateable& u) noexcept
 {
 	if (u.queue) {
-		u.queue->erase(u.iter);
+		u.queue->erase(u.queue_index);
 		u.queue = nullptr;
 	} else if (u.pending_addition) {
 		this->remove_from_to_add(&u);
@@ -63,59 +62,115 @@ void updater::stop(updateable& u) noexcept
 	u.updating = false;
 }
 
+void updater::push_to_add(std::shared_ptr<ruis::updateable> u)
+{
+	ASSERT(!u->pending_addition)
+	u->pending_addition = true;
+	u->to_add_index = this->to_add.size();
+	this->to_add.push_back(std::move(u));
+}
+
 void updater::remove_from_to_add(updateable* u)
 {
 	ASSERT(u->pending_addition)
-	for (auto i = this->to_add.begin(); i != this->to_add.end(); ++i) {
-		if ((*i).operator->() == u) {
-			ASSERT((*i)->pending_addition)
-			u->pending_addition = false;
-			this->to_add.erase(i);
-			return;
-		}
+	ASSERT(u->to_add_index < this->to_add.size())
+	ASSERT(this->to_add[u->to_add_index].get() == u)
+
+	// move last element to the place of the removed one
+	auto& last = this->to_add.back();
+	last->to_add_index = u->to_add_index;
+	std::swap(this->to_add[u->to_add_index], last);
+
+	u->pending_addition = false;
+	this->to_add.pop_back();
+}
+
+void updater::update_queue::update_index(size_t index) noexcept
+{
+	auto& item = this->heap[index];
+	if (!item.updateable.expired()) {
+		item.updateable_ptr->queue_index = index;
 	}
 }
 
-updater::update_queue::iterator updater::update_queue::insert(const update_queue_item& p)
+void updater::update_queue::sift_up(size_t index) noexcept
 {
-	if (this->size() == 0 || this->back().ends_at <= p.ends_at) {
-		this->push_back(p);
-		return std::prev(this->end());
+	while (index != 0) {
+		size_t parent = (index - 1) / 2;
+		if (!is_before(this->heap[index], this->heap[parent])) {
+			break;
+		}
+		std::swap(this->heap[index], this->heap[parent]);
+		this->update_index(index);
+		index = parent;
 	}
+	this->update_index(index);
+}
 
-	// otherwise, go from the beginning
-	for (auto i = this->begin(); i != this->end(); ++i) {
-		if (i->ends_at >= p.ends_at) {
-			return this->list::insert(i, p); // inserts before iterator
+void updater::update_queue::sift_down(size_t index) noexcept
+{
+	for (;;) {
+		size_t smallest = index;
+		for (size_t child : {2 * index + 1, 2 * index + 2}) {
+			if (child < this->heap.size() && is_before(this->heap[child], this->heap[smallest])) {
+				smallest = child;
+			}
 		}
+		if (smallest == index) {
+			break;
+		}
+		std::swap(this->heap[index], this->heap[smallest]);
+		this->update_index(index);
+		index = smallest;
 	}
+	this->update_index(index);
+}
 
-	ASSERT(false)
-	return this->end();
+void updater::update_queue::insert(update_queue_item item)
+{
+	item.seq = this->next_seq++;
+	this->heap.push_back(std::move(item));
+	this->sift_up(this->heap.size() - 1);
+}
+
+void updater::update_queue::erase(size_t index) noexcept
+{
+	ASSERT(index < this->heap.size())
+
+	if (index != this->heap.size() - 1) {
+		std::swap(this->heap[index], this->heap.back());
+		this->heap.pop_back();
+
+		// moved item can go either way
+		this->sift_up(index);
+		this->sift_down(index);
+	} else {
+		this->heap.pop_back();
+	}
 }
 
 void updater::add_pending()
 {
-	while (this->to_add.size() != 0) {
+	for (auto& u : this->to_add) {
 		update_queue_item p;
 
-		p.ends_at = this->to_add.front()->ends_at();
-		p.updateable = this->to_add.front();
+		p.ends_at = u->ends_at();
+		p.updateable = u;
+		p.updateable_ptr = u.get();
 
 		if (p.ends_at < this->last_updated_timestamp) {
 			// std::cout << "updater::add_pending(): inserted to inactive queue" << std::endl;
-			this->to_add.front()->queue = this->inactive_queue;
-			this->to_add.front()->iter = this->inactive_queue->insert(p);
+			u->queue = this->inactive_queue;
 		} else {
 			// std::cout << "updater::add_pending(): inserted to active queue" << std::endl;
-			this->to_add.front()->queue = this->active_queue;
-			this->to_add.front()->iter = this->active_queue->insert(p);
+			u->queue = this->active_queue;
 		}
+		u->queue->insert(std::move(p));
 
-		this->to_add.front()->pending_addition = false;
-
-		this->to_add.pop_front();
+		u->pending_addition = false;
 	}
+
+	this->to_add.clear();
 }
 
 void updater::update_updateable(const std::shared_ptr<ruis::updateable>& u)
@@ -133,8 +188,7 @@ void updater::update_updateable(const std::shared_ptr<ruis::updateable>& u)
 	// if not stopped during update, and not started again, then add it back
 	if (u->is_updating() && !u->pending_addition) {
 		u->started_at = this->last_updated_timestamp;
-		u->pending_addition = true;
-		this->to_add.push_back(u);
+		this->push_to_add(u);
 	}
 }
 
@@ -22,8 +22,8 @@ along with this program. If not, see <http://www.gnu.org/licenses/>.
 #pragma once
 
 #include <functional>
-#include <list>
 #include <memory>
+#include <vector>
 
 #include <utki/debug.hpp>
 #include <utki/shared_ref.hpp>
@@ -40,18 +40,54 @@ class updater : public std::enable_shared_from_this<updater>
 
 	struct update_queue_item {
 		uint32_t ends_at = 0;
+
+		// insertion sequence number, keeps FIFO order of updateables with same end time
+		uint64_t seq = 0;
+
 		std::weak_ptr<ruis::updateable> updateable;
+
+		// used to maintain the item's position stored in the updateable, only valid while weak pointer is not expired
+		ruis::updateable* updateable_ptr = nullptr;
 	};
 
-	class update_queue : public std::list<update_queue_item>
+	// binary min-heap of updateables ordered by end time,
+	// each updateable knows its position within the heap, so removal of arbitrary item is O(log n)
+	class update_queue
 	{
+		std::vector<update_queue_item> heap;
+
+		uint64_t next_seq = 0;
+
+		static bool is_before(const update_queue_item& a, const update_queue_item& b) noexcept
+		{
+			return a.ends_at < b.ends_at || (a.ends_at == b.ends_at && a.seq < b.seq);
+		}
+
+		void update_index(size_t index) noexcept;
+
+		void sift_up(size_t index) noexcept;
+		void sift_down(size_t index) noexcept;
+
 	public:
-		update_queue::iterator insert(const update_queue_item& p);
+		size_t size() const noexcept
+		{
+			return this->heap.size();
+		}
+
+		const update_queue_item& front() const noexcept
+		{
+			ASSERT(!this->heap.empty())
+			return this->heap.front();
+		}
+
+		void insert(update_queue_item item);
+
+		void erase(size_t index) noexcept;
 
 		std::shared_ptr<ruis::updateable> pop_front()
 		{
 			auto ret = this->front().updateable.lock();
-			this->list::pop_front();
+			this->erase(0);
 			return ret;
 		}
 	};
@@ -63,7 +99,9 @@ class updater : public std::enable_shared_from_this<updater>
 
 	uint32_t last_updated_timestamp = 0;
 
-	std::list<std::shared_ptr<ruis::updateable>> to_add;
+	std::vector<std::shared_ptr<ruis::updateable>> to_add;
+
+	void push_to_add(std::shared_ptr<ruis::updateable> u);
 
 	void add_pending();
 
@@ -0,0 +1,192 @@
+/*
+ruis - GUI framework
+
+Copyright (C) 2012-2024  Ivan Gagis <igagis@gmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* ================ LICENSE END ================ */
+
+#include "binary_tml.hpp"
+
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+
+#include "raster_cache.hpp"
+
+using namespace ruis;
+
+namespace {
+// the last byte is format version
+constexpr std::array<uint8_t, 4> magic = {'R', 'T', 'B', 2};
+
+constexpr auto hash_size = sizeof(uint64_t);
+
+constexpr auto bits_per_byte = 8;
+constexpr auto varint_value_bits = 7;
+constexpr uint8_t varint_continuation_bit = 0x80;
+constexpr uint8_t varint_value_mask = 0x7f;
+
+void write_uint64(std::vector<uint8_t>& out, uint64_t v)
+{
+	for (size_t i = 0; i != sizeof(v); ++i) {
+		out.push_back(uint8_t(v >> (i * bits_per_byte)));
+	}
+}
+
+void write_varint(std::vector<uint8_t>& out, size_t v)
+{
+	while (v > varint_value_mask) {
+		out.push_back(uint8_t(v & varint_value_mask) | varint_continuation_bit);
+		v >>= varint_value_bits;
+	}
+	out.push_back(uint8_t(v));
+}
+
+void write_forest(std::vector<uint8_t>& out, const tml::forest& forest)
+{
+	write_varint(out, forest.size());
+	for (const auto& t : forest) {
+		const auto& s = t.value.string;
+		write_varint(out, s.size());
+		out.insert(out.end(), s.begin(), s.end());
+		write_forest(out, t.children);
+	}
+}
+
+class reader
+{
+	utki::span<const uint8_t> data;
+
+public:
+	reader(utki::span<const uint8_t> data) :
+		data(data)
+	{}
+
+	bool empty() const noexcept
+	{
+		return this->data.empty();
+	}
+
+	utki::span<const uint8_t> read_bytes(size_t size)
+	{
+		if (this->data.size() < size) {
+			throw std::invalid_argument("from_binary_tml(): unexpected end of data");
+		}
+		auto ret = this->data.subspan(0, size);
+		this->data = this->data.subspan(size);
+		return ret;
+	}
+
+	uint64_t read_uint64()
+	{
+		auto bytes = this->read_bytes(sizeof(uint64_t));
+		uint64_t ret = 0;
+		for (size_t i = 0; i != bytes.size(); ++i) {
+			ret |= uint64_t(bytes[i]) << (i * bits_per_byte);
+		}
+		return ret;
+	}
+
+	size_t read_varint()
+	{
+		size_t ret = 0;
+		for (unsigned shift = 0;; shift += varint_value_bits) {
+			if (shift >= sizeof(size_t) * bits_per_byte) {
+				throw std::invalid_argument("from_binary_tml(): malformed number");
+			}
+			auto b = this->read_bytes(1).front();
+			ret |= size_t(b & varint_value_mask) << shift;
+			if (!(b & varint_continuation_bit)) {
+				return ret;
+			}
+		}
+	}
+
+	tml::forest read_forest()
+	{
+		auto size = this->read_varint();
+
+		// each tree takes at least two bytes, do not reserve memory for bogus sizes
+		if (size > this->data.size() / 2) {
+			throw std::invalid_argument("from_binary_tml(): malformed forest size");
+		}
+
+		tml::forest ret;
+		ret.reserve(size);
+		for (size_t i = 0; i != size; ++i) {
+			auto s = this->read_bytes(this->read_varint());
+			ret.emplace_back(
+				tml::leaf(std::string(reinterpret_cast<const char*>(s.data()), s.size())),
+				this->read_forest()
+			);
+		}
+		return ret;
+	}
+};
+} // namespace
+
+std::vector<uint8_t> ruis::to_binary_tml(const tml::forest& forest, uint64_t source_hash)
+{
+	std::vector<uint8_t> ret(magic.begin(), magic.end());
+
+	// reserve place for the hash
+	ret.resize(ret.size() + hash_size);
+
+	write_uint64(ret, source_hash);
+
+	write_forest(ret, forest);
+
+	auto payload = utki::make_span(ret).subspan(magic.size() + hash_size);
+	auto h = raster_cache::hash(payload);
+
+	for (size_t i = 0; i != hash_size; ++i) {
+		ret[magic.size() + i] = uint8_t(h >> (i * bits_per_byte));
+	}
+
+	return ret;
+}
+
+tml::forest ruis::from_binary_tml(
+	utki::span<const uint8_t> data, //
+	std::optional<uint64_t> source_hash
+)
+{
+	reader r(data);
+
+	auto m = r.read_bytes(magic.size());
+	if (!std::equal(m.begin(), m.end(), magic.begin())) {
+		throw std::invalid_argument("from_binary_tml(): not a binary tml or unsupported version");
+	}
+
+	auto h = r.read_uint64();
+	if (h != raster_cache::hash(data.subspan(magic.size() + hash_size))) {
+		throw std::invalid_argument("from_binary_tml(): data hash mismatch");
+	}
+
+	auto sh = r.read_uint64();
+	if (source_hash.has_value() && sh != source_hash.value()) {
+		throw std::invalid_argument("from_binary_tml(): source hash mismatch");
+	}
+
+	auto ret = r.read_forest();
+
+	if (!r.empty()) {
+		throw std::invalid_argument("from_binary_tml(): unexpected data after the forest");
+	}
+
+	return ret;
+}
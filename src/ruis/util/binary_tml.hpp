@@ -0,0 +1,61 @@
+/*
+ruis - GUI framework
+
+Copyright (C) 2012-2024  Ivan Gagis <igagis@gmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* ================ LICENSE END ================ */
+
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include <tml/tree.hpp>
+#include <utki/span.hpp>
+
+namespace ruis {
+
+/**
+ * @brief Convert tml forest to binary format.
+ * The binary format is a pre-parsed form of tml, which can be read back much faster than tml text.
+ * It is used for precompiled resource pack scripts, see resource_loader::compile_res_script().
+ * The binary data starts with a format version and a hash of the rest of the data,
+ * which are validated when reading.
+ * The binary data also holds a hash of the text the forest was read from,
+ * to detect that the binary data is out of date with the text.
+ * @param forest - tml forest to convert.
+ * @param source_hash - hash of the text the forest was read from, see raster_cache::hash().
+ * @return Binary representation of the forest.
+ */
+std::vector<uint8_t> to_binary_tml(const tml::forest& forest, uint64_t source_hash = 0);
+
+/**
+ * @brief Read tml forest from binary format.
+ * @param data - binary data, as produced by to_binary_tml().
+ * @param source_hash - expected hash of the text the forest was read from.
+ *                      If not set, then the hash is not checked.
+ * @return Read tml forest.
+ * @throw std::invalid_argument - in case the data is not a valid binary tml of supported version,
+ *                                or in case the source hash does not match the expected one.
+ */
+tml::forest from_binary_tml(
+	utki::span<const uint8_t> data, //
+	std::optional<uint64_t> source_hash = std::nullopt
+);
+
+} // namespace ruis
@@ -0,0 +1,182 @@
+/*
+ruis - GUI framework
+
+Copyright (C) 2012-2024  Ivan Gagis <igagis@gmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* ================ LICENSE END ================ */
+
+#include "hit_test_grid.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <stdexcept>
+
+#include <utki/debug.hpp>
+
+using namespace ruis;
+
+namespace {
+// items touching more cells than this are not put to cells, but are checked on every query
+constexpr auto max_cells_per_item = 64;
+
+// limit cell coordinates to keep them within int32_t
+constexpr auto max_cell_coordinate = real(1 << 30);
+
+uint64_t cell_key(int32_t x, int32_t y)
+{
+	constexpr auto bits_in_int32 = 32;
+	return (uint64_t(uint32_t(x)) << bits_in_int32) | uint64_t(uint32_t(y));
+}
+
+void insert_sorted(std::vector<size_t>& v, size_t index)
+{
+	auto i = std::lower_bound(v.begin(), v.end(), index);
+	if (i == v.end() || *i != index) {
+		v.insert(i, index);
+	}
+}
+
+void erase_sorted(std::vector<size_t>& v, size_t index)
+{
+	auto i = std::lower_bound(v.begin(), v.end(), index);
+	if (i != v.end() && *i == index) {
+		v.erase(i);
+	}
+}
+} // namespace
+
+hit_test_grid::hit_test_grid(real cell_size) :
+	cell_size(cell_size)
+{
+	if (!(cell_size > 0)) {
+		throw std::invalid_argument("hit_test_grid::hit_test_grid(): cell size must be positive");
+	}
+}
+
+std::optional<hit_test_grid::cell_range> hit_test_grid::calc_cell_range(const rect& r) const noexcept
+{
+	using std::abs;
+	using std::floor;
+
+	real begin_x = floor(r.p.x() / this->cell_size);
+	real begin_y = floor(r.p.y() / this->cell_size);
+	real end_x = floor((r.p.x() + r.d.x()) / this->cell_size) + 1;
+	real end_y = floor((r.p.y() + r.d.y()) / this->cell_size) + 1;
+
+	// negated comparisons also catch NaNs
+	for (auto v : {begin_x, begin_y, end_x, end_y}) {
+		if (!(abs(v) < max_cell_coordinate)) {
+			return std::nullopt;
+		}
+	}
+
+	if ((end_x - begin_x) * (end_y - begin_y) > real(max_cells_per_item)) {
+		return std::nullopt;
+	}
+
+	return cell_range{
+		.begin = {int32_t(begin_x), int32_t(begin_y)},
+		.end = {int32_t(end_x), int32_t(end_y)}
+	};
+}
+
+void hit_test_grid::clear()
+{
+	this->items.clear();
+	this->cells.clear();
+	this->oversized_items.clear();
+}
+
+void hit_test_grid::remove(size_t index)
+{
+	ASSERT(index < this->items.size())
+
+	auto& range = this->items[index];
+
+	if (!range.has_value()) {
+		erase_sorted(this->oversized_items, index);
+		return;
+	}
+
+	for (auto y = range->begin.y(); y != range->end.y(); ++y) {
+		for (auto x = range->begin.x(); x != range->end.x(); ++x) {
+			auto i = this->cells.find(cell_key(x, y));
+			ASSERT(i != this->cells.end())
+			erase_sorted(i->second, index);
+			if (i->second.empty()) {
+				this->cells.erase(i);
+			}
+		}
+	}
+
+	range.reset();
+}
+
+void hit_test_grid::set(size_t index, const rect& r)
+{
+	if (index < this->items.size()) {
+		this->remove(index);
+	} else {
+		this->items.resize(index + 1);
+	}
+
+	auto range = this->calc_cell_range(r);
+
+	if (!range.has_value()) {
+		insert_sorted(this->oversized_items, index);
+		return;
+	}
+
+	for (auto y = range->begin.y(); y != range->end.y(); ++y) {
+		for (auto x = range->begin.x(); x != range->end.x(); ++x) {
+			insert_sorted(this->cells[cell_key(x, y)], index);
+		}
+	}
+
+	this->items[index] = range;
+}
+
+void hit_test_grid::query(const vector2& pos, std::vector<size_t>& out) const
+{
+	using std::abs;
+	using std::floor;
+
+	out.clear();
+
+	real x = floor(pos.x() / this->cell_size);
+	real y = floor(pos.y() / this->cell_size);
+
+	if (!(abs(x) < max_cell_coordinate) || !(abs(y) < max_cell_coordinate)) {
+		out = this->oversized_items;
+		return;
+	}
+
+	auto i = this->cells.find(cell_key(int32_t(x), int32_t(y)));
+	if (i == this->cells.end()) {
+		out = this->oversized_items;
+		return;
+	}
+
+	std::merge(
+		i->second.begin(),
+		i->second.end(),
+		this->oversized_items.begin(),
+		this->oversized_items.end(),
+		std::back_inserter(out)
+	);
+}
@@ -0,0 +1,94 @@
+/*
+ruis - GUI framework
+
+Copyright (C) 2012-2024  Ivan Gagis <igagis@gmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* ================ LICENSE END ================ */
+
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+#include "../config.hpp"
+
+namespace ruis {
+
+/**
+ * @brief Uniform grid spatial index of rectangles.
+ * Used to find rectangles which can contain a given point without checking all the rectangles.
+ * Rectangles are identified by indices. Each rectangle is put to all grid cells it touches,
+ * rectangles which touch too many cells are checked on every query instead.
+ */
+class hit_test_grid
+{
+	real cell_size;
+
+	struct cell_range {
+		r4::vector2<int32_t> begin;
+		r4::vector2<int32_t> end;
+	};
+
+	// cell ranges of items, nullopt for items which are not put to cells
+	std::vector<std::optional<cell_range>> items;
+
+	// indices of items in each cell, sorted
+	std::unordered_map<uint64_t, std::vector<size_t>> cells;
+
+	// indices of items which are not put to cells, sorted
+	std::vector<size_t> oversized_items;
+
+	std::optional<cell_range> calc_cell_range(const rect& r) const noexcept;
+
+	void remove(size_t index);
+
+public:
+	/**
+	 * @brief Constructor.
+	 * @param cell_size - size of the grid cell.
+	 */
+	explicit hit_test_grid(real cell_size);
+
+	real get_cell_size() const noexcept
+	{
+		return this->cell_size;
+	}
+
+	/**
+	 * @brief Remove all items.
+	 */
+	void clear();
+
+	/**
+	 * @brief Add or move an item.
+	 * @param index - index of the item.
+	 * @param r - rectangle of the item.
+	 */
+	void set(size_t index, const rect& r);
+
+	/**
+	 * @brief Find items which can contain the point.
+	 * The found items have to be checked for containing the point by the caller.
+	 * @param pos - point to find items for.
+	 * @param out - vector to write found item indices to, in ascending order. Previous contents are cleared.
+	 */
+	void query(const vector2& pos, std::vector<size_t>& out) const;
+};
+
+} // namespace ruis
@@ -0,0 +1,146 @@
+/*
+ruis - GUI framework
+
+Copyright (C) 2012-2024  Ivan Gagis <igagis@gmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* ================ LICENSE END ================ */
+
+#include "mapped_file.hpp"
+
+#include <map>
+#include <mutex>
+#include <system_error>
+#include <tuple>
+
+#include <papki/fs_file.hpp>
+#include <utki/config.hpp>
+#include <utki/util.hpp>
+
+#if CFG_OS != CFG_OS_WINDOWS
+#	include <fcntl.h>
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#	include <unistd.h>
+#endif
+
+using namespace ruis;
+
+mapped_file::mapped_file(std::vector<uint8_t> buffer) :
+	buffer(std::move(buffer)),
+	contents(this->buffer)
+{}
+
+#if CFG_OS == CFG_OS_WINDOWS
+
+mapped_file::mapped_file(const std::string& fs_path) :
+	mapped_file(papki::fs_file(fs_path).load())
+{}
+
+mapped_file::~mapped_file() = default;
+
+utki::shared_ref<const mapped_file> mapped_file::map(const std::string& fs_path)
+{
+	return utki::make_shared<mapped_file>(fs_path);
+}
+
+#else
+
+mapped_file::mapped_file(const std::string& fs_path)
+{
+	// NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
+	int fd = open(fs_path.c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd < 0) {
+		throw std::system_error(errno, std::generic_category(), "mapped_file: could not open file: " + fs_path);
+	}
+
+	utki::scope_exit fd_scope_exit([fd]() {
+		close(fd);
+	});
+
+	struct stat st {};
+	if (fstat(fd, &st) != 0) {
+		throw std::system_error(errno, std::generic_category(), "mapped_file: could not stat file: " + fs_path);
+	}
+
+	auto size = size_t(st.st_size);
+	if (size == 0) {
+		// empty files cannot be mapped
+		return;
+	}
+
+	void* addr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (addr == MAP_FAILED) {
+		throw std::system_error(errno, std::generic_category(), "mapped_file: could not map file: " + fs_path);
+	}
+
+	this->mapping = addr;
+	this->contents = utki::make_span(static_cast<const uint8_t*>(addr), size);
+}
+
+mapped_file::~mapped_file()
+{
+	if (this->mapping) {
+		munmap(this->mapping, this->contents.size());
+	}
+}
+
+utki::shared_ref<const mapped_file> mapped_file::map(const std::string& fs_path)
+{
+	struct stat st {};
+	if (stat(fs_path.c_str(), &st) != 0) {
+		throw std::system_error(errno, std::generic_category(), "mapped_file::map(): could not stat file: " + fs_path);
+	}
+
+	// file identity, size is included to not reuse the mapping of a file which was modified in place
+	using key_type = std::tuple<dev_t, ino_t, off_t>;
+
+	static std::mutex mutex;
+	static std::map<key_type, std::weak_ptr<const mapped_file>> mappings;
+
+	key_type key(st.st_dev, st.st_ino, st.st_size);
+
+	std::lock_guard lock(mutex);
+
+	if (auto i = mappings.find(key); i != mappings.end()) {
+		if (auto m = i->second.lock()) {
+			return utki::shared_ref<const mapped_file>(std::move(m));
+		}
+	}
+
+	// remove entries of files which are not mapped anymore
+	for (auto i = mappings.begin(); i != mappings.end();) {
+		if (i->second.expired()) {
+			i = mappings.erase(i);
+		} else {
+			++i;
+		}
+	}
+
+	utki::shared_ref<const mapped_file> ret = utki::make_shared<mapped_file>(fs_path);
+	mappings[key] = ret.to_shared_ptr();
+	return ret;
+}
+
+#endif
+
+utki::shared_ref<const mapped_file> mapped_file::load(const papki::file& fi)
+{
+	if (dynamic_cast<const papki::fs_file*>(&fi)) {
+		return map(fi.path());
+	}
+	return utki::make_shared<mapped_file>(fi.load());
+}
@@ -0,0 +1,97 @@
+/*
+ruis - GUI framework
+
+Copyright (C) 2012-2024  Ivan Gagis <igagis@gmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* ================ LICENSE END ================ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <papki/file.hpp>
+#include <utki/shared_ref.hpp>
+#include <utki/span.hpp>
+
+namespace ruis {
+
+/**
+ * @brief Read-only file contents in memory.
+ * The contents are either memory mapped from a file on the local file system,
+ * or loaded to a memory buffer in case memory mapping is not possible.
+ * Memory mapped files are shared, mapping the same file again while it is still mapped
+ * returns the existing mapping.
+ */
+class mapped_file
+{
+	std::vector<uint8_t> buffer;
+
+	void* mapping = nullptr;
+
+	utki::span<const uint8_t> contents;
+
+public:
+	/**
+	 * @brief Construct from already loaded file contents.
+	 * @param buffer - file contents.
+	 */
+	mapped_file(std::vector<uint8_t> buffer);
+
+	/**
+	 * @brief Memory map a file.
+	 * @param fs_path - path to the file on the local file system.
+	 */
+	mapped_file(const std::string& fs_path);
+
+	mapped_file(const mapped_file&) = delete;
+	mapped_file& operator=(const mapped_file&) = delete;
+
+	mapped_file(mapped_file&&) = delete;
+	mapped_file& operator=(mapped_file&&) = delete;
+
+	~mapped_file();
+
+	/**
+	 * @brief Get file contents.
+	 * @return File contents.
+	 */
+	utki::span<const uint8_t> data() const noexcept
+	{
+		return this->contents;
+	}
+
+	/**
+	 * @brief Memory map a file from the local file system.
+	 * In case the file is already mapped, the existing mapping is returned.
+	 * On platforms which do not support memory mapping the file is loaded to memory.
+	 * @param fs_path - path to the file on the local file system.
+	 * @return Mapped file.
+	 */
+	static utki::shared_ref<const mapped_file> map(const std::string& fs_path);
+
+	/**
+	 * @brief Get contents of a file.
+	 * Memory maps the file in case it is a file on the local file system, i.e. papki::fs_file,
+	 * otherwise loads the file to memory.
+	 * @param fi - file to get contents of.
+	 * @return Mapped file.
+	 */
+	static utki::shared_ref<const mapped_file> load(const papki::file& fi);
+};
+
+} // namespace ruis
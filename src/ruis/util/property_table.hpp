@@ -0,0 +1,130 @@
+/*
+ruis - GUI framework
+
+Copyright (C) 2012-2024  Ivan Gagis <igagis@gmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* ================ LICENSE END ================ */
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <stdexcept>
+#include <string_view>
+
+namespace ruis {
+
+/**
+ * @brief Compile-time perfect hash table of GUI script property names.
+ * Maps property names to items of the property enumeration.
+ * The enumeration items must go from 0 without gaps, the last item must be 'enum_size'.
+ * The seed of the hash function is selected at compile time so that the property names do not collide,
+ * so looking up a name is one hash calculation and at most one string comparison.
+ * @tparam property_enum - enumeration of properties.
+ */
+template <typename property_enum>
+class property_table
+{
+	constexpr static auto num_properties = size_t(property_enum::enum_size);
+
+	constexpr static size_t calc_table_size()
+	{
+		// keep the table sparse to make finding the seed quick
+		constexpr auto sparseness = 4;
+
+		size_t ret = 1;
+		while (ret < num_properties * sparseness) {
+			ret <<= 1;
+		}
+		return ret;
+	}
+
+	constexpr static auto table_size = calc_table_size();
+
+	std::array<std::string_view, num_properties> names;
+
+	std::array<property_enum, table_size> slots{};
+
+	uint32_t seed = 0;
+
+	constexpr static size_t hash(std::string_view str, uint32_t seed) noexcept
+	{
+		// FNV-1a hash with seeded offset basis
+		constexpr uint32_t fnv_offset_basis = 2166136261;
+		constexpr uint32_t fnv_prime = 16777619;
+
+		uint32_t h = fnv_offset_basis ^ seed;
+		for (char c : str) {
+			h ^= uint8_t(c);
+			h *= fnv_prime;
+		}
+		return size_t(h) & (table_size - 1);
+	}
+
+	constexpr bool try_fill_slots() noexcept
+	{
+		for (auto& s : this->slots) {
+			s = property_enum::enum_size;
+		}
+
+		for (size_t i = 0; i != this->names.size(); ++i) {
+			auto& s = this->slots[hash(this->names[i], this->seed)];
+			if (s != property_enum::enum_size) {
+				return false;
+			}
+			s = property_enum(i);
+		}
+		return true;
+	}
+
+public:
+	/**
+	 * @brief Constructor.
+	 * @param names - property names, in the order of the property enumeration items.
+	 * @throw std::logic_error - in case the names cannot be hashed without collisions, e.g. when there are duplicates.
+	 */
+	constexpr property_table(std::array<std::string_view, num_properties> names) :
+		names(names)
+	{
+		constexpr uint32_t max_seed = 0x1000;
+
+		for (; this->seed != max_seed; ++this->seed) {
+			if (this->try_fill_slots()) {
+				return;
+			}
+		}
+
+		throw std::logic_error("property_table(): could not find perfect hash for property names");
+	}
+
+	/**
+	 * @brief Find property by name.
+	 * @param name - property name.
+	 * @return property enumeration item.
+	 * @return property_enum::enum_size if there is no property with given name.
+	 */
+	constexpr property_enum find(std::string_view name) const noexcept
+	{
+		auto p = this->slots[hash(name, this->seed)];
+		if (p == property_enum::enum_size || this->names[size_t(p)] != name) {
+			return property_enum::enum_size;
+		}
+		return p;
+	}
+};
+
+} // namespace ruis
@@ -0,0 +1,262 @@
+/*
+ruis - GUI framework
+
+Copyright (C) 2012-2024  Ivan Gagis <igagis@gmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* ================ LICENSE END ================ */
+
+#include "raster_cache.hpp"
+
+#include <array>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iterator>
+#include <new>
+#include <sstream>
+#include <thread>
+
+using namespace ruis;
+
+namespace {
+constexpr std::array<char, 4> magic = {'R', 'R', 'C', '1'};
+
+constexpr const uint64_t fnv_prime = 0x100000001b3;
+
+// longest run of repeated bytes encoded by one packet
+constexpr const size_t max_run = 129;
+
+// longest sequence of literal bytes encoded by one packet
+constexpr const size_t max_literal = 128;
+
+// largest width or height of a cached bitmap, bitmaps are used as textures,
+// so anything larger than common maximum texture size is a corrupted file
+constexpr const uint32_t max_dimension = 16384;
+
+// the data is encoded as a sequence of packets, each starting with a control byte:
+// control byte < 128 means that (control byte + 1) literal bytes follow,
+// control byte >= 128 means that the next byte is repeated (control byte - 126) times
+std::vector<uint8_t> compress(utki::span<const uint8_t> data)
+{
+	std::vector<uint8_t> ret;
+
+	auto run_length = [&](size_t pos) {
+		size_t len = 1;
+		while (pos + len != data.size() && len != max_run && data[pos + len] == data[pos]) {
+			++len;
+		}
+		return len;
+	};
+
+	for (size_t i = 0; i != data.size();) {
+		auto run = run_length(i);
+		if (run >= 2) {
+			ret.push_back(uint8_t(run + 126));
+			ret.push_back(data[i]);
+			i += run;
+			continue;
+		}
+
+		// collect literal bytes until next run of at least 2 bytes
+		size_t start = i;
+		while (i != data.size() && i - start != max_literal && run_length(i) < 2) {
+			++i;
+		}
+		ret.push_back(uint8_t(i - start - 1));
+		ret.insert(ret.end(), std::next(data.begin(), ptrdiff_t(start)), std::next(data.begin(), ptrdiff_t(i)));
+	}
+
+	return ret;
+}
+
+// returns false if the data is corrupted
+bool decompress(std::istream& s, utki::span<uint8_t> out)
+{
+	auto dst = out.begin();
+	while (dst != out.end()) {
+		int control = s.get();
+		if (control == std::istream::traits_type::eof()) {
+			return false;
+		}
+
+		if (control < 128) {
+			auto len = size_t(control) + 1;
+			if (size_t(std::distance(dst, out.end())) < len) {
+				return false;
+			}
+			s.read(reinterpret_cast<char*>(&*dst), std::streamsize(len));
+			if (!s) {
+				return false;
+			}
+			dst += ptrdiff_t(len);
+		} else {
+			auto len = size_t(control) - 126;
+			int value = s.get();
+			if (value == std::istream::traits_type::eof() || size_t(std::distance(dst, out.end())) < len) {
+				return false;
+			}
+			dst = std::fill_n(dst, len, uint8_t(value));
+		}
+	}
+	return true;
+}
+
+void write_uint32(std::ostream& s, uint32_t v)
+{
+	for (unsigned i = 0; i != sizeof(v); ++i) {
+		s.put(char(uint8_t(v >> (i * 8))));
+	}
+}
+
+std::optional<uint32_t> read_uint32(std::istream& s)
+{
+	uint32_t ret = 0;
+	for (unsigned i = 0; i != sizeof(ret); ++i) {
+		int b = s.get();
+		if (b == std::istream::traits_type::eof()) {
+			return std::nullopt;
+		}
+		ret |= uint32_t(b) << (i * 8);
+	}
+	return ret;
+}
+} // namespace
+
+raster_cache::raster_cache(std::string dir) :
+	dir(std::move(dir))
+{}
+
+uint64_t raster_cache::hash(utki::span<const uint8_t> data, uint64_t seed) noexcept
+{
+	// FNV-1a
+	uint64_t h = seed;
+	for (auto b : data) {
+		h ^= b;
+		h *= fnv_prime;
+	}
+	return h;
+}
+
+std::string raster_cache::make_path(uint64_t key) const
+{
+	std::stringstream ss;
+	ss << this->dir << std::hex << std::setw(sizeof(key) * 2) << std::setfill('0') << key << ".rrc";
+	return ss.str();
+}
+
+std::optional<raster_cache::entry> raster_cache::load(uint64_t key, unsigned num_channels) const
+{
+	std::ifstream s(this->make_path(key), std::ios::binary);
+	if (!s) {
+		return std::nullopt;
+	}
+
+	std::array<char, magic.size()> m{};
+	s.read(m.data(), m.size());
+	if (!s || m != magic) {
+		return std::nullopt;
+	}
+
+	auto width = read_uint32(s);
+	auto height = read_uint32(s);
+	int channels = s.get();
+	if (!width || !height || channels != int(num_channels)) {
+		return std::nullopt;
+	}
+
+	auto corrupted = [&]() {
+		LOG([&](auto& o) {
+			o << "raster_cache: corrupted cache file: " << this->make_path(key) << std::endl;
+		})
+		return std::nullopt;
+	};
+
+	if (width.value() > max_dimension || height.value() > max_dimension) {
+		return corrupted();
+	}
+
+	size_t size = size_t(width.value()) * size_t(height.value()) * num_channels;
+
+	// each packet of 2 bytes decodes to at most max_run bytes, so the rest of the file limits the size
+	auto data_begin = s.tellg();
+	s.seekg(0, std::ios::end);
+	auto data_size = std::streamoff(s.tellg()) - std::streamoff(data_begin);
+	s.seekg(data_begin);
+	if (!s || data_size < 0 || size > size_t(data_size) / 2 * max_run) {
+		return corrupted();
+	}
+
+	std::optional<entry> ret;
+	try {
+		ret = entry{
+			.dims = {width.value(), height.value()},
+			.pixels = std::vector<uint8_t>(size)
+		};
+	} catch (std::bad_alloc&) {
+		LOG([&](auto& o) {
+			o << "raster_cache: not enough memory to load cache file: " << this->make_path(key) << std::endl;
+		})
+		return std::nullopt;
+	}
+
+	if (!decompress(s, utki::make_span(ret->pixels))) {
+		return corrupted();
+	}
+
+	return ret;
+}
+
+void raster_cache::store(
+	uint64_t key,
+	r4::vector2<uint32_t> dims,
+	unsigned num_channels,
+	utki::span<const uint8_t> pixels
+) const
+{
+	ASSERT(pixels.size() == size_t(dims.x()) * size_t(dims.y()) * num_channels)
+
+	auto path = this->make_path(key);
+
+	// write to temporary file first and then rename it, so that readers never see partially written file
+	std::stringstream tmp_path;
+	tmp_path << path << '.' << std::this_thread::get_id() << ".tmp";
+
+	{
+		std::ofstream s(tmp_path.str(), std::ios::binary | std::ios::trunc);
+
+		s.write(magic.data(), magic.size());
+		write_uint32(s, dims.x());
+		write_uint32(s, dims.y());
+		s.put(char(num_channels));
+
+		auto data = compress(pixels);
+		s.write(reinterpret_cast<const char*>(data.data()), std::streamsize(data.size()));
+
+		if (!s) {
+			LOG([&](auto& o) {
+				o << "raster_cache: could not write cache file: " << tmp_path.str() << std::endl;
+			})
+			s.close();
+			std::remove(tmp_path.str().c_str());
+			return;
+		}
+	}
+
+	if (std::rename(tmp_path.str().c_str(), path.c_str()) != 0) {
+		std::remove(tmp_path.str().c_str());
+	}
+}
@@ -0,0 +1,147 @@
+/*
+ruis - GUI framework
+
+Copyright (C) 2012-2024  Ivan Gagis <igagis@gmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* ================ LICENSE END ================ */
+
+#pragma once
+
+#include <algorithm>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include <rasterimage/image.hpp>
+#include <utki/debug.hpp>
+#include <utki/span.hpp>
+
+namespace ruis {
+
+/**
+ * @brief Persistent on-disk cache of rasterized bitmaps.
+ * Each cached bitmap is stored in a separate run-length compressed file within the cache directory.
+ * The file name is derived from a key which is normally made with make_key() from content hash of
+ * the source file and all the parameters affecting the rasterization result.
+ * Failures to read or write cache files are not errors, cache misses are reported instead.
+ * The cache can be used from several threads at the same time.
+ */
+class raster_cache
+{
+	const std::string dir;
+
+	struct entry {
+		r4::vector2<uint32_t> dims;
+		std::vector<uint8_t> pixels;
+	};
+
+	std::optional<entry> load(uint64_t key, unsigned num_channels) const;
+
+	void store(
+		uint64_t key,
+		r4::vector2<uint32_t> dims,
+		unsigned num_channels,
+		utki::span<const uint8_t> pixels
+	) const;
+
+	std::string make_path(uint64_t key) const;
+
+public:
+	constexpr static const uint64_t default_seed = 0xcbf29ce484222325; // FNV-1a offset basis
+
+	/**
+	 * @brief Constructor.
+	 * @param dir - path to the cache directory on the local file system, with trailing slash.
+	 *              The directory must exist.
+	 */
+	raster_cache(std::string dir);
+
+	/**
+	 * @brief Calculate hash of data.
+	 * @param data - data to calculate hash of.
+	 * @param seed - initial hash value, can be used to continue hashing.
+	 * @return Hash value.
+	 */
+	static uint64_t hash(utki::span<const uint8_t> data, uint64_t seed = default_seed) noexcept;
+
+	/**
+	 * @brief Make cache key.
+	 * @param content_hash - hash of the source file contents.
+	 * @param kind - kind of the cached bitmaps, to distinguish bitmaps of different nature made from the same file.
+	 * @param params - rasterization parameters, trivially copyable values.
+	 * @return Cache key.
+	 */
+	template <typename... param_type>
+	static uint64_t make_key(uint64_t content_hash, std::string_view kind, const param_type&... params) noexcept
+	{
+		static_assert((std::is_trivially_copyable_v<param_type> && ...), "parameters must be trivially copyable");
+
+		auto h = hash(as_bytes(content_hash));
+		h = hash(utki::make_span(reinterpret_cast<const uint8_t*>(kind.data()), kind.size()), h);
+		((h = hash(as_bytes(params), h)), ...);
+		return h;
+	}
+
+	/**
+	 * @brief Get cached bitmap.
+	 * @param key - cache key.
+	 * @return Cached bitmap.
+	 * @return std::nullopt in case there is no bitmap for the given key in the cache.
+	 */
+	template <size_t num_channels>
+	std::optional<rasterimage::image<uint8_t, num_channels>> get(uint64_t key) const
+	{
+		auto e = this->load(key, num_channels);
+		if (!e) {
+			return std::nullopt;
+		}
+
+		rasterimage::image<uint8_t, num_channels> ret(e->dims);
+		auto dst = ret.pixels();
+		ASSERT(dst.size() * sizeof(dst[0]) == e->pixels.size())
+		std::copy(e->pixels.begin(), e->pixels.end(), reinterpret_cast<uint8_t*>(dst.data()));
+		return ret;
+	}
+
+	/**
+	 * @brief Put bitmap to cache.
+	 * @param key - cache key.
+	 * @param im - bitmap to cache.
+	 */
+	template <size_t num_channels>
+	void put(uint64_t key, const rasterimage::image<uint8_t, num_channels>& im) const
+	{
+		auto src = im.pixels();
+		this->store(
+			key,
+			im.dims(),
+			num_channels,
+			utki::make_span(reinterpret_cast<const uint8_t*>(src.data()), src.size() * sizeof(src[0]))
+		);
+	}
+
+private:
+	template <typename value_type>
+	static utki::span<const uint8_t> as_bytes(const value_type& v) noexcept
+	{
+		return utki::make_span(reinterpret_cast<const uint8_t*>(&v), sizeof(v));
+	}
+};
+
+} // namespace ruis
@@ -0,0 +1,161 @@
+/*
+ruis - GUI framework
+
+Copyright (C) 2012-2024  Ivan Gagis <igagis@gmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* ================ LICENSE END ================ */
+
+#include "worker_pool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+#include <utki/debug.hpp>
+
+using namespace ruis;
+
+worker_pool::worker_pool(unsigned num_threads) :
+	num_threads([&]() {
+		if (num_threads != 0) {
+			return num_threads;
+		}
+		auto n = std::thread::hardware_concurrency();
+		if (n <= 1) {
+			return 1U;
+		}
+		return n - 1;
+	}())
+{}
+
+worker_pool::~worker_pool()
+{
+	{
+		std::lock_guard lock(this->mutex);
+		this->quit = true;
+		this->tasks.clear();
+	}
+	this->cv.notify_all();
+
+	for (auto& t : this->threads) {
+		t.join();
+	}
+}
+
+void worker_pool::push(std::function<void()> task)
+{
+	{
+		std::lock_guard lock(this->mutex);
+		ASSERT(!this->quit)
+
+		if (this->threads.empty()) {
+			for (unsigned i = 0; i != this->num_threads; ++i) {
+				this->threads.emplace_back([this]() {
+					this->thread_func();
+				});
+			}
+		}
+
+		this->tasks.push_back(std::move(task));
+	}
+	this->cv.notify_one();
+}
+
+void worker_pool::thread_func()
+{
+	std::unique_lock lock(this->mutex);
+	for (;;) {
+		this->cv.wait(lock, [this]() {
+			return this->quit || !this->tasks.empty();
+		});
+
+		if (this->quit) {
+			return;
+		}
+
+		auto task = std::move(this->tasks.front());
+		this->tasks.pop_front();
+
+		lock.unlock();
+		task();
+
+		// destroy the task, along with its captured objects, outside of the lock
+		task = nullptr;
+
+		lock.lock();
+	}
+}
+
+void worker_pool::run(unsigned num_tasks, const std::function<void(unsigned)>& task)
+{
+	if (num_tasks == 0) {
+		return;
+	}
+
+	struct batch {
+		const std::function<void(unsigned)>* task;
+		const unsigned num_tasks;
+
+		std::atomic<unsigned> next_task{0};
+
+		std::mutex mutex;
+		std::condition_variable done_cv;
+		unsigned num_tasks_done = 0;
+
+		batch(const std::function<void(unsigned)>& task, unsigned num_tasks) :
+			task(&task),
+			num_tasks(num_tasks)
+		{}
+
+		// returns false if there are no more tasks to take
+		bool run_one()
+		{
+			unsigned index = this->next_task.fetch_add(1);
+			if (index >= this->num_tasks) {
+				// the task function can be already gone, do not touch it
+				return false;
+			}
+
+			(*this->task)(index);
+
+			std::lock_guard lock(this->mutex);
+			++this->num_tasks_done;
+			if (this->num_tasks_done == this->num_tasks) {
+				this->done_cv.notify_all();
+			}
+			return true;
+		}
+	};
+
+	// helper tasks can start after the batch is done, so they keep the batch alive
+	auto b = std::make_shared<batch>(task, num_tasks);
+
+	for (unsigned i = 0; i != std::min(this->num_threads, num_tasks - 1); ++i) {
+		this->push([b]() {
+			while (b->run_one()) {
+			}
+		});
+	}
+
+	while (b->run_one()) {
+	}
+
+	std::unique_lock lock(b->mutex);
+	b->done_cv.wait(lock, [&b]() {
+		return b->num_tasks_done == b->num_tasks;
+	});
+}
@@ -0,0 +1,102 @@
+/*
+ruis - GUI framework
+
+Copyright (C) 2012-2024  Ivan Gagis <igagis@gmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* ================ LICENSE END ================ */
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ruis {
+
+/**
+ * @brief Pool of worker threads for running tasks in background.
+ * Also used for running tasks in parallel, see run().
+ * Worker threads are started on first pushed task.
+ */
+class worker_pool
+{
+	const unsigned num_threads;
+
+	std::vector<std::thread> threads;
+
+	std::mutex mutex;
+	std::condition_variable cv;
+
+	std::deque<std::function<void()>> tasks;
+
+	bool quit = false;
+
+	void thread_func();
+
+public:
+	/**
+	 * @brief Constructor.
+	 * @param num_threads - number of worker threads. Zero means number of hardware threads minus one,
+	 *        but at least one.
+	 */
+	worker_pool(unsigned num_threads = 0);
+
+	worker_pool(const worker_pool&) = delete;
+	worker_pool& operator=(const worker_pool&) = delete;
+
+	worker_pool(worker_pool&&) = delete;
+	worker_pool& operator=(worker_pool&&) = delete;
+
+	/**
+	 * @brief Destructor.
+	 * Waits for the tasks which are being run to finish, tasks which have not started yet are dropped.
+	 */
+	~worker_pool();
+
+	/**
+	 * @brief Run task on a worker thread.
+	 * Tasks are started in the order they were pushed.
+	 * The task must not throw.
+	 * @param task - task to run.
+	 */
+	void push(std::function<void()> task);
+
+	/**
+	 * @brief Get number of worker threads.
+	 * @return Number of worker threads.
+	 */
+	unsigned size() const noexcept
+	{
+		return this->num_threads;
+	}
+
+	/**
+	 * @brief Run indexed tasks in parallel.
+	 * The tasks are run on worker threads and on the calling thread.
+	 * Returns when all the tasks are done. The calling thread runs the tasks which are not yet taken
+	 * by worker threads, so the function does not wait for the background tasks pushed earlier to finish.
+	 * The task must not throw.
+	 * @param num_tasks - number of tasks.
+	 * @param task - task function, called with task index.
+	 */
+	void run(unsigned num_tasks, const std::function<void(unsigned)>& task);
+};
+
+} // namespace ruis
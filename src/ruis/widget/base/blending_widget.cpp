@@ -22,6 +22,7 @@ along with this program. If not, see <http://www.gnu.org/licenses/>.
 #include "blending_widget.hpp"
 
 #include "../../context.hpp"
+#include "../../util/property_table.hpp"
 #include "../../util/util.hpp"
 
 using namespace ruis;
@@ -53,6 +54,24 @@ render::renderer::blend_factor blend_factor_from_string(const std::string& s)
 	}
 	return i->second;
 }
+
+enum class blending_property {
+	blend,
+	blend_src,
+	blend_dst,
+	blend_src_alpha,
+	blend_dst_alpha,
+
+	enum_size
+};
+
+constexpr property_table<blending_property> blending_properties({
+	"blend",
+	"blend_src",
+	"blend_dst",
+	"blend_src_alpha",
+	"blend_dst_alpha",
+});
 } // namespace
 
 blending_widget::blending_widget(const utki::shared_ref<ruis::context>& c, const tml::forest& desc) :
@@ -63,16 +82,24 @@ blending_widget::blending_widget(const utki::shared_ref<ruis::context>& c, const
 			continue;
 		}
 
-		if (p.value == "blend") {
-			this->params.enabled = get_property_value(p).to_bool();
-		} else if (p.value == "blend_src") {
-			this->params.factors.src = blend_factor_from_string(get_property_value(p).string);
-		} else if (p.value == "blend_dst") {
-			this->params.factors.dst = blend_factor_from_string(get_property_value(p).string);
-		} else if (p.value == "blend_src_alpha") {
-			this->params.factors.src_alpha = blend_factor_from_string(get_property_value(p).string);
-		} else if (p.value == "blend_dst_alpha") {
-			this->params.factors.dst_alpha = blend_factor_from_string(get_property_value(p).string);
+		switch (blending_properties.find(p.value.string)) {
+			case blending_property::blend:
+				this->params.enabled = get_property_value(p).to_bool();
+				break;
+			case blending_property::blend_src:
+				this->params.factors.src = blend_factor_from_string(get_property_value(p).string);
+				break;
+			case blending_property::blend_dst:
+				this->params.factors.dst = blend_factor_from_string(get_property_value(p).string);
+				break;
+			case blending_property::blend_src_alpha:
+				this->params.factors.src_alpha = blend_factor_from_string(get_property_value(p).string);
+				break;
+			case blending_property::blend_dst_alpha:
+				this->params.factors.dst_alpha = blend_factor_from_string(get_property_value(p).string);
+				break;
+			case blending_property::enum_size:
+				break;
 		}
 	}
 }
@@ -85,15 +112,13 @@ blending_widget::blending_widget(utki::shared_ref<ruis::context> context, parame
 void blending_widget::set_blending_to_renderer() const
 {
 	auto& r = this->context.get().renderer.get();
-	r.enable_blend(this->is_blending_enabled());
-	if (this->is_blending_enabled()) {
-		r.set_blend_func(
-			this->params.factors.src,
-			this->params.factors.dst,
-			this->params.factors.src_alpha,
-			this->params.factors.dst_alpha
-		);
-	}
+	r.set_blending({
+		.enabled = this->is_blending_enabled(),
+		.src_color = this->params.factors.src,
+		.dst_color = this->params.factors.dst,
+		.src_alpha = this->params.factors.src_alpha,
+		.dst_alpha = this->params.factors.dst_alpha
+	});
 }
 
 void blending_widget::set_blending_enabled(bool enable)
@@ -102,6 +127,7 @@ void blending_widget::set_blending_enabled(bool enable)
 		return;
 	}
 	this->params.enabled = enable;
+	this->clear_cache();
 	this->on_blending_change();
 }
 
@@ -111,5 +137,6 @@ void blending_widget::set_blending_factors(const blending_factors& params)
 		return;
 	}
 	this->params.factors = params;
+	this->clear_cache();
 	this->on_blending_change();
 }
@@ -21,10 +21,25 @@ along with this program. If not, see <http://www.gnu.org/licenses/>.
 
 #include "color_widget.hpp"
 
+#include "../../util/property_table.hpp"
 #include "../../util/util.hpp"
 
 using namespace ruis;
 
+namespace {
+enum class color_property {
+	color,
+	disabled_color,
+
+	enum_size
+};
+
+constexpr property_table<color_property> color_properties({
+	"color",
+	"disabled_color",
+});
+} // namespace
+
 color_widget::color_widget(utki::shared_ref<ruis::context> context, parameters params) :
 	widget(std::move(context), {}, {}),
 	params(std::move(params))
@@ -38,10 +53,15 @@ color_widget::color_widget(const utki::shared_ref<ruis::context>& c, const tml::
 			continue;
 		}
 
-		if (p.value == "color") {
-			this->params.color = get_property_value(p).to_uint32();
-		} else if (p.value == "disabled_color") {
-			this->params.disabled_color = get_property_value(p).to_uint32();
+		switch (color_properties.find(p.value.string)) {
+			case color_property::color:
+				this->params.color = get_property_value(p).to_uint32();
+				break;
+			case color_property::disabled_color:
+				this->params.disabled_color = get_property_value(p).to_uint32();
+				break;
+			case color_property::enum_size:
+				break;
 		}
 	}
 }
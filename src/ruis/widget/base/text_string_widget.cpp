@@ -76,6 +76,25 @@ vector2 text_string_widget::measure(const ruis::vector2& quotum) const noexcept
 	return ret;
 }
 
+font::render_result text_string_widget::render_string(
+	const ruis::matrix4& matrix,
+	r4::vector4<float> color,
+	size_t first_char
+) const
+{
+	const auto& font = this->get_font();
+
+	if (!this->glyph_run || this->glyph_run_font != &font || this->glyph_run_first_char != first_char) {
+		const auto& str = this->get_string();
+		ASSERT(first_char <= str.size())
+		this->glyph_run = font.make_glyph_run(str.substr(first_char));
+		this->glyph_run_font = &font;
+		this->glyph_run_first_char = first_char;
+	}
+
+	return this->glyph_run->render(matrix, color);
+}
+
 void text_string_widget::on_text_change()
 {
 	this->recompute_bounding_box();
@@ -85,6 +104,7 @@ void text_string_widget::on_text_change()
 void text_string_widget::set_text(string text)
 {
 	this->text_string = std::move(text);
+	this->glyph_run.reset();
 	this->invalidate_layout();
 	this->on_text_change();
 }
@@ -33,6 +33,11 @@ class text_string_widget : public text_widget
 
 	string text_string;
 
+	// cached glyph run of the text string, rebuilt on text or font change
+	mutable std::unique_ptr<const font::glyph_run> glyph_run;
+	mutable const font* glyph_run_font = nullptr;
+	mutable size_t glyph_run_first_char = 0;
+
 protected:
 	vector2 measure(const ruis::vector2& quotum) const noexcept override;
 
@@ -53,6 +58,18 @@ protected:
 
 	void set_text(string text);
 
+	/**
+	 * @brief Render the text string.
+	 * The string is rendered with normal style font using cached glyph run.
+	 * The glyph run is rebuilt only when the text, the font or the first rendered character changes.
+	 * @param matrix - transformation matrix to use when rendering.
+	 * @param color - text color.
+	 * @param first_char - index of the first character of the text string to render.
+	 * @return Render result.
+	 */
+	font::render_result render_string(const ruis::matrix4& matrix, r4::vector4<float> color, size_t first_char = 0)
+		const;
+
 public:
 	using text_widget::set_text;
 
@@ -78,6 +95,7 @@ public:
 
 	void on_font_change() override
 	{
+		this->glyph_run.reset();
 		this->recompute_bounding_box();
 	}
 
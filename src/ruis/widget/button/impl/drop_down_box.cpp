@@ -321,7 +321,12 @@ void drop_down_box::handle_mouse_button_up(bool is_first_button_up_event)
 
 utki::shared_ref<widget> drop_down_box::wrap_item(const utki::shared_ref<widget>& w, size_t index)
 {
-	auto wd = this->context.get().inflater.inflate_as<ruis::container>(item_layout);
+	auto& inflater = this->context.get().inflater;
+	if (!this->item_prototype.has_value()) {
+		this->item_prototype = inflater.make_prototype(item_layout);
+	}
+
+	auto wd = inflater.inflate_as<ruis::container>(this->item_prototype.value());
 
 	auto mp = wd.get().try_get_widget_as<mouse_proxy>("ruis_dropdown_mouseproxy");
 	ASSERT(mp)
@@ -356,4 +361,7 @@ void drop_down_box::on_reload()
 {
 	this->nine_patch_push_button::on_reload();
 	this->selection_box::on_reload();
+
+	// the prototype has variables substituted, which might have changed
+	this->item_prototype.reset();
 }
@@ -21,6 +21,8 @@ along with this program. If not, see <http://www.gnu.org/licenses/>.
 
 #pragma once
 
+#include <optional>
+
 #include "../selection_box.hpp"
 
 #include "nine_patch_push_button.hpp"
@@ -62,6 +64,9 @@ private:
 	// index of the hovered item in the drop down menu
 	int hovered_index = -1;
 
+	// prototype of the drop down menu item wrapper, created on first use
+	std::optional<inflater::prototype> item_prototype;
+
 	bool on_mouse_button(const mouse_button_event& e) override;
 	bool on_mouse_move(const mouse_move_event& e) override;
 
@@ -21,6 +21,8 @@ along with this program. If not, see <http://www.gnu.org/licenses/>.
 
 #include "selection_box.hpp"
 
+#include <optional>
+
 #include "../../context.hpp"
 
 #include "impl/drop_down_box.hpp"
@@ -33,7 +35,16 @@ namespace {
 // TODO: remove?
 class static_provider : public selection_box::provider
 {
-	std::vector<tml::tree> widgets;
+	struct item {
+		// single widget description
+		tml::forest desc;
+
+		// made on first use, since the prototype has templates and variables resolved
+		// which might change on reload
+		std::optional<inflater::prototype> proto;
+	};
+
+	std::vector<item> widgets;
 
 public:
 	size_t count() const noexcept override
@@ -43,9 +54,14 @@ public:
 
 	utki::shared_ref<widget> get_widget(size_t index) override
 	{
-		auto i = utki::next(this->widgets.begin(), index);
 		ASSERT(this->get_selection_box())
-		return this->get_selection_box()->context.get().inflater.inflate(i, i + 1);
+		auto& inflater = this->get_selection_box()->context.get().inflater;
+
+		auto& i = this->widgets[index];
+		if (!i.proto.has_value()) {
+			i.proto = inflater.make_prototype(i.desc);
+		}
+		return inflater.inflate(i.proto.value());
 	}
 
 	void recycle(size_t index, std::shared_ptr<widget> w) override
@@ -53,9 +69,16 @@ public:
 		//		TRACE(<< "static_provider::recycle(): index = " << index << std::endl)
 	}
 
+	void on_reload() override
+	{
+		for (auto& i : this->widgets) {
+			i.proto.reset();
+		}
+	}
+
 	void add(tml::tree w)
 	{
-		this->widgets.emplace_back(std::move(w));
+		this->widgets.emplace_back().desc.push_back(std::move(w));
 	}
 };
 } // namespace
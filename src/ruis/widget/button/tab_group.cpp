@@ -60,6 +60,7 @@ void tab_group::set_filler(std::shared_ptr<res::image> filler)
 {
 	this->filler = std::move(filler);
 	this->filler_texture = this->filler->get().to_shared_ptr();
+	this->clear_cache();
 }
 
 ruis::vector2 tab_group::measure(const ruis::vector2& quotum) const
@@ -101,7 +102,7 @@ ruis::vector2 tab_group::measure(const ruis::vector2& quotum) const
 			}
 		}
 
-		d = c.get().measure(d);
+		d = c.get().measure_cached(d);
 
 		length += d.x();
 
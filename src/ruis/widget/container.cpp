@@ -21,6 +21,8 @@ along with this program. If not, see <http://www.gnu.org/licenses/>.
 
 #include "container.hpp"
 
+#include <algorithm>
+
 #include <utki/config.hpp>
 
 #include "../context.hpp"
@@ -114,6 +116,10 @@ void container::render_child(const matrix4& matrix, const widget& c) const
 	ruis::matrix4 matr(matrix);
 	matr.translate(c.rect().p);
 
+	if (c.is_culled(matr)) {
+		return;
+	}
+
 	c.render_internal(matr);
 }
 
@@ -138,7 +144,7 @@ bool container::on_mouse_button(const mouse_button_event& e)
 			if (auto w = i->second.capturing_widget.lock()) {
 				if (w->is_interactive()) {
 					w->on_mouse_button(mouse_button_event{e.is_down, e.pos - w->rect().p, e.button, e.pointer_id});
-					w->set_hovered(w->rect().overlaps(e.pos), e.pointer_id);
+					this->set_child_hovered(*w, w->rect().overlaps(e.pos), e.pointer_id);
 
 					unsigned& num_buttons_captured = i->second.num_buttons_captured;
 					if (e.is_down) {
@@ -163,6 +169,10 @@ bool container::on_mouse_button(const mouse_button_event& e)
 		}
 	}
 
+	if (this->hit_test_index) {
+		return this->dispatch_mouse_button_indexed(e);
+	}
+
 	// call children in reverse order
 	for (auto i = this->children().rbegin(); i != this->children().rend(); ++i) {
 		auto& c = i->get();
@@ -220,7 +230,7 @@ bool container::on_mouse_move(const mouse_move_event& e)
 			if (auto w = i->second.capturing_widget.lock()) {
 				if (w->is_interactive()) {
 					w->on_mouse_move(mouse_move_event{e.pos - w->rect().p, e.pointer_id, e.ignore_mouse_capture});
-					w->set_hovered(w->rect().overlaps(e.pos), e.pointer_id);
+					this->set_child_hovered(*w, w->rect().overlaps(e.pos), e.pointer_id);
 
 					// doesn't matter what to return because parent widget also captured
 					// the mouse and in this case the return value is ignored
@@ -231,6 +241,10 @@ bool container::on_mouse_move(const mouse_move_event& e)
 		}
 	}
 
+	if (this->hit_test_index) {
+		return this->dispatch_mouse_move_indexed(e);
+	}
+
 	// call children in reverse order
 	for (auto i = this->children().rbegin(); i != this->children().rend(); ++i) {
 		auto& c = i->get();
@@ -273,11 +287,200 @@ void container::on_hovered_change(unsigned pointer_id)
 
 	// un-hover all the children since container became un-hovered
 	blocked_flag_guard blocked_guard(this->is_blocked);
+
+	if (this->hit_test_index) {
+		// only tracked children can be hovered
+		auto hovered = this->hit_test_index->hovered_children[pointer_id];
+		for (auto w : hovered) {
+			this->set_child_hovered(*w, false, pointer_id);
+		}
+		return;
+	}
+
 	for (auto& w : this->children()) {
 		w.get().set_hovered(false, pointer_id);
 	}
 }
 
+bool container::dispatch_mouse_button_indexed(const mouse_button_event& e)
+{
+	auto& index = this->get_valid_hit_test_index();
+
+	std::vector<size_t> candidates;
+	index.grid.query(e.pos, candidates);
+
+	// call candidate children in reverse order
+	for (auto i = candidates.rbegin(); i != candidates.rend(); ++i) {
+		ASSERT(*i < this->children().size())
+		const auto& cw = this->children()[*i];
+		auto& c = cw.get();
+
+		if (!c.is_interactive()) {
+			continue;
+		}
+
+		if (!c.rect().overlaps(e.pos)) {
+			continue;
+		}
+
+		// Sometimes mouse click event comes without prior mouse move,
+		// but, since we get mouse click, then the widget was hovered before the click.
+		this->set_child_hovered(c, true, e.pointer_id);
+
+		if (c.on_mouse_button(mouse_button_event{e.is_down, e.pos - c.rect().p, e.button, e.pointer_id})) {
+			ASSERT(this->mouse_capture_map.find(e.pointer_id) == this->mouse_capture_map.end())
+
+			if (e.is_down) {
+				this->mouse_capture_map.insert(
+					std::make_pair(e.pointer_id, mouse_capture_info{utki::make_weak(cw.to_shared_ptr()), 1})
+				);
+			}
+
+			// un-hover the underlying children
+			if (this->hit_test_index) {
+				auto hovered = this->hit_test_index->hovered_children[e.pointer_id];
+				for (auto w : hovered) {
+					auto j = this->hit_test_index->child_indices.find(w);
+					if (j != this->hit_test_index->child_indices.end() && j->second < *i) {
+						this->set_child_hovered(*w, false, e.pointer_id);
+					}
+				}
+			}
+
+			return true;
+		}
+	}
+
+	return this->widget::on_mouse_button(e);
+}
+
+bool container::dispatch_mouse_move_indexed(const mouse_move_event& e)
+{
+	auto& index = this->get_valid_hit_test_index();
+
+	std::vector<size_t> candidates;
+	index.grid.query(e.pos, candidates);
+
+	// children which were hovered before the event
+	auto prev_hovered = index.hovered_children[e.pointer_id];
+
+	std::vector<const widget*> hovered;
+
+	bool consumed = false;
+
+	// call candidate children in reverse order
+	for (auto i = candidates.rbegin(); i != candidates.rend(); ++i) {
+		ASSERT(*i < this->children().size())
+		auto& c = this->children()[*i].get();
+
+		if (!c.is_interactive()) {
+			continue;
+		}
+
+		if (!c.rect().overlaps(e.pos)) {
+			continue;
+		}
+
+		this->set_child_hovered(c, true, e.pointer_id);
+		hovered.push_back(&c);
+
+		if (c.on_mouse_move(mouse_move_event{e.pos - c.rect().p, e.pointer_id, e.ignore_mouse_capture})) {
+			consumed = true;
+			break;
+		}
+	}
+
+	// only previously hovered children can need un-hovering
+	for (auto w : prev_hovered) {
+		if (std::find(hovered.begin(), hovered.end(), w) == hovered.end()) {
+			this->set_child_hovered(*w, false, e.pointer_id);
+		}
+	}
+
+	return consumed;
+}
+
+void container::enable_hit_test_index(real cell_size)
+{
+	this->hit_test_index = std::make_unique<hit_test_index_type>(cell_size);
+
+	// track children which are already hovered
+	for (const auto& c : this->children()) {
+		for (auto pointer_id : c.get().hovered) {
+			this->hit_test_index->hovered_children[pointer_id].push_back(&c.get());
+		}
+	}
+}
+
+void container::disable_hit_test_index() noexcept
+{
+	this->hit_test_index.reset();
+}
+
+container::hit_test_index_type& container::get_valid_hit_test_index()
+{
+	ASSERT(this->hit_test_index)
+	auto& index = *this->hit_test_index;
+
+	if (index.valid) {
+		return index;
+	}
+
+	index.grid.clear();
+	index.child_indices.clear();
+
+	for (size_t i = 0; i != this->children().size(); ++i) {
+		const auto& c = this->children()[i].get();
+		index.grid.set(i, c.rect());
+		index.child_indices.insert(std::make_pair(&c, i));
+	}
+
+	index.valid = true;
+
+	return index;
+}
+
+void container::invalidate_hit_test_index() noexcept
+{
+	if (this->hit_test_index) {
+		this->hit_test_index->valid = false;
+	}
+}
+
+void container::update_hit_test_index(const widget& child)
+{
+	if (!this->hit_test_index || !this->hit_test_index->valid) {
+		return;
+	}
+
+	auto& index = *this->hit_test_index;
+
+	auto i = index.child_indices.find(&child);
+	ASSERT(i != index.child_indices.end())
+
+	index.grid.set(i->second, child.rect());
+}
+
+void container::set_child_hovered(widget& child, bool is_hovered, unsigned pointer_id)
+{
+	child.set_hovered(is_hovered, pointer_id);
+
+	// capturing widget might have been removed from this container
+	if (!this->hit_test_index || child.parent() != this) {
+		return;
+	}
+
+	auto& hovered = this->hit_test_index->hovered_children[pointer_id];
+	auto i = std::find(hovered.begin(), hovered.end(), &child);
+	if (is_hovered) {
+		if (i == hovered.end()) {
+			hovered.push_back(&child);
+		}
+	} else if (i != hovered.end()) {
+		hovered.erase(i);
+	}
+}
+
 vector2 container::measure(const vector2& quotum) const
 {
 	return this->get_layout().measure(quotum, this->children());
@@ -310,6 +513,10 @@ widget_list::const_iterator container::insert(const utki::shared_ref<widget>& w,
 	ww.parent_container = this;
 	ww.on_parent_change();
 
+	this->invalidate_id_index();
+	this->invalidate_hit_test_index();
+
+	this->clear_cache();
 	this->on_children_change();
 
 	ASSERT(!ww.is_hovered())
@@ -339,6 +546,17 @@ widget_list::const_iterator container::erase(widget_list::const_iterator child)
 	w.get().set_unhovered();
 	w.get().on_parent_change();
 
+	this->invalidate_id_index();
+
+	if (this->hit_test_index) {
+		this->hit_test_index->valid = false;
+		for (auto& h : this->hit_test_index->hovered_children) {
+			auto& hovered = h.second;
+			hovered.erase(std::remove(hovered.begin(), hovered.end(), &w.get()), hovered.end());
+		}
+	}
+
+	this->clear_cache();
 	this->on_children_change();
 
 	return ret;
@@ -350,12 +568,53 @@ void container::clear()
 	}
 }
 
-std::shared_ptr<widget> container::try_get_widget(std::string_view id, bool allow_itself) noexcept
+namespace {
+// adds widgets to the index in the same order as container::find_widget() visits them
+void add_to_id_index(std::unordered_map<std::string_view, widget*>& index, const container& c)
+{
+	for (const auto& w : c.children()) {
+		if (!w.get().id().empty()) {
+			// the first added widget is the nearest one, keep it
+			index.try_emplace(w.get().id(), &w.get());
+		}
+	}
+	for (const auto& w : c.children()) {
+		if (auto cont = dynamic_cast<const container*>(&w.get())) {
+			add_to_id_index(index, *cont);
+		}
+	}
+}
+} // namespace
+
+std::shared_ptr<widget> container::try_get_widget(std::string_view id, bool allow_itself)
 {
 	if (auto r = this->widget::try_get_widget(id, allow_itself)) {
 		return r;
 	}
 
+	if (!this->id_index) {
+		return this->find_widget(id);
+	}
+
+	auto& index = *this->id_index;
+
+	if (!index.valid) {
+		index.widgets.clear();
+		add_to_id_index(index.widgets, *this);
+		index.valid = true;
+	}
+
+	auto i = index.widgets.find(id);
+	if (i == index.widgets.end()) {
+		return nullptr;
+	}
+
+	ASSERT(i->second)
+	return utki::make_shared_from(*i->second).to_shared_ptr();
+}
+
+std::shared_ptr<widget> container::find_widget(std::string_view id)
+{
 	for (auto& w : this->children()) {
 		if (auto r = w.get().widget::try_get_widget(id, true)) {
 			return r;
@@ -369,6 +628,27 @@ std::shared_ptr<widget> container::try_get_widget(std::string_view id, bool allo
 	return nullptr;
 }
 
+void container::enable_id_index()
+{
+	this->id_index = std::make_unique<id_index_type>();
+}
+
+void container::disable_id_index() noexcept
+{
+	this->id_index.reset();
+}
+
+void container::invalidate_id_index() noexcept
+{
+	// the widget ids of the subtree are also indexed by the ancestors which have the index enabled
+	for (container* c = this; c; c = c->parent()) {
+		if (c->id_index && c->id_index->valid) {
+			c->id_index->valid = false;
+			c->id_index->widgets.clear();
+		}
+	}
+}
+
 widget_list::const_iterator container::change_child_z_position(
 	widget_list::const_iterator child,
 	widget_list::const_iterator before
@@ -415,6 +695,11 @@ widget_list::const_iterator container::change_child_z_position(
 		--ret;
 	}
 
+	// order of children affects which widget is found first
+	this->invalidate_id_index();
+	this->invalidate_hit_test_index();
+
+	this->clear_cache();
 	this->on_children_change();
 
 	return ret;
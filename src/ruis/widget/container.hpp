@@ -22,12 +22,16 @@ along with this program. If not, see <http://www.gnu.org/licenses/>.
 #pragma once
 
 #include <map>
+#include <memory>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 
 #include <utki/shared_ref.hpp>
 
 #include "../config.hpp"
 #include "../layout/trivial_layout.hpp"
+#include "../util/hit_test_grid.hpp"
 #include "../util/util.hpp"
 #include "../util/widget_list.hpp"
 
@@ -54,6 +58,8 @@ class layout;
  */
 class container : virtual public widget
 {
+	friend class widget;
+
 private:
 	// NOTE: according to C++11 standard it is undefined behaviour to read the inactive union member,
 	//       but we rely on compiler implementing it the right way.
@@ -117,6 +123,55 @@ private:
 		}
 	};
 
+private:
+	// Index of widget ids within the subtree, to find widgets by id without searching the subtree.
+	struct id_index_type {
+		// the index is rebuilt on next lookup after the subtree changes
+		bool valid = false;
+
+		// maps id to the first widget with that id in the order of the widget lookup
+		std::unordered_map<std::string_view, widget*> widgets;
+	};
+
+	std::unique_ptr<id_index_type> id_index;
+
+	void invalidate_id_index() noexcept;
+
+	std::shared_ptr<widget> find_widget(std::string_view id);
+
+private:
+	// Spatial index of children for dispatching mouse events only to children near the pointer.
+	struct hit_test_index_type {
+		hit_test_grid grid;
+
+		// the grid holds children indices, the index is rebuilt after the children list changes
+		bool valid = false;
+
+		std::unordered_map<const widget*, size_t> child_indices;
+
+		// hovered children per pointer id, to un-hover those when the pointer leaves them
+		std::map<unsigned, std::vector<widget*>> hovered_children;
+
+		hit_test_index_type(real cell_size) :
+			grid(cell_size)
+		{}
+	};
+
+	std::unique_ptr<hit_test_index_type> hit_test_index;
+
+	hit_test_index_type& get_valid_hit_test_index();
+
+	void invalidate_hit_test_index() noexcept;
+
+	// called by child when its rectangle changes
+	void update_hit_test_index(const widget& child);
+
+	// sets hovered state of the child, keeping track of hovered children when hit test index is enabled
+	void set_child_hovered(widget& child, bool is_hovered, unsigned pointer_id);
+
+	bool dispatch_mouse_button_indexed(const mouse_button_event& e);
+	bool dispatch_mouse_move_indexed(const mouse_move_event& e);
+
 protected:
 	void render_child(const matrix4& matrix, const widget& c) const;
 
@@ -167,6 +222,53 @@ public:
 
 	void on_hovered_change(unsigned pointer_id) override;
 
+	/**
+	 * @brief Enable spatial index for hit testing of children.
+	 * By default, mouse events are dispatched by checking every child.
+	 * With the index enabled, only the children near the mouse pointer are checked,
+	 * which is faster for containers with many children, e.g. large canvases.
+	 * The index is a uniform grid, cell size should be comparable to typical size of children.
+	 * @param cell_size - size of the index grid cell.
+	 */
+	void enable_hit_test_index(real cell_size);
+
+	/**
+	 * @brief Disable spatial index for hit testing of children.
+	 */
+	void disable_hit_test_index() noexcept;
+
+	/**
+	 * @brief Check if spatial index for hit testing of children is enabled.
+	 * @return true if the index is enabled.
+	 */
+	bool is_hit_test_index_enabled() const noexcept
+	{
+		return this->hit_test_index != nullptr;
+	}
+
+	/**
+	 * @brief Enable index of widget ids for lookups by id.
+	 * By default, looking up a widget by id searches through the whole subtree.
+	 * With the index enabled, the lookup is a hash table search, which is faster
+	 * for containers with large subtrees in which widgets are looked up often.
+	 * The index is rebuilt on the next lookup after the subtree changes.
+	 */
+	void enable_id_index();
+
+	/**
+	 * @brief Disable index of widget ids.
+	 */
+	void disable_id_index() noexcept;
+
+	/**
+	 * @brief Check if index of widget ids is enabled.
+	 * @return true if the index is enabled.
+	 */
+	bool is_id_index_enabled() const noexcept
+	{
+		return this->id_index != nullptr;
+	}
+
 	ruis::vector2 measure(const ruis::vector2& quotum) const override;
 
 	/**
@@ -272,7 +374,7 @@ public:
 	 * @return pointer to widget with given id if found.
 	 * @return nullptr if there is no widget with given id found.
 	 */
-	std::shared_ptr<widget> try_get_widget(std::string_view id, bool allow_itself = true) noexcept final;
+	std::shared_ptr<widget> try_get_widget(std::string_view id, bool allow_itself = true) final;
 
 	/**
 	 * @brief Get list of child widgets.
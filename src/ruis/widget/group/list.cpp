@@ -21,6 +21,8 @@ along with this program. If not, see <http://www.gnu.org/licenses/>.
 
 #include "list.hpp"
 
+#include <optional>
+
 #include <utki/config.hpp>
 
 #include "../../context.hpp"
@@ -40,7 +42,16 @@ list::list(utki::shared_ref<ruis::context> context, all_parameters params) :
 namespace {
 class static_provider : public list::provider
 {
-	std::vector<tml::tree> widgets;
+	struct item {
+		// single widget description
+		tml::forest desc;
+
+		// made on first use, since the prototype has templates and variables resolved
+		// which might change on reload
+		std::optional<inflater::prototype> proto;
+	};
+
+	std::vector<item> widgets;
 
 public:
 	size_t count() const noexcept override
@@ -51,9 +62,14 @@ public:
 	utki::shared_ref<widget> get_widget(size_t index) override
 	{
 		//		TRACE(<< "static_provider::getWidget(): index = " << index << std::endl)
-		auto i = utki::next(this->widgets.begin(), index);
 		ASSERT(this->get_list())
-		return this->get_list()->context.get().inflater.inflate(i, i + 1);
+		auto& inflater = this->get_list()->context.get().inflater;
+
+		auto& i = this->widgets[index];
+		if (!i.proto.has_value()) {
+			i.proto = inflater.make_prototype(i.desc);
+		}
+		return inflater.inflate(i.proto.value());
 	}
 
 	void recycle(size_t index, const utki::shared_ref<widget>& w) override
@@ -61,9 +77,16 @@ public:
 		//		TRACE(<< "static_provider::recycle(): index = " << index << std::endl)
 	}
 
+	void on_reload() override
+	{
+		for (auto& i : this->widgets) {
+			i.proto.reset();
+		}
+	}
+
 	void add(tml::tree w)
 	{
-		this->widgets.emplace_back(std::move(w));
+		this->widgets.emplace_back().desc.push_back(std::move(w));
 	}
 };
 } // namespace
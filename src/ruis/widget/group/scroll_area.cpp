@@ -87,6 +87,7 @@ void scroll_area::set_scroll_pos(const vector2& new_scroll_pos)
 	this->cur_scroll_pos = round(new_scroll_pos);
 
 	this->clamp_scroll_pos();
+	this->clear_cache();
 	this->update_scroll_factor();
 
 	this->on_scroll_pos_change();
@@ -144,7 +145,7 @@ vector2 scroll_area::dims_for_widget(const widget& w) const
 		}
 	}
 	if (!d.is_positive_or_zero()) {
-		vector2 md = w.measure(d);
+		vector2 md = w.measure_cached(d);
 		for (unsigned i = 0; i != md.size(); ++i) {
 			if (d[i] < 0) {
 				if (lp.dims[i].get_type() == dim::max && md[i] < this->rect().d[i]) {
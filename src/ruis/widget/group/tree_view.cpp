@@ -110,6 +110,17 @@ void tree_view::set_provider(std::shared_ptr<provider> item_provider)
 		// private base class
 		std::shared_ptr<list::provider>(item_provider, item_provider.get())
 	);
+	this->item_provider = std::move(item_provider);
+}
+
+void tree_view::on_reload()
+{
+	// the prototypes have variables substituted, which might have changed
+	if (this->item_provider) {
+		this->item_provider->prototypes.clear();
+	}
+
+	this->scroll_area::on_reload();
 }
 
 void tree_view::provider::notify_data_set_changed()
@@ -198,6 +209,17 @@ const tml::forest empty_layout = tml::read(R"qwertyuiop(
 	)qwertyuiop");
 } // namespace
 
+const inflater::prototype& tree_view::provider::get_prototype(const tml::forest& layout)
+{
+	auto i = this->prototypes.find(&layout);
+	if (i == this->prototypes.end()) {
+		ASSERT(this->get_list())
+		auto proto = this->get_list()->context.get().inflater.make_prototype(layout);
+		i = this->prototypes.insert(std::make_pair(&layout, std::move(proto))).first;
+	}
+	return i->second;
+}
+
 utki::shared_ref<widget> tree_view::provider::get_widget(size_t index)
 {
 	auto& i = this->iter_for(index);
@@ -226,16 +248,18 @@ utki::shared_ref<widget> tree_view::provider::get_widget(size_t index)
 	ASSERT(is_last_item_in_parent.size() == path.size())
 
 	for (unsigned i = 0; i != path.size() - 1; ++i) {
-		ret.get().push_back_inflate(is_last_item_in_parent[i] ? empty_layout : vert_line_layout);
+		ret.get().push_back(this->get_list()->context.get().inflater.inflate(
+			this->get_prototype(is_last_item_in_parent[i] ? empty_layout : vert_line_layout)
+		));
 	}
 
 	{
 		auto widget = this->get_list()->context.get().inflater.inflate_as<ruis::container>(
-			is_last_item_in_parent.back() ? line_end_layout : line_middle_layout
+			this->get_prototype(is_last_item_in_parent.back() ? line_end_layout : line_middle_layout)
 		);
 
 		if (this->count(utki::make_span(path)) != 0) {
-			auto w = this->get_list()->context.get().inflater.inflate(plus_minus_layout);
+			auto w = this->get_list()->context.get().inflater.inflate(this->get_prototype(plus_minus_layout));
 
 			auto plusminus = w.get().try_get_widget_as<ruis::image>("plusminus");
 			ASSERT(plusminus)
@@ -21,6 +21,7 @@ along with this program. If not, see <http://www.gnu.org/licenses/>.
 
 #pragma once
 
+#include <map>
 #include <memory>
 
 #include <utki/tree.hpp>
@@ -88,6 +89,11 @@ public:
 		void remove_children(decltype(iter) from);
 		void set_children(decltype(iter) i, size_t num_children);
 
+		// prototypes of the tree lines widgets, key is the layout the prototype is made from
+		std::map<const tml::forest*, inflater::prototype> prototypes;
+
+		const inflater::prototype& get_prototype(const tml::forest& layout);
+
 	protected:
 		provider() = default;
 
@@ -166,7 +172,12 @@ public:
 		return vector2(this->scroll_area::get_visible_area_fraction().x(), this->item_list.get().get_scroll_band());
 	}
 
+protected:
+	void on_reload() override;
+
 private:
+	std::shared_ptr<provider> item_provider;
+
 	void notify_view_change();
 };
 
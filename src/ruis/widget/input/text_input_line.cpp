@@ -61,7 +61,7 @@ void text_input_line::render(const ruis::matrix4& matrix) const
 
 		auto& r = this->context.get().renderer.get();
 		// NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers)
-		r.shader->color_pos->render(matr, r.pos_quad_01_vao.get(), 0xff804040);
+		r.render_quad(matr, 0xff804040);
 	}
 
 	{
@@ -77,11 +77,10 @@ void text_input_line::render(const ruis::matrix4& matrix) const
 		);
 
 		ASSERT(this->first_visible_char_index <= this->get_string().size())
-		font.render(
-			matr,
+		this->render_string(
+			matr, //
 			ruis::color_to_vec4f(this->get_current_color()),
-			this->get_string()
-				.substr(this->first_visible_char_index, this->get_string().size() - this->first_visible_char_index)
+			this->first_visible_char_index
 		);
 	}
 
@@ -91,7 +90,7 @@ void text_input_line::render(const ruis::matrix4& matrix) const
 		matr.scale(vector2(cursor_width * this->context.get().units.dots_per_fp(), this->rect().d.y()));
 
 		auto& r = this->context.get().renderer.get();
-		r.shader->color_pos->render(matr, r.pos_quad_01_vao.get(), this->get_current_color());
+		r.render_quad(matr, this->get_current_color());
 	}
 }
 
@@ -257,6 +256,7 @@ size_t text_input_line::pos_to_index(real pos)
 void text_input_line::update(uint32_t dt)
 {
 	this->cursor_blink_visible = !this->cursor_blink_visible;
+	this->clear_cache();
 }
 
 void text_input_line::on_focus_change()
@@ -267,6 +267,7 @@ void text_input_line::on_focus_change()
 		this->start_cursor_blinking();
 	} else {
 		this->context.get().updater.get().stop(*this);
+		this->clear_cache();
 	}
 }
 
@@ -280,6 +281,7 @@ void text_input_line::start_cursor_blinking()
 {
 	this->context.get().updater.get().stop(*this);
 	this->cursor_blink_visible = true;
+	this->clear_cache();
 	this->context.get().updater.get().start(
 		utki::make_shared_from(*static_cast<updateable*>(this)), //
 		cursor_blink_period
@@ -39,5 +39,5 @@ void color::render(const ruis::matrix4& matrix) const
 	ruis::matrix4 matr(matrix);
 	matr.scale(this->rect().d);
 
-	r.shader->color_pos->render(matr, r.pos_quad_01_vao.get(), this->get_current_color());
+	r.render_quad(matr, this->get_current_color());
 }
@@ -71,4 +71,5 @@ void spinner::set_active(bool active)
 void spinner::update(uint32_t dt_ms)
 {
 	angle += real(utki::pi) / real(std::milli::den) * real(dt_ms);
+	this->clear_cache();
 }
@@ -66,9 +66,8 @@ void text::render(const ruis::matrix4& matrix) const
 		font.get_ascender()
 	);
 
-	font.render(
+	this->render_string(
 		matr, //
-		ruis::color_to_vec4f(this->get_current_color()),
-		this->get_string()
+		ruis::color_to_vec4f(this->get_current_color())
 	);
 }
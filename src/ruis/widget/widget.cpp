@@ -21,13 +21,52 @@ along with this program. If not, see <http://www.gnu.org/licenses/>.
 
 #include "widget.hpp"
 
+#include <array>
+#include <typeinfo>
+
 #include "../context.hpp"
+#include "../util/property_table.hpp"
 #include "../util/util.hpp"
 
 #include "container.hpp"
 
 using namespace ruis;
 
+namespace {
+enum class widget_property {
+	lp,
+	x,
+	y,
+	dx,
+	dy,
+	id,
+	clip,
+	cache,
+	auto_cache,
+	visible,
+	enabled,
+	depth,
+
+	enum_size
+};
+
+// the order of names must correspond to the order of widget_property enum items
+constexpr property_table<widget_property> widget_properties({
+	"lp",
+	"x",
+	"y",
+	"dx",
+	"dy",
+	"id",
+	"clip",
+	"cache",
+	"auto_cache",
+	"visible",
+	"enabled",
+	"depth",
+});
+} // namespace
+
 // NOLINTNEXTLINE(modernize-pass-by-value)
 widget::widget(const utki::shared_ref<ruis::context>& c, const tml::forest& desc) :
 	context(c)
@@ -38,33 +77,51 @@ widget::widget(const utki::shared_ref<ruis::context>& c, const tml::forest& desc
 		}
 
 		try {
-			if (p.value == "lp") {
-				this->layout_params = layout_parameters::make(p.children, this->context.get().units);
-			} else if (p.value == "x") {
-				this->params.rectangle.p.x() =
-					parse_dimension_value(get_property_value(p), this->context.get().units).get(this->context);
-			} else if (p.value == "y") {
-				this->params.rectangle.p.y() =
-					parse_dimension_value(get_property_value(p), this->context.get().units).get(this->context);
-			} else if (p.value == "dx") {
-				this->params.rectangle.d.x() =
-					parse_dimension_value(get_property_value(p), this->context.get().units).get(this->context);
-			} else if (p.value == "dy") {
-				this->params.rectangle.d.y() =
-					parse_dimension_value(get_property_value(p), this->context.get().units).get(this->context);
-			} else if (p.value == "id") {
-				this->params.id = get_property_value(p).string;
-				// TRACE(<< "inflating '" << this->id << "'" << std::endl)
-			} else if (p.value == "clip") {
-				this->params.clip = get_property_value(p).to_bool();
-			} else if (p.value == "cache") {
-				this->params.cache = get_property_value(p).to_bool();
-			} else if (p.value == "visible") {
-				this->params.visible = get_property_value(p).to_bool();
-			} else if (p.value == "enabled") {
-				this->params.enabled = get_property_value(p).to_bool();
-			} else if (p.value == "depth") {
-				this->params.depth = get_property_value(p).to_bool();
+			switch (widget_properties.find(p.value.string)) {
+				case widget_property::lp:
+					this->layout_params = layout_parameters::make(p.children, this->context.get().units);
+					break;
+				case widget_property::x:
+					this->params.rectangle.p.x() =
+						parse_dimension_value(get_property_value(p), this->context.get().units).get(this->context);
+					break;
+				case widget_property::y:
+					this->params.rectangle.p.y() =
+						parse_dimension_value(get_property_value(p), this->context.get().units).get(this->context);
+					break;
+				case widget_property::dx:
+					this->params.rectangle.d.x() =
+						parse_dimension_value(get_property_value(p), this->context.get().units).get(this->context);
+					break;
+				case widget_property::dy:
+					this->params.rectangle.d.y() =
+						parse_dimension_value(get_property_value(p), this->context.get().units).get(this->context);
+					break;
+				case widget_property::id:
+					this->params.id = get_property_value(p).string;
+					// TRACE(<< "inflating '" << this->id << "'" << std::endl)
+					break;
+				case widget_property::clip:
+					this->params.clip = get_property_value(p).to_bool();
+					break;
+				case widget_property::cache:
+					this->params.cache = get_property_value(p).to_bool();
+					break;
+				case widget_property::auto_cache:
+					this->params.auto_cache_frames = get_property_value(p).to_uint32();
+					break;
+				case widget_property::visible:
+					this->params.visible = get_property_value(p).to_bool();
+					break;
+				case widget_property::enabled:
+					this->params.enabled = get_property_value(p).to_bool();
+					break;
+				case widget_property::depth:
+					this->params.depth = get_property_value(p).to_bool();
+					break;
+				case widget_property::enum_size:
+					// not a widget property
+					break;
 			}
 		} catch (std::invalid_argument&) {
 			LOG([&](auto& o) {
@@ -103,7 +160,7 @@ widget::widget(utki::shared_ref<ruis::context> context, layout_parameters layout
 	}
 }
 
-std::shared_ptr<widget> widget::try_get_widget(std::string_view id, bool allow_itself) noexcept
+std::shared_ptr<widget> widget::try_get_widget(std::string_view id, bool allow_itself)
 {
 	if (allow_itself && this->id() == id) {
 		return utki::make_shared_from(*this).to_shared_ptr();
@@ -145,7 +202,17 @@ widget& widget::get_ancestor(const std::string& id)
 
 void widget::move_to(const vector2& new_pos)
 {
+	if (this->params.rectangle.p == new_pos) {
+		return;
+	}
+
 	this->params.rectangle.p = new_pos;
+
+	// both old and new positions of the widget are within the parent's area
+	if (auto p = this->parent()) {
+		p->clear_cache();
+		p->update_hit_test_index(*this);
+	}
 }
 
 void widget::resize(const ruis::vector2& new_dims)
@@ -160,6 +227,11 @@ void widget::resize(const ruis::vector2& new_dims)
 	using std::max;
 
 	this->params.rectangle.d = max(new_dims, real(0)); // clamp bottom
+
+	if (auto p = this->parent()) {
+		p->update_hit_test_index(*this);
+	}
+
 	this->on_resize();
 }
 
@@ -201,6 +273,13 @@ utki::shared_ref<widget> widget::replace_by(const utki::shared_ref<widget>& w)
 
 void widget::invalidate_layout() noexcept
 {
+	// the widget could have been measured since the layout became dirty,
+	// so clear the measure cache of the widget and all its ancestors in any case
+	for (const widget* w = this; w; w = w->parent()) {
+		w->measure_cache.clear();
+		w->cache_dirty = true;
+	}
+
 	if (this->layout_dirty) {
 		return;
 	}
@@ -208,9 +287,6 @@ void widget::invalidate_layout() noexcept
 	if (this->parent()) {
 		this->parent()->invalidate_layout();
 	}
-
-	// TODO: this->clear_cache()?
-	this->cache_frame_buffer.reset();
 }
 
 void widget::render_internal(const ruis::matrix4& matrix) const
@@ -221,12 +297,27 @@ void widget::render_internal(const ruis::matrix4& matrix) const
 
 	auto& r = this->context.get().renderer.get();
 
-	if (this->params.cache) {
+	// attribute rendering statistics to the class of this widget
+	utki::scope_exit widget_class_scope_exit(
+		[&r, prev_widget_class = r.get_stats().set_widget_class(&typeid(*this))]() {
+			r.get_stats().set_widget_class(prev_widget_class);
+		}
+	);
+
+	this->last_device_rect = this->compute_device_rect(matrix);
+
+	if (this->appearance_generation != this->context.get().appearance_generation) {
+		// some resource used by the widget might have changed its appearance
+		this->appearance_generation = this->context.get().appearance_generation;
+		this->cache_dirty = true;
+	}
+
+	if (this->params.cache || this->update_auto_cache()) {
 		if (this->cache_dirty) {
-			utki::scope_exit scissor_test_enabled_scope_exit([&r, scissor_test_was_enabled = r.is_scissor_enabled()]() {
-				r.enable_scissor(scissor_test_was_enabled);
+			utki::scope_exit scissor_scope_exit([&r, old_scissor = r.get_scissor_state()]() {
+				r.set_scissor_state(old_scissor);
 			});
-			r.enable_scissor(false);
+			r.set_scissor_state({.enabled = false});
 
 			this->cache_frame_buffer = this->render_to_texture(std::move(this->cache_frame_buffer)).to_shared_ptr();
 
@@ -239,35 +330,39 @@ void widget::render_internal(const ruis::matrix4& matrix) const
 		this->render_from_cache(matrix);
 	} else {
 		if (this->params.depth) {
+			// quads recorded so far have to be rendered without depth test
+			r.flush();
 			r.enable_depth(true);
 			r.clear_framebuffer_depth();
 		}
 
 		if (this->params.clip) {
-			r4::rectangle<uint32_t> scissor = this->compute_viewport_rect(matrix);
-
-			r4::rectangle<uint32_t> old_scissor{};
-			bool scissor_test_was_enabled = r.is_scissor_enabled();
-			if (scissor_test_was_enabled) {
-				old_scissor = r.get_scissor();
-				scissor.intersect(old_scissor);
-			} else {
-				r.enable_scissor(true);
+			auto old_scissor = r.get_scissor_state();
+
+			render::renderer::scissor scissor{.enabled = true, .rect = this->compute_viewport_rect(matrix)};
+			if (old_scissor.enabled) {
+				scissor.rect.intersect(old_scissor.rect);
 			}
 
-			r.set_scissor(scissor);
+			r.set_scissor_state(scissor);
+
+			auto old_cull_rect = r.get_cull_rect();
+			auto cull_rect = old_cull_rect;
+			cull_rect.intersect(this->compute_device_rect(matrix));
+			r.set_cull_rect(cull_rect);
 
 			this->render(matrix);
 
-			if (scissor_test_was_enabled) {
-				r.set_scissor(old_scissor);
-			} else {
-				r.enable_scissor(false);
-			}
+			r.set_cull_rect(old_cull_rect);
+
+			r.set_scissor_state(old_scissor);
 		} else {
 			this->render(matrix);
 		}
 
+		if (this->params.depth) {
+			r.flush();
+		}
 		r.enable_depth(false);
 	}
 
@@ -322,6 +417,12 @@ utki::shared_ref<render::frame_buffer> widget::render_to_texture(std::shared_ptr
 	});
 	r.set_viewport(r4::rectangle<uint32_t>(0, this->rect().d.to<uint32_t>()));
 
+	// the widget is rendered to texture entirely
+	utki::scope_exit cull_rect_scope_exit([old_cull_rect = r.get_cull_rect(), &r]() {
+		r.set_cull_rect(old_cull_rect);
+	});
+	r.set_cull_rect({{-1, -1}, {2, 2}});
+
 	r.clear_framebuffer_color();
 
 	utki::scope_exit depth_scope_exit([old_depth = r.is_depth_enabled(), &r]() {
@@ -335,6 +436,9 @@ utki::shared_ref<render::frame_buffer> widget::render_to_texture(std::shared_ptr
 
 	this->render(make_viewport_matrix(r.initial_matrix, this->rect().d));
 
+	// render recorded quads before viewport and depth test are restored
+	r.flush();
+
 	return fb;
 }
 
@@ -346,15 +450,68 @@ void widget::render_from_cache(const r4::matrix4<float>& matrix) const
 	auto& r = this->context.get().renderer.get();
 	ASSERT(this->cache_frame_buffer)
 	ASSERT(this->cache_frame_buffer->color)
-	r.shader->pos_tex->render(matr, r.pos_tex_quad_01_vao.get(), *this->cache_frame_buffer->color);
+	r.render_quad(matr, utki::shared_ref<const render::texture_2d>(this->cache_frame_buffer->color));
 }
 
 void widget::clear_cache()
 {
+	// widgets within caching ancestor are rendered to the ancestor's texture,
+	// so on the screen it is the outermost caching ancestor which gets damaged
+	const widget* damaged = this;
+	for (const widget* w = this; w; w = w->parent()) {
+		w->cache_dirty = true;
+		if (w->is_cached()) {
+			damaged = w;
+		}
+	}
+
+	damaged->report_damage();
+}
+
+bool widget::update_auto_cache() const
+{
+	if (this->params.auto_cache_frames == 0) {
+		return false;
+	}
+
+	if (this->cache_dirty) {
+		// appearance has changed since last frame, drop the cache if any
+		this->num_static_frames = 0;
+		this->auto_cached = false;
+		this->cache_frame_buffer.reset();
+		this->cache_dirty = false;
+		return false;
+	}
+
+	if (this->auto_cached) {
+		return true;
+	}
+
+	++this->num_static_frames;
+	if (this->num_static_frames < this->params.auto_cache_frames) {
+		return false;
+	}
+
+	// the widget has been static for long enough, render it to texture
+	this->auto_cached = true;
 	this->cache_dirty = true;
-	if (this->parent()) {
-		this->parent()->clear_cache();
+	return true;
+}
+
+void widget::report_damage() const
+{
+	auto& c = this->context.get();
+
+	// in case the widget has not been rendered yet, then the area where it will appear is unknown,
+	// so report the area of the nearest ancestor which has been rendered
+	for (const widget* w = this; w; w = w->parent()) {
+		if (w->last_device_rect.d.is_positive()) {
+			c.add_damage(w->last_device_rect);
+			return;
+		}
 	}
+
+	c.add_damage_all();
 }
 
 void widget::on_key_internal(const ruis::key_event& e)
@@ -405,6 +562,47 @@ r4::rectangle<uint32_t> widget::compute_viewport_rect(const matrix4& matrix) con
 	return ret;
 }
 
+r4::rectangle<float> widget::compute_device_rect(const matrix4& matrix) const noexcept
+{
+	const auto& d = this->rect().d;
+
+	std::array<vector2, 4> corners = {
+		matrix * vector2(0, 0), //
+		matrix * vector2(0, d.y()),
+		matrix * d,
+		matrix * vector2(d.x(), 0)
+	};
+
+	vector2 bb_min = corners.front();
+	vector2 bb_max = corners.front();
+	for (const auto& c : corners) {
+		using std::min;
+		using std::max;
+		for (size_t i = 0; i != c.size(); ++i) {
+			bb_min[i] = min(bb_min[i], c[i]);
+			bb_max[i] = max(bb_max[i], c[i]);
+		}
+	}
+
+	return {bb_min, bb_max - bb_min};
+}
+
+bool widget::is_culled(const matrix4& matrix) const noexcept
+{
+	auto dr = this->compute_device_rect(matrix);
+	auto dr_end = dr.x2_y2();
+
+	const auto& cr = this->context.get().renderer.get().get_cull_rect();
+	auto cr_end = cr.x2_y2();
+
+	for (size_t i = 0; i != dr.p.size(); ++i) {
+		if (dr_end[i] <= cr.p[i] || cr_end[i] <= dr.p[i]) {
+			return true;
+		}
+	}
+	return false;
+}
+
 ruis::vector2 widget::get_absolute_pos() const noexcept
 {
 	if (!this->parent()) {
@@ -426,6 +624,30 @@ vector2 widget::measure(const ruis::vector2& quotum) const
 	return max(quotum, 0);
 }
 
+namespace {
+// usually a widget is measured with just a couple of different quotums during layout pass
+constexpr size_t max_measure_cache_size = 4;
+} // namespace
+
+vector2 widget::measure_cached(const vector2& quotum) const
+{
+	for (const auto& e : this->measure_cache) {
+		if (e.first == quotum) {
+			return e.second;
+		}
+	}
+
+	auto ret = this->measure(quotum);
+
+	if (this->measure_cache.size() == max_measure_cache_size) {
+		// evict the oldest entry
+		this->measure_cache.erase(this->measure_cache.begin());
+	}
+	this->measure_cache.emplace_back(quotum, ret);
+
+	return ret;
+}
+
 vector2 widget::pos_in_ancestor(vector2 pos, const widget* ancestor)
 {
 	if (ancestor == this || !this->parent()) {
@@ -469,6 +691,7 @@ void widget::set_enabled(bool enable)
 	}
 
 	this->params.enabled = enable;
+	this->clear_cache();
 
 	// un-hover this widget if it becomes disabled because it is not supposed to receive mouse input
 	if (!this->is_enabled()) {
@@ -480,7 +703,13 @@ void widget::set_enabled(bool enable)
 
 void widget::set_visible(bool visible)
 {
+	if (this->params.visible == visible) {
+		return;
+	}
+
 	this->params.visible = visible;
+	this->clear_cache();
+
 	if (!this->params.visible) {
 		this->set_unhovered();
 	}
@@ -541,7 +770,7 @@ vector2 ruis::dims_for_widget(const widget& w, const vector2& parent_dims)
 		}
 	}
 	if (!d.is_positive_or_zero()) {
-		vector2 md = w.measure(d);
+		vector2 md = w.measure_cached(d);
 		for (unsigned i = 0; i != md.size(); ++i) {
 			if (d[i] < 0) {
 				d[i] = md[i];
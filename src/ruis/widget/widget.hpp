@@ -24,6 +24,8 @@ along with this program. If not, see <http://www.gnu.org/licenses/>.
 #include <memory>
 #include <set>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include <r4/matrix.hpp>
 #include <r4/rectangle.hpp>
@@ -58,6 +60,8 @@ class container;
  * value is false.
  * @li @c cache - enable (true) or disable (false) pre-rendering this widget to texture and render from texture for
  * faster rendering.
+ * @li @c auto_cache - number of frames after which the widget is automatically cached if its appearance stays
+ * unchanged. Default value is 0, which means no automatic caching.
  * @li @c visible - should the widget be initially visible (true) or hidden (false). Default value is true.
  * @li @c enabled - should the widget be initially enabled (true) or disabled (false). Default value is true. Disabled
  * widgets do not get any input from keyboard or mouse.
@@ -98,12 +102,37 @@ public:
 	}
 
 private:
+	// for widgets without caching this flag indicates that the appearance has changed since last render
 	mutable bool cache_dirty = true;
 	mutable std::shared_ptr<render::frame_buffer> cache_frame_buffer;
 
+	// context's appearance generation at the moment the widget was rendered last time
+	mutable unsigned appearance_generation = 0;
+
+	mutable bool auto_cached = false;
+	mutable unsigned num_static_frames = 0;
+
+	bool update_auto_cache() const;
+
+	bool is_cached() const noexcept
+	{
+		return this->params.cache || this->auto_cached;
+	}
+
 	void render_from_cache(const r4::matrix4<float>& matrix) const;
 
+	// bounding box of the widget in normalized device coordinates at the moment it was rendered last time
+	mutable r4::rectangle<float> last_device_rect{0, 0};
+
+	void report_damage() const;
+
 protected:
+	/**
+	 * @brief Notify that the widget's appearance has changed.
+	 * Marks the render caches of the widget and all its ancestors dirty and reports the
+	 * on-screen area of the widget as damaged, so that it is re-rendered during next gui::render().
+	 * Widgets must call this function whenever their appearance changes without layout invalidation.
+	 */
 	void clear_cache();
 
 public:
@@ -117,6 +146,26 @@ public:
 	void set_cache(bool enabled) noexcept
 	{
 		this->params.cache = enabled;
+		if (!this->is_cached()) {
+			this->cache_frame_buffer.reset();
+		}
+		this->cache_dirty = true;
+	}
+
+	/**
+	 * @brief Set automatic caching.
+	 * See parameters::auto_cache_frames for details.
+	 * @param num_frames - number of unchanged frames after which the widget is cached.
+	 *                     Zero disables automatic caching.
+	 */
+	void set_auto_cache(unsigned num_frames) noexcept
+	{
+		this->params.auto_cache_frames = num_frames;
+		if (num_frames == 0 && this->auto_cached) {
+			this->auto_cached = false;
+			this->cache_frame_buffer.reset();
+		}
+		this->num_static_frames = 0;
 	}
 
 	/**
@@ -278,6 +327,22 @@ public:
 	 */
 	r4::rectangle<uint32_t> compute_viewport_rect(const matrix4& matrix) const noexcept;
 
+	/**
+	 * @brief Get bounding box of the widget in normalized device coordinates.
+	 * @param matrix - transformation matrix which transforms point (0,0) to left top corner point of the widget.
+	 * @return Bounding box of the widget's rectangle transformed by the matrix.
+	 */
+	r4::rectangle<float> compute_device_rect(const matrix4& matrix) const noexcept;
+
+	/**
+	 * @brief Check if the widget is culled.
+	 * The widget is culled if its rectangle does not intersect the renderer's culling rectangle.
+	 * @param matrix - transformation matrix which transforms point (0,0) to left top corner point of the widget.
+	 * @return true if the widget is not visible on the screen and its rendering can be skipped.
+	 * @return false otherwise.
+	 */
+	bool is_culled(const matrix4& matrix) const noexcept;
+
 	/**
 	 * @brief Move widget to position within its parent.
 	 * @param new_pos - new widget's position.
@@ -318,7 +383,7 @@ public:
 	 * @return pointer to the widget if found.
 	 * @return nullptr if there is no widget with given id found.
 	 */
-	virtual std::shared_ptr<widget> try_get_widget(std::string_view id, bool allow_itself = true) noexcept;
+	virtual std::shared_ptr<widget> try_get_widget(std::string_view id, bool allow_itself = true);
 
 	/**
 	 * @brief Try get widget by id.
@@ -329,7 +394,7 @@ public:
 	 * @return nullptr if there is no widget with given id found or if the widget could not be cast to specified class.
 	 */
 	template <typename widget_type>
-	std::shared_ptr<widget_type> try_get_widget_as(std::string_view id, bool allow_itself = true) noexcept
+	std::shared_ptr<widget_type> try_get_widget_as(std::string_view id, bool allow_itself = true)
 	{
 		return std::dynamic_pointer_cast<widget_type>(this->try_get_widget(id, allow_itself));
 	}
@@ -442,6 +507,14 @@ public:
 		 * @brief Usage of depth buffer for rendering the widget.
 		 */
 		bool depth = false;
+
+		/**
+		 * @brief Automatic caching of widget's image to texture.
+		 * If not zero, the widget is automatically cached after its appearance has stayed
+		 * unchanged for this number of rendered frames. Once the appearance changes, the cache is dropped.
+		 * Zero disables the automatic caching.
+		 */
+		unsigned auto_cache_frames = 0;
 	};
 
 	struct all_parameters {
@@ -601,6 +674,20 @@ public:
 	 */
 	virtual vector2 measure(const vector2& quotum) const;
 
+private:
+	// last measure() results, cleared by invalidate_layout()
+	mutable std::vector<std::pair<vector2, vector2>> measure_cache;
+
+public:
+	/**
+	 * @brief Measure the widget using cached result if possible.
+	 * Same as measure(), but the result is memoized per quotum until the layout is invalidated.
+	 * Layouts should use this function to measure the child widgets.
+	 * @param quotum - space available to widget. See measure() for details.
+	 * @return Measured desired widget dimensions.
+	 */
+	vector2 measure_cached(const vector2& quotum) const;
+
 public:
 	/**
 	 * @brief Show/hide widget.
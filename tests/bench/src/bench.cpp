@@ -0,0 +1,131 @@
+#include "bench.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <new>
+#include <utility>
+
+namespace {
+std::atomic<uint64_t> num_allocations{0};
+std::atomic<uint64_t> num_allocated_bytes{0};
+
+void* allocate(std::size_t size)
+{
+	num_allocations.fetch_add(1, std::memory_order_relaxed);
+	num_allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+
+	// NOLINTNEXTLINE(cppcoreguidelines-no-malloc)
+	void* p = std::malloc(size == 0 ? 1 : size);
+	if (!p) {
+		throw std::bad_alloc();
+	}
+	return p;
+}
+} // namespace
+
+// replace global allocation functions to count allocations
+
+void* operator new(std::size_t size)
+{
+	return allocate(size);
+}
+
+void* operator new[](std::size_t size)
+{
+	return allocate(size);
+}
+
+void operator delete(void* p) noexcept
+{
+	// NOLINTNEXTLINE(cppcoreguidelines-no-malloc)
+	std::free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+	// NOLINTNEXTLINE(cppcoreguidelines-no-malloc)
+	std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+	// NOLINTNEXTLINE(cppcoreguidelines-no-malloc)
+	std::free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept
+{
+	// NOLINTNEXTLINE(cppcoreguidelines-no-malloc)
+	std::free(p);
+}
+
+using namespace bench;
+
+allocations bench::get_allocations() noexcept
+{
+	return {
+		.count = num_allocations.load(std::memory_order_relaxed),
+		.bytes = num_allocated_bytes.load(std::memory_order_relaxed)
+	};
+}
+
+runner::runner(settings params, std::ostream& out, std::function<uint64_t()> get_draw_calls) :
+	params(std::move(params)),
+	out(out),
+	get_draw_calls(std::move(get_draw_calls))
+{
+	this->out << "name\titerations\tns/op\tallocs/op\tbytes/op\tdraw_calls/op" << std::endl;
+}
+
+void runner::run(const std::string& name, const std::function<void()>& op)
+{
+	if (!this->params.filter.empty() && name.find(this->params.filter) == std::string::npos) {
+		return;
+	}
+
+	using clock = std::chrono::steady_clock;
+
+	// warm up, to fill caches
+	op();
+
+	result res;
+	res.name = name;
+
+	for (uint64_t num_iterations = 1;; num_iterations *= 2) {
+		auto allocs_before = get_allocations();
+		auto draw_calls_before = this->get_draw_calls();
+		auto start = clock::now();
+
+		for (uint64_t i = 0; i != num_iterations; ++i) {
+			op();
+		}
+
+		auto duration = clock::now() - start;
+		auto allocs_after = get_allocations();
+		auto draw_calls_after = this->get_draw_calls();
+
+		auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+
+		auto n = double(num_iterations);
+
+		res.iterations = num_iterations;
+		res.ns_per_op = double(ns) / n;
+		res.allocs_per_op = double(allocs_after.count - allocs_before.count) / n;
+		res.bytes_per_op = double(allocs_after.bytes - allocs_before.bytes) / n;
+		res.draw_calls_per_op = double(draw_calls_after - draw_calls_before) / n;
+
+		if (std::chrono::duration_cast<std::chrono::milliseconds>(duration).count() >= this->params.min_time_ms) {
+			break;
+		}
+	}
+
+	this->out << res.name << '\t' //
+			  << res.iterations << '\t' //
+			  << std::fixed << std::setprecision(1) //
+			  << res.ns_per_op << '\t' //
+			  << res.allocs_per_op << '\t' //
+			  << res.bytes_per_op << '\t' //
+			  << res.draw_calls_per_op << std::endl;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+
+namespace bench {
+
+/**
+ * @brief Counters of heap allocations.
+ * The counters are incremented by the global operator new replacement.
+ */
+struct allocations {
+	uint64_t count = 0;
+	uint64_t bytes = 0;
+};
+
+allocations get_allocations() noexcept;
+
+struct settings {
+	// minimal total time to spend in a single benchmark
+	uint32_t min_time_ms = 200;
+
+	// run only the benchmarks which have this substring in their names
+	std::string filter;
+};
+
+struct result {
+	std::string name;
+	uint64_t iterations = 0;
+	double ns_per_op = 0;
+	double allocs_per_op = 0;
+	double bytes_per_op = 0;
+	double draw_calls_per_op = 0;
+};
+
+/**
+ * @brief Benchmark runner.
+ * Runs each benchmark with growing number of iterations until the total time reaches the minimal time,
+ * then reports per-operation numbers of the last run.
+ * The results are printed as tab separated values, one line per benchmark, preceded by a header line.
+ * The format is intended to be stable so that results of different versions can be compared by scripts.
+ */
+class runner
+{
+	settings params;
+
+	std::ostream& out;
+
+	// returns number of draw calls done so far
+	std::function<uint64_t()> get_draw_calls;
+
+public:
+	runner(settings params, std::ostream& out, std::function<uint64_t()> get_draw_calls);
+
+	/**
+	 * @brief Run benchmark.
+	 * @param name - benchmark name.
+	 * @param op - operation to benchmark. Called once per iteration.
+	 */
+	void run(const std::string& name, const std::function<void()>& op);
+};
+
+} // namespace bench
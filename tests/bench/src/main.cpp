@@ -0,0 +1,201 @@
+#include <iostream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <papki/fs_file.hpp>
+#include <ruis/gui.hpp>
+#include <ruis/updater.hpp>
+#include <ruis/widget/container.hpp>
+
+#include "../../harness/util/dummy_context.hpp"
+
+#include "bench.hpp"
+#include "scene.hpp"
+
+using namespace std::string_literals;
+using namespace std::string_view_literals;
+
+namespace {
+struct options {
+	bench::settings settings;
+	unsigned depth = 4;
+	unsigned width = 4;
+	unsigned num_updateables = 1000;
+	unsigned num_template_instances = 100;
+	unsigned num_canvas_items = 10000;
+};
+
+options parse_args(utki::span<const char*> args)
+{
+	options ret;
+
+	auto get_value = [](std::string_view arg, std::string_view key) -> std::optional<std::string_view> {
+		if (arg.substr(0, key.size()) != key) {
+			return std::nullopt;
+		}
+		return arg.substr(key.size());
+	};
+
+	for (std::string_view arg : args) {
+		if (auto v = get_value(arg, "--min-time-ms="sv)) {
+			ret.settings.min_time_ms = std::stoul(std::string(*v));
+		} else if (auto v = get_value(arg, "--filter="sv)) {
+			ret.settings.filter = *v;
+		} else if (auto v = get_value(arg, "--depth="sv)) {
+			ret.depth = std::stoul(std::string(*v));
+		} else if (auto v = get_value(arg, "--width="sv)) {
+			ret.width = std::stoul(std::string(*v));
+		} else if (auto v = get_value(arg, "--updateables="sv)) {
+			ret.num_updateables = std::stoul(std::string(*v));
+		} else if (auto v = get_value(arg, "--template-instances="sv)) {
+			ret.num_template_instances = std::stoul(std::string(*v));
+		} else if (auto v = get_value(arg, "--canvas-items="sv)) {
+			ret.num_canvas_items = std::stoul(std::string(*v));
+		} else {
+			throw std::invalid_argument(std::string("unknown argument: ") + std::string(arg));
+		}
+	}
+
+	return ret;
+}
+
+class test_updateable : public ruis::updateable
+{
+public:
+	void update(uint32_t dt) override {}
+};
+} // namespace
+
+int main(int argc, const char** argv)
+{
+	auto opts = parse_args(utki::make_span(argv, argc).subspan(1));
+
+	ruis::gui gui(make_dummy_context());
+	{
+		papki::fs_file res_dir("../../res/ruis_res/");
+		gui.init_standard_widgets(res_dir);
+	}
+
+	auto& renderer = gui.context.get().renderer.get();
+
+	// renderer statistics are reset after each frame, so accumulate draw calls of finished frames
+	uint64_t finished_frames_draw_calls = 0;
+
+	auto render_frame = [&]() {
+		gui.render();
+		finished_frames_draw_calls += renderer.get_frame_stats().total().draw_calls;
+	};
+
+	bench::runner runner(opts.settings, std::cout, [&]() {
+		return finished_frames_draw_calls + renderer.get_stats().total().draw_calls;
+	});
+
+	auto suffix = "/d"s + std::to_string(opts.depth) + "w" + std::to_string(opts.width);
+
+	auto scene = tml::read(bench::make_scene(opts.depth, opts.width));
+
+	runner.run("inflate"s + suffix, [&]() {
+		gui.context.get().inflater.inflate(scene);
+	});
+
+	{
+		auto template_scene = tml::read(bench::make_template_scene(opts.num_template_instances));
+
+		runner.run("inflate_templates/n"s + std::to_string(opts.num_template_instances), [&]() {
+			gui.context.get().inflater.inflate(template_scene);
+		});
+	}
+
+	auto root = gui.context.get().inflater.inflate(scene);
+
+	const ruis::vector2 viewport_size = {1024, 768};
+
+	gui.set_root(root);
+	gui.set_viewport(viewport_size);
+
+	runner.run("layout_render"s + suffix, [&]() {
+		root.get().invalidate_layout();
+		render_frame();
+	});
+
+	runner.run("render"s + suffix, [&]() {
+		render_frame();
+	});
+
+	// move mouse pointer over a grid of points covering the whole viewport
+	std::vector<ruis::vector2> points;
+	{
+		constexpr auto grid_size = 32;
+		for (unsigned y = 0; y != grid_size; ++y) {
+			for (unsigned x = 0; x != grid_size; ++x) {
+				points.emplace_back(
+					viewport_size.comp_mul(ruis::vector2(ruis::real(x), ruis::real(y)) / ruis::real(grid_size))
+				);
+			}
+		}
+	}
+
+	auto run_mouse_move = [&](const std::string& name) {
+		size_t i = 0;
+		runner.run(name, [&]() {
+			gui.send_mouse_move(points[i], 0);
+			++i;
+			if (i == points.size()) {
+				i = 0;
+			}
+		});
+	};
+
+	run_mouse_move("mouse_move"s + suffix);
+
+	{
+		constexpr auto item_size = 8;
+
+		auto canvas = gui.context.get().inflater.inflate_as<ruis::container>(
+			tml::read(bench::make_canvas_scene(opts.num_canvas_items, item_size))
+		);
+
+		gui.set_root(canvas);
+		render_frame();
+
+		auto canvas_suffix = "/n"s + std::to_string(opts.num_canvas_items);
+
+		run_mouse_move("mouse_move_canvas"s + canvas_suffix);
+
+		canvas.get().enable_hit_test_index(ruis::real(item_size) * 4);
+
+		run_mouse_move("mouse_move_canvas_indexed"s + canvas_suffix);
+
+		gui.set_root(root);
+	}
+
+	{
+		uint32_t cur_ticks = 0;
+
+		auto updater = utki::make_shared<ruis::updater>([&]() {
+			return cur_ticks;
+		});
+
+		std::vector<utki::shared_ref<test_updateable>> updateables;
+		for (unsigned i = 0; i != opts.num_updateables; ++i) {
+			auto u = utki::make_shared<test_updateable>();
+			constexpr auto min_dt = 16;
+			constexpr auto dt_spread = 50;
+			updater.get().start(u, uint16_t(min_dt + i % dt_spread));
+			updateables.push_back(std::move(u));
+		}
+
+		runner.run("updater_update/n"s + std::to_string(opts.num_updateables), [&]() {
+			++cur_ticks;
+			updater.get().update();
+		});
+
+		for (auto& u : updateables) {
+			updater.get().stop(u.get());
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,137 @@
+#include "scene.hpp"
+
+#include <array>
+#include <cmath>
+#include <sstream>
+
+using namespace bench;
+
+namespace {
+void write_tree(std::ostream& o, unsigned depth, unsigned width, unsigned& counter)
+{
+	if (depth == 0) {
+		auto n = counter++;
+		if (n % 2 == 0) {
+			o << "@text{text{\"item " << n << "\"}}";
+		} else {
+			o << "@color{lp{dx{10pp} dy{10pp}} color{0xff00ff00}}";
+		}
+		return;
+	}
+
+	constexpr std::array<const char*, 3> containers = {"row", "column", "pile"};
+
+	o << '@' << containers[depth % containers.size()] << '{';
+	for (unsigned i = 0; i != width; ++i) {
+		write_tree(o, depth - 1, width, counter);
+	}
+	o << '}';
+}
+} // namespace
+
+std::string bench::make_scene(unsigned depth, unsigned width)
+{
+	std::stringstream ss;
+
+	ss << R"(
+		@column{
+			lp{dx{fill} dy{fill}}
+
+			@scroll_area{
+				lp{dx{fill} dy{0} weight{1}}
+
+				@column{
+	)";
+
+	unsigned counter = 0;
+	write_tree(ss, depth, width, counter);
+
+	ss << R"(
+				}
+			}
+
+			@list{
+				lp{dx{fill} dy{0} weight{1}}
+	)";
+
+	constexpr auto num_list_items = 100;
+	for (unsigned i = 0; i != num_list_items; ++i) {
+		ss << "@text{text{\"list item " << i << "\"}}";
+	}
+
+	ss << R"(
+			}
+		}
+	)";
+
+	return ss.str();
+}
+
+std::string bench::make_template_scene(unsigned num_instances)
+{
+	std::stringstream ss;
+
+	ss << R"(
+		@column{
+			defs{
+				@labeled_row{ label color
+					@row{
+						lp{dx{fill}}
+						@margins{
+							left{4pp} right{4pp}
+							@text{
+								text{${label}}
+							}
+						}
+						@color{
+							lp{dx{10pp} dy{10pp}}
+							color{${color}}
+						}
+						${children}
+					}
+				}
+
+				@item{ label
+					@labeled_row{
+						label{${label}}
+						color{0xff0000ff}
+						@text{text{value}}
+					}
+				}
+			}
+	)";
+
+	for (unsigned i = 0; i != num_instances; ++i) {
+		if (i % 2 == 0) {
+			ss << "@item{label{\"item " << i << "\"}}";
+		} else {
+			ss << "@labeled_row{label{\"row " << i << "\"} color{0xff00ff00} @text{text{value}}}";
+		}
+	}
+
+	ss << R"(
+		}
+	)";
+
+	return ss.str();
+}
+
+std::string bench::make_canvas_scene(unsigned num_items, unsigned item_size)
+{
+	std::stringstream ss;
+
+	auto row_size = unsigned(std::ceil(std::sqrt(num_items)));
+
+	ss << "@container{lp{dx{fill} dy{fill}}";
+
+	for (unsigned i = 0; i != num_items; ++i) {
+		ss << "@widget{"
+		   << "x{" << (i % row_size) * item_size << "} y{" << (i / row_size) * item_size << "} "
+		   << "lp{dx{" << item_size << "} dy{" << item_size << "}}"
+		   << "}";
+	}
+
+	ss << "}";
+
+	return ss.str();
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <string>
+
+namespace bench {
+
+/**
+ * @brief Generate GUI script of a synthetic widget tree.
+ * The tree consists of nested @row, @column and @pile containers, with text labels and colored rectangles
+ * as leaves. The tree is placed into a scroll area and accompanied by a list of text items.
+ * @param depth - depth of container nesting.
+ * @param width - number of children of each container.
+ * @return GUI script in tml format.
+ */
+std::string make_scene(unsigned depth, unsigned width);
+
+/**
+ * @brief Generate GUI script making heavy use of GUI templates.
+ * The script defines templates with arguments, one of which is based on another template,
+ * and a column of instances of those templates.
+ * @param num_instances - number of template instances.
+ * @return GUI script in tml format.
+ */
+std::string make_template_scene(unsigned num_instances);
+
+/**
+ * @brief Generate GUI script of a canvas with many children.
+ * The canvas is a @container with small widgets placed in a square grid.
+ * @param num_items - number of widgets on the canvas.
+ * @param item_size - size of each widget in pixels.
+ * @return GUI script in tml format.
+ */
+std::string make_canvas_scene(unsigned num_items, unsigned item_size);
+
+} // namespace bench
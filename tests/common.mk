@@ -72,6 +72,18 @@ ifeq ($(this__is_interactive),true)
     this_run_name := $(notdir $(abspath $(d)))
     this_test_ld_path += $(dir $(this__libruisapp))
     $(eval $(prorab-run))
+else ifeq ($(this__is_bench),true)
+    # benchmarks are not run as part of 'make test', they are run with 'make bench',
+    # arguments to the benchmark program can be given with 'bench_args' variable
+    this_run_name := bench
+    this_test_args := $(bench_args)
+    $(eval $(prorab-run))
+
+    define this__rules
+        .PHONY: bench
+        bench: run-$(this_run_name)
+    endef
+    $(eval $(this__rules))
 else
     $(eval $(prorab-test))
 endif
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <functional>
+#include <mutex>
+#include <vector>
+
+// queue of functions posted to UI thread from other threads, run by the test manually
+class ui_queue{
+    std::mutex mutex;
+    std::vector<std::function<void()>> queue;
+
+public:
+    void post(std::function<void()> f){
+        std::lock_guard lock(this->mutex);
+        this->queue.push_back(std::move(f));
+    }
+
+    // returns number of run functions
+    size_t run(){
+        decltype(this->queue) q;
+        {
+            std::lock_guard lock(this->mutex);
+            q = std::move(this->queue);
+            this->queue.clear();
+        }
+        for(auto& f : q){
+            f();
+        }
+        return q.size();
+    }
+};
@@ -0,0 +1,57 @@
+#include <tst/set.hpp>
+#include <tst/check.hpp>
+
+#include <ruis/util/binary_tml.hpp>
+
+namespace{
+// NOLINTNEXTLINE(cppcoreguidelines-interfaces-global-init)
+const tst::set set("binary_tml", [](tst::suite& suite){
+    suite.add("forest_is_same_after_conversion_to_binary_and_back", []{
+        auto forest = tml::read(R"qwertyuiop(
+            img_button{
+                file{"button with spaces.svg"}
+            }
+            nine_patch{
+                borders{4 4 4 4}
+                file{nine_patch.png}
+            }
+            "" empty{}
+        )qwertyuiop");
+
+        auto binary = ruis::to_binary_tml(forest);
+
+        auto read = ruis::from_binary_tml(binary);
+
+        tst::check_eq(tml::to_string(read), tml::to_string(forest), SL);
+    });
+
+    suite.add("corrupted_data_is_rejected", []{
+        auto binary = ruis::to_binary_tml(tml::read("a{b c{d}}"), 1);
+
+        auto is_rejected = [](const std::vector<uint8_t>& data, std::optional<uint64_t> source_hash = std::nullopt){
+            try{
+                ruis::from_binary_tml(data, source_hash);
+            }catch(std::invalid_argument&){
+                return true;
+            }
+            return false;
+        };
+
+        tst::check(!is_rejected(binary), SL);
+        tst::check(!is_rejected(binary, 1), SL);
+        tst::check(is_rejected(binary, 2), SL);
+
+        auto corrupted = binary;
+        corrupted.back() ^= 1;
+        tst::check(is_rejected(corrupted), SL);
+
+        auto truncated = binary;
+        truncated.pop_back();
+        tst::check(is_rejected(truncated), SL);
+
+        auto wrong_version = binary;
+        wrong_version[3] = 0;
+        tst::check(is_rejected(wrong_version), SL);
+    });
+});
+}
@@ -105,5 +105,63 @@ const tst::set set("finding_widgets", [](tst::suite& suite){
 		auto& found = w.get().get_widget("child").get_widget("child2");
 		tst::check_eq(found.rect().p, ruis::vector2{1, 2}, SL);
 	});
+
+	suite.add("indexed_get_widget_finds_nearest_widget", [](){
+		ruis::gui m(make_dummy_context());
+		auto w = m.context.get().inflater.inflate_as<ruis::container>(tml::read(R"qwertyuiop(
+			@container{
+				@container{
+					@container{
+						@widget{
+							id{a} // should find this, subtree of previous child is searched first
+							x{1}
+						}
+					}
+					@container{
+						id{b}
+					}
+				}
+				@container{
+					@widget{
+						id{a}
+						x{2}
+					}
+				}
+			}
+		)qwertyuiop"));
+
+		w.get().enable_id_index();
+		tst::check(w.get().is_id_index_enabled(), SL);
+
+		// repeated lookups use the index
+		for(unsigned i = 0; i != 3; ++i){
+			tst::check_eq(w.get().get_widget("a").rect().p.x(), ruis::real(1), SL);
+			tst::check(!w.get().try_get_widget("z"), SL);
+		}
+
+		// widget added to the root is the nearest one
+		w.get().push_back(m.context.get().inflater.inflate(tml::read(R"qwertyuiop(
+			@widget{id{a} x{3}}
+		)qwertyuiop")));
+		tst::check_eq(w.get().get_widget("a").rect().p.x(), ruis::real(3), SL);
+		tst::check_eq(w.get().get_widget("a").rect().p.x(), ruis::real(3), SL);
+
+		w.get().erase(std::prev(w.get().children().end()));
+		tst::check_eq(w.get().get_widget("a").rect().p.x(), ruis::real(1), SL);
+		tst::check_eq(w.get().get_widget("a").rect().p.x(), ruis::real(1), SL);
+
+		// widget added deeper in the subtree is found through the root as well
+		auto p = w.get().get_widget("b").parent();
+		tst::check(p, SL);
+		p->push_back(m.context.get().inflater.inflate(tml::read(R"qwertyuiop(
+			@widget{id{a} x{5}}
+		)qwertyuiop")));
+		tst::check_eq(w.get().get_widget("a").rect().p.x(), ruis::real(5), SL);
+		tst::check_eq(w.get().get_widget("a").rect().p.x(), ruis::real(5), SL);
+
+		w.get().disable_id_index();
+		tst::check(!w.get().is_id_index_enabled(), SL);
+		tst::check_eq(w.get().get_widget("a").rect().p.x(), ruis::real(5), SL);
+	});
 });
 }
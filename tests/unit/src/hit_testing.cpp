@@ -0,0 +1,121 @@
+#include <sstream>
+
+#include <tst/set.hpp>
+#include <tst/check.hpp>
+
+#include <ruis/gui.hpp>
+#include <ruis/util/hit_test_grid.hpp>
+#include <ruis/widget/container.hpp>
+
+#include "../../harness/util/dummy_context.hpp"
+
+namespace{
+constexpr unsigned grid_size = 10;
+constexpr unsigned cell_size = 10;
+
+// background widget covering the whole container, followed by a grid of small widgets
+std::string make_grid_script(){
+    std::stringstream ss;
+    ss << "@container{";
+    ss << "@widget{id{background} lp{dx{" << grid_size * cell_size << "} dy{" << grid_size * cell_size << "}}}";
+    for(unsigned y = 0; y != grid_size; ++y){
+        for(unsigned x = 0; x != grid_size; ++x){
+            ss << "@widget{"
+                << "id{w" << x << "_" << y << "} "
+                << "x{" << x * cell_size << "} y{" << y * cell_size << "} "
+                << "lp{dx{" << cell_size << "} dy{" << cell_size << "}}"
+                << "}";
+        }
+    }
+    ss << "}";
+    return ss.str();
+}
+
+unsigned num_hovered(const ruis::container& c){
+    unsigned ret = 0;
+    for(const auto& w : c.children()){
+        if(w.get().is_hovered()){
+            ++ret;
+        }
+    }
+    return ret;
+}
+}
+
+namespace{
+// NOLINTNEXTLINE(cppcoreguidelines-interfaces-global-init)
+const tst::set set("hit_testing", [](tst::suite& suite){
+    suite.add("hit_test_grid_finds_overlapping_items", []{
+        ruis::hit_test_grid grid(10);
+
+        grid.set(0, {{0, 0}, {1000, 1000}}); // too big to be put to cells
+        grid.set(1, {{5, 5}, {10, 10}});
+        grid.set(2, {{30, 30}, {5, 5}});
+
+        std::vector<size_t> found;
+
+        grid.query({7, 7}, found);
+        tst::check(found == std::vector<size_t>{0, 1}, SL);
+
+        grid.query({32, 32}, found);
+        tst::check(found == std::vector<size_t>{0, 2}, SL);
+
+        // move item
+        grid.set(1, {{30, 30}, {2, 2}});
+
+        grid.query({7, 7}, found);
+        tst::check(found == std::vector<size_t>{0}, SL);
+
+        grid.query({31, 31}, found);
+        tst::check(found == std::vector<size_t>{0, 1, 2}, SL);
+
+        grid.clear();
+        grid.query({31, 31}, found);
+        tst::check(found.empty(), SL);
+    });
+
+    suite.add("indexed_container_hovers_children_under_pointer", []{
+        ruis::gui m(make_dummy_context());
+
+        auto c = m.context.get().inflater.inflate_as<ruis::container>(tml::read(make_grid_script()));
+        c.get().enable_hit_test_index(ruis::real(cell_size) * 2);
+
+        m.set_root(c);
+        m.set_viewport({ruis::real(grid_size * cell_size), ruis::real(grid_size * cell_size)});
+        m.render();
+
+        auto& background = c.get().get_widget("background");
+
+        m.send_mouse_move({15, 25}, 0);
+        tst::check(c.get().get_widget("w1_2").is_hovered(0), SL);
+        tst::check(background.is_hovered(0), SL);
+        tst::check_eq(num_hovered(c.get()), unsigned(2), SL);
+
+        m.send_mouse_move({55, 55}, 0);
+        tst::check(!c.get().get_widget("w1_2").is_hovered(0), SL);
+        tst::check(c.get().get_widget("w5_5").is_hovered(0), SL);
+        tst::check(background.is_hovered(0), SL);
+        tst::check_eq(num_hovered(c.get()), unsigned(2), SL);
+
+        // move hovered widget away, the other widget moved under the pointer
+        c.get().get_widget("w5_5").move_to({0, 0});
+        c.get().get_widget("w9_9").move_to({50, 50});
+
+        m.send_mouse_move({55, 55}, 0);
+        tst::check(!c.get().get_widget("w5_5").is_hovered(0), SL);
+        tst::check(c.get().get_widget("w9_9").is_hovered(0), SL);
+        tst::check_eq(num_hovered(c.get()), unsigned(2), SL);
+
+        // removed widget is not hit anymore
+        c.get().erase(c.get().find(c.get().get_widget("w9_9")));
+
+        m.send_mouse_move({55, 56}, 0);
+        tst::check(background.is_hovered(0), SL);
+        tst::check_eq(num_hovered(c.get()), unsigned(1), SL);
+
+        // pointer leaves the container
+        m.send_mouse_hover(false, 0);
+        tst::check_eq(num_hovered(c.get()), unsigned(0), SL);
+    });
+});
+}
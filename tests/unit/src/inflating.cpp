@@ -410,5 +410,96 @@ const tst::set set("inflating", [](tst::suite& suite){
 		auto& w = dynamic_cast<ruis::color&>(c.get().children().front().get());
 		tst::check_eq(w.get_color(), uint32_t(13), SL);
 	});
+
+	suite.add("template_instances_do_not_affect_each_other", [](){
+		ruis::gui g(make_dummy_context());
+
+		auto t = g.context.get().inflater.inflate(tml::read(R"qwertyuiop(
+			@container{
+				defs{
+					@colored{ c
+						@color{
+							id{colored}
+							x{1}
+							color{${c}}
+						}
+					}
+				}
+
+				@colored{
+					c{13}
+					x{${c}}
+				}
+
+				@colored{
+					c{14}
+				}
+			}
+		)qwertyuiop"));
+
+		auto c = utki::dynamic_reference_cast<ruis::container>(t);
+
+		tst::check_eq(c.get().size(), size_t(2), SL);
+
+		auto& w1 = dynamic_cast<ruis::color&>(c.get().children().front().get());
+		tst::check_eq(w1.get_color(), uint32_t(13), SL);
+		// replaced property value can refer to template arguments
+		tst::check_eq(w1.rect().p.x(), ruis::real(13), SL);
+
+		auto& w2 = dynamic_cast<ruis::color&>(c.get().children().back().get());
+		tst::check_eq(w2.get_color(), uint32_t(14), SL);
+		tst::check_eq(w2.rect().p.x(), ruis::real(1), SL);
+	});
+
+	suite.add("inflating_from_prototype", [](){
+		ruis::gui g(make_dummy_context());
+
+		auto& inflater = g.context.get().inflater;
+
+		inflater.push_defs(R"qwertyuiop(
+			v{13}
+			@colored{ c
+				@color{
+					color{${c}}
+				}
+			}
+		)qwertyuiop");
+
+		auto proto = inflater.make_prototype(tml::read(R"qwertyuiop(
+			@container{
+				@colored{
+					c{${v}}
+				}
+				@container{
+					@colored{
+						c{14}
+					}
+				}
+			}
+		)qwertyuiop"));
+
+		// templates and variables are resolved when prototype is made
+		inflater.push_defs("v{20}");
+
+		auto check = [](const utki::shared_ref<ruis::container>& c){
+			tst::check_eq(c.get().size(), size_t(2), SL);
+
+			auto& w1 = dynamic_cast<ruis::color&>(c.get().children().front().get());
+			tst::check_eq(w1.get_color(), uint32_t(13), SL);
+
+			auto& nested = dynamic_cast<ruis::container&>(c.get().children().back().get());
+			tst::check_eq(nested.size(), size_t(1), SL);
+			auto& w2 = dynamic_cast<ruis::color&>(nested.children().front().get());
+			tst::check_eq(w2.get_color(), uint32_t(14), SL);
+		};
+
+		auto c1 = inflater.inflate_as<ruis::container>(proto);
+		auto c2 = inflater.inflate_as<ruis::container>(proto);
+
+		tst::check(&c1.get() != &c2.get(), SL);
+
+		check(c1);
+		check(c2);
+	});
 });
 }
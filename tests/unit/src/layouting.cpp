@@ -25,6 +25,24 @@ public:
 };
 }
 
+namespace{
+class widget_which_counts_measures : public ruis::widget{
+public:
+    mutable unsigned num_measures = 0;
+
+    widget_which_counts_measures(
+                const utki::shared_ref<ruis::context>& c
+        ) :
+            ruis::widget(c, tml::forest())
+    {}
+
+    ruis::vector2 measure(const ruis::vector2& quotum)const override{
+        ++this->num_measures;
+        return ruis::widget::measure(quotum);
+    }
+};
+}
+
 namespace{
 const tst::set set("layouting", [](tst::suite& suite){
     suite.add("invalidate_layout_during_layouting_should_result_in_dirty_layout__lay_out_method", []{
@@ -95,5 +113,24 @@ const tst::set set("layouting", [](tst::suite& suite){
         gui.render();
         tst::check(tc.get().is_layout_dirty(), SL);
     });
+
+    suite.add("measure_cached_should_not_call_measure_for_same_quotum_until_layout_is_invalidated", []{
+        auto context = make_dummy_context();
+
+        auto c = std::make_shared<ruis::container>(context, tml::forest());
+        auto w = utki::make_shared<widget_which_counts_measures>(context);
+        c->push_back(w);
+
+        w.get().measure_cached(ruis::vector2(-1));
+        w.get().measure_cached(ruis::vector2(-1));
+        tst::check(w.get().num_measures == 1, SL);
+
+        w.get().measure_cached(ruis::vector2(10, -1));
+        tst::check(w.get().num_measures == 2, SL);
+
+        w.get().invalidate_layout();
+        w.get().measure_cached(ruis::vector2(-1));
+        tst::check(w.get().num_measures == 3, SL);
+    });
 });
 }
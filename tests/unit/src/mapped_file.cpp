@@ -0,0 +1,46 @@
+#include <algorithm>
+
+#include <tst/set.hpp>
+#include <tst/check.hpp>
+
+#include <papki/fs_file.hpp>
+
+#include <ruis/context.hpp>
+#include <ruis/util/mapped_file.hpp>
+
+#include "../../harness/util/dummy_context.hpp"
+
+namespace{
+// NOLINTNEXTLINE(cppcoreguidelines-interfaces-global-init)
+const tst::set set("mapped_file", [](tst::suite& suite){
+    suite.add("mapped_file_contents_are_same_as_loaded_file_contents", []{
+        auto m = ruis::mapped_file::map("../../res/ruis_res/main.res");
+
+        auto loaded = papki::fs_file("../../res/ruis_res/main.res").load();
+
+        tst::check_eq(m.get().data().size(), loaded.size(), SL);
+        tst::check(std::equal(loaded.begin(), loaded.end(), m.get().data().begin()), SL);
+    });
+
+    suite.add("mapping_same_file_twice_returns_same_mapping", []{
+        auto m1 = ruis::mapped_file::map("../../res/ruis_res/main.res");
+        auto m2 = ruis::mapped_file::map("../../res/ruis_res/main.res");
+
+        tst::check(&m1.get() == &m2.get(), SL);
+    });
+
+    suite.add("resource_loader_maps_files_of_resource_packs_on_file_system", []{
+        auto c = make_dummy_context();
+        auto pack = c.get().loader.mount_res_pack(papki::fs_file("../../res/ruis_res/main.res"));
+
+        auto& pack_file = *pack->fi;
+        pack_file.set_path("main.res");
+
+        auto m = c.get().loader.map_file(pack_file);
+        tst::check(m != nullptr, SL);
+
+        auto loaded = papki::fs_file("../../res/ruis_res/main.res").load();
+        tst::check_eq(m->data().size(), loaded.size(), SL);
+    });
+});
+}
@@ -0,0 +1,59 @@
+#include <tst/set.hpp>
+#include <tst/check.hpp>
+
+#include <ruis/util/property_table.hpp>
+
+namespace{
+enum class test_property{
+    lp,
+    x,
+    y,
+    dx,
+    dy,
+    id,
+    color,
+    disabled_color,
+
+    enum_size
+};
+
+constexpr ruis::property_table<test_property> test_properties({
+    "lp",
+    "x",
+    "y",
+    "dx",
+    "dy",
+    "id",
+    "color",
+    "disabled_color",
+});
+
+// the table is usable at compile time
+static_assert(test_properties.find("dy") == test_property::dy);
+static_assert(test_properties.find("weight") == test_property::enum_size);
+}
+
+namespace{
+// NOLINTNEXTLINE(cppcoreguidelines-interfaces-global-init)
+const tst::set set("property_table", [](tst::suite& suite){
+    suite.add("all_properties_are_found", []{
+        tst::check(test_properties.find("lp") == test_property::lp, SL);
+        tst::check(test_properties.find("x") == test_property::x, SL);
+        tst::check(test_properties.find("y") == test_property::y, SL);
+        tst::check(test_properties.find("dx") == test_property::dx, SL);
+        tst::check(test_properties.find("dy") == test_property::dy, SL);
+        tst::check(test_properties.find("id") == test_property::id, SL);
+        tst::check(test_properties.find("color") == test_property::color, SL);
+        tst::check(test_properties.find("disabled_color") == test_property::disabled_color, SL);
+    });
+
+    suite.add("unknown_properties_are_not_found", []{
+        tst::check(test_properties.find("") == test_property::enum_size, SL);
+        tst::check(test_properties.find("d") == test_property::enum_size, SL);
+        tst::check(test_properties.find("colo") == test_property::enum_size, SL);
+        tst::check(test_properties.find("colors") == test_property::enum_size, SL);
+        tst::check(test_properties.find("@color") == test_property::enum_size, SL);
+        tst::check(test_properties.find("layout") == test_property::enum_size, SL);
+    });
+});
+}
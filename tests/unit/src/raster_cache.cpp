@@ -0,0 +1,104 @@
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+#include <tst/set.hpp>
+#include <tst/check.hpp>
+
+#include <ruis/util/raster_cache.hpp>
+
+namespace{
+std::string make_cache_dir(){
+    auto dir = std::filesystem::temp_directory_path() / "ruis_raster_cache_test";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    return dir.string() + "/";
+}
+
+// writes cache file header with given dimensions followed by few bytes of pixel data
+void write_cache_file(const std::string& dir, uint64_t key, uint32_t width, uint32_t height){
+    std::stringstream path;
+    path << dir << std::hex << std::setw(sizeof(key) * 2) << std::setfill('0') << key << ".rrc";
+
+    std::ofstream f(path.str(), std::ios::binary);
+    f << "RRC1";
+    for(auto v : {width, height}){
+        for(unsigned i = 0; i != sizeof(v); ++i){
+            f.put(char(uint8_t(v >> (i * 8))));
+        }
+    }
+    f.put(char(1));
+    // run of 129 zero bytes
+    f.put(char(uint8_t(255)));
+    f.put(char(0));
+}
+
+// NOLINTNEXTLINE(cppcoreguidelines-interfaces-global-init)
+const tst::set set("raster_cache", [](tst::suite& suite){
+    suite.add("put_and_get_bitmap", []{
+        ruis::raster_cache cache(make_cache_dir());
+
+        rasterimage::image<uint8_t, 1> im({13, 7});
+        auto pixels = im.pixels();
+        for(size_t i = 0; i != pixels.size(); ++i){
+            // mix of runs and literals
+            pixels[i] = i < 40 ? 0 : uint8_t(i * 7);
+        }
+
+        auto key = ruis::raster_cache::make_key(ruis::raster_cache::hash({}), "test", unsigned(13), char32_t('a'));
+
+        tst::check(!cache.get<1>(key).has_value(), SL);
+
+        cache.put(key, im);
+
+        auto cached = cache.get<1>(key);
+        tst::check(cached.has_value(), SL);
+        tst::check_eq(cached->dims(), im.dims(), SL);
+
+        auto cached_pixels = cached->pixels();
+        for(size_t i = 0; i != pixels.size(); ++i){
+            tst::check_eq(unsigned(cached_pixels[i]), unsigned(pixels[i]), SL);
+        }
+
+        // different number of channels is a cache miss
+        tst::check(!cache.get<4>(key).has_value(), SL);
+    });
+
+    suite.add("bad_dimensions_are_cache_miss", []{
+        auto dir = make_cache_dir();
+        ruis::raster_cache cache(dir);
+
+        auto h = ruis::raster_cache::hash({});
+
+        auto huge_key = ruis::raster_cache::make_key(h, "huge");
+        write_cache_file(dir, huge_key, 0xffffffff, 0xffffffff);
+        tst::check(!cache.get<1>(huge_key).has_value(), SL);
+
+        // dimensions cannot be encoded by the file size
+        auto big_key = ruis::raster_cache::make_key(h, "big");
+        write_cache_file(dir, big_key, 1000, 1000);
+        tst::check(!cache.get<1>(big_key).has_value(), SL);
+
+        auto small_key = ruis::raster_cache::make_key(h, "small");
+        write_cache_file(dir, small_key, 3, 43);
+        auto cached = cache.get<1>(small_key);
+        tst::check(cached.has_value(), SL);
+        tst::check_eq(cached->dims(), r4::vector2<uint32_t>(3, 43), SL);
+    });
+
+    suite.add("keys_depend_on_parameters", []{
+        auto h = ruis::raster_cache::hash({});
+        tst::check(
+            ruis::raster_cache::make_key(h, "glyph", unsigned(12), char32_t('a')) !=
+                ruis::raster_cache::make_key(h, "glyph", unsigned(13), char32_t('a')),
+            SL
+        );
+        tst::check(
+            ruis::raster_cache::make_key(h, "glyph", unsigned(12)) !=
+                ruis::raster_cache::make_key(h, "svg", unsigned(12)),
+            SL
+        );
+    });
+});
+}
@@ -0,0 +1,50 @@
+#include <tst/set.hpp>
+#include <tst/check.hpp>
+
+#include <ruis/gui.hpp>
+#include <ruis/widget/container.hpp>
+#include <ruis/widget/label/color.hpp>
+
+#include "../../harness/util/dummy_context.hpp"
+
+namespace{
+// NOLINTNEXTLINE(cppcoreguidelines-interfaces-global-init)
+const tst::set set("render_stats", [](tst::suite& suite){
+    suite.add("frame_stats_are_attributed_to_widget_classes", []{
+        ruis::gui m(make_dummy_context());
+        auto w = m.context.get().inflater.inflate(tml::read(R"qwertyuiop(
+            @container{
+                @color{
+                    lp{dx{10} dy{10}}
+                    color{0xff0000ff}
+                }
+                @color{
+                    x{20}
+                    lp{dx{10} dy{10}}
+                    color{0xff00ff00}
+                }
+            }
+        )qwertyuiop"));
+
+        m.set_root(w);
+        m.set_viewport({100, 100});
+
+        auto& r = m.context.get().renderer.get();
+
+        for(unsigned i = 0; i != 2; ++i){
+            m.render();
+
+            const auto& stats = r.get_frame_stats();
+
+            tst::check_eq(stats.total().quads, size_t(2), SL);
+            tst::check_eq(stats.get<ruis::color>().quads, size_t(2), SL);
+            tst::check_eq(stats.get<ruis::container>().quads, size_t(0), SL);
+            tst::check(stats.total().draw_calls >= 1, SL);
+            tst::check(stats.total().draw_calls <= 2, SL);
+
+            // statistics of the next frame start from scratch
+            tst::check_eq(r.get_stats().total().quads, size_t(0), SL);
+        }
+    });
+});
+}
@@ -0,0 +1,179 @@
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+#include <vector>
+
+#include <tst/set.hpp>
+#include <tst/check.hpp>
+
+#include <papki/fs_file.hpp>
+
+#include <ruis/context.hpp>
+#include <ruis/render/null/renderer.hpp>
+#include <ruis/res/tml.hpp>
+#include <ruis/util/binary_tml.hpp>
+#include <ruis/util/raster_cache.hpp>
+
+#include "../../harness/util/dummy_context.hpp"
+#include "../../harness/util/ui_queue.hpp"
+
+namespace{
+// creates resource pack directory with main.res script and a.tml, b.tml files
+std::string make_res_pack(const std::string& name, const std::string& script){
+    auto dir = std::filesystem::temp_directory_path() / "ruis_resource_loader_test" / name;
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+
+    std::ofstream(dir / "main.res") << script;
+    std::ofstream(dir / "a.tml") << "a";
+    std::ofstream(dir / "b.tml") << "b";
+
+    return dir.string() + "/";
+}
+
+uint64_t hash_script(const std::string& script){
+    return ruis::raster_cache::hash(utki::make_span(reinterpret_cast<const uint8_t*>(script.data()), script.size()));
+}
+
+void write_compiled(const std::string& dir, const std::vector<uint8_t>& compiled){
+    std::ofstream f(dir + "main.res.bin", std::ios::binary);
+    f.write(reinterpret_cast<const char*>(compiled.data()), std::streamsize(compiled.size()));
+}
+
+std::string load_value(ruis::resource_loader& loader, std::string_view id){
+    auto r = loader.load<ruis::res::tml>(id);
+    return r.get().forest().front().value.string;
+}
+
+// NOLINTNEXTLINE(cppcoreguidelines-interfaces-global-init)
+const tst::set set("resource_loader", [](tst::suite& suite){
+    suite.add("last_mounted_res_pack_overrides_resources", []{
+        auto ctx = make_dummy_context();
+        auto& loader = ctx.get().loader;
+
+        auto pack_a = loader.mount_res_pack(papki::fs_file(make_res_pack(
+            "a",
+            "res_a{file{a.tml}} res_common{file{a.tml}}"
+        )));
+        tst::check_eq(load_value(loader, "res_common"), std::string("a"), SL);
+
+        auto pack_b = loader.mount_res_pack(papki::fs_file(make_res_pack(
+            "b",
+            "res_common{file{b.tml}}"
+        )));
+        tst::check_eq(load_value(loader, "res_a"), std::string("a"), SL);
+        tst::check_eq(load_value(loader, "res_common"), std::string("b"), SL);
+
+        loader.unmount_res_pack(pack_b);
+        tst::check_eq(load_value(loader, "res_common"), std::string("a"), SL);
+
+        loader.unmount_res_pack(pack_a);
+
+        bool thrown = false;
+        try{
+            loader.load<ruis::res::tml>("res_common");
+        }catch(std::logic_error&){
+            thrown = true;
+        }
+        tst::check(thrown, SL);
+    });
+
+    suite.add("load_async_delivers_resource_on_ui_thread", []{
+        auto queue = std::make_shared<ui_queue>();
+
+        auto c = utki::make_shared<ruis::context>(
+            utki::make_shared<ruis::render::null::renderer>(),
+            utki::make_shared<ruis::updater>(),
+            [queue](std::function<void()> f){
+                queue->post(std::move(f));
+            },
+            [](ruis::mouse_cursor){},
+            ruis::real(96),
+            ruis::real(1)
+        );
+        auto& loader = c.get().loader;
+
+        loader.mount_res_pack(papki::fs_file(make_res_pack("async", "res_a{file{a.tml}}")));
+
+        std::vector<std::shared_ptr<ruis::res::tml>> loaded;
+        auto on_loaded = [&](std::shared_ptr<ruis::res::tml> r, std::exception_ptr error){
+            tst::check(!error, SL);
+            loaded.push_back(std::move(r));
+        };
+
+        // concurrent requests for the same resource
+        loader.load_async<ruis::res::tml>("res_a", on_loaded);
+        loader.load_async<ruis::res::tml>("res_a", on_loaded);
+
+        bool failed = false;
+        loader.load_async<ruis::res::tml>(
+            "non_existing",
+            [&](std::shared_ptr<ruis::res::tml> r, std::exception_ptr error){
+                tst::check(!r, SL);
+                failed = bool(error);
+            }
+        );
+
+        // callbacks are only called from UI thread queue
+        tst::check(loaded.empty(), SL);
+        tst::check(!failed, SL);
+
+        using namespace std::chrono_literals;
+        for(unsigned i = 0; i != 1000 && (loaded.size() != 2 || !failed); ++i){
+            queue->run();
+            std::this_thread::sleep_for(1ms);
+        }
+
+        tst::check_eq(loaded.size(), size_t(2), SL);
+        tst::check(failed, SL);
+        tst::check(loaded[0] == loaded[1], SL);
+        tst::check_eq(loaded[0]->forest().front().value.string, std::string("a"), SL);
+    });
+
+    suite.add("compiled_res_script_is_used_when_valid", []{
+        auto ctx = make_dummy_context();
+        auto& loader = ctx.get().loader;
+
+        const std::string script = "res_x{file{a.tml}}";
+        auto dir = make_res_pack("compiled", script);
+
+        // compiled script differs from the text one, to see which one is used
+        auto compiled = ruis::to_binary_tml(tml::read("res_x{file{b.tml}}"), hash_script(script));
+        write_compiled(dir, compiled);
+
+        auto pack = loader.mount_res_pack(papki::fs_file(dir));
+        tst::check_eq(load_value(loader, "res_x"), std::string("b"), SL);
+        loader.unmount_res_pack(pack);
+
+        // corrupted compiled script is ignored
+        auto corrupted = compiled;
+        corrupted.back() ^= 1;
+        write_compiled(dir, corrupted);
+
+        pack = loader.mount_res_pack(papki::fs_file(dir));
+        tst::check_eq(load_value(loader, "res_x"), std::string("a"), SL);
+        loader.unmount_res_pack(pack);
+
+        // compiled script is ignored after the text script is edited
+        write_compiled(dir, compiled);
+        std::ofstream(dir + "main.res") << script << " ";
+
+        pack = loader.mount_res_pack(papki::fs_file(dir));
+        tst::check_eq(load_value(loader, "res_x"), std::string("a"), SL);
+        loader.unmount_res_pack(pack);
+    });
+
+    suite.add("compile_res_script", []{
+        auto dir = make_res_pack("to_compile", "res_x{file{a.tml}} res_y{file{b.tml}}");
+
+        auto compiled = ruis::resource_loader::compile_res_script(papki::fs_file(dir + "main.res"));
+
+        tst::check_eq(
+            tml::to_string(ruis::from_binary_tml(compiled, hash_script("res_x{file{a.tml}} res_y{file{b.tml}}"))),
+            tml::to_string(tml::read("res_x{file{a.tml}} res_y{file{b.tml}}")),
+            SL
+        );
+    });
+});
+}
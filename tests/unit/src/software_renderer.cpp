@@ -0,0 +1,108 @@
+#include <array>
+
+#include <tst/set.hpp>
+#include <tst/check.hpp>
+
+#include <ruis/gui.hpp>
+#include <ruis/render/software/renderer.hpp>
+#include <ruis/render/software/texture_2d.hpp>
+#include <ruis/widget/container.hpp>
+
+namespace{
+utki::shared_ref<ruis::context> make_software_context(){
+    return utki::make_shared<ruis::context>(
+            utki::make_shared<ruis::render::software::renderer>(
+                ruis::render::software::renderer::parameters{
+                    .dims = {64, 32}
+                }
+            ),
+            utki::make_shared<ruis::updater>(),
+            [](std::function<void()>){},
+            [](ruis::mouse_cursor){},
+            ruis::real(96),
+            ruis::real(1)
+        );
+}
+
+// NOLINTNEXTLINE(cppcoreguidelines-interfaces-global-init)
+const tst::set set("software_renderer", [](tst::suite& suite){
+    suite.add("color_widgets_are_rendered_to_image", []{
+        auto context = make_software_context();
+        ruis::gui m(context);
+
+        auto w = m.context.get().inflater.inflate(tml::read(R"qwertyuiop(
+            @container{
+                @color{
+                    x{10} y{4}
+                    lp{dx{20} dy{10}}
+                    color{0xff0000ff}
+                }
+                @color{
+                    x{40} y{20}
+                    lp{dx{8} dy{8}}
+                    color{0x8000ff00}
+                }
+            }
+        )qwertyuiop"));
+
+        m.set_root(w);
+        m.set_viewport({64, 32});
+
+        auto& r = dynamic_cast<ruis::render::software::renderer&>(m.context.get().renderer.get());
+
+        m.render(r.initial_matrix);
+
+        const auto& im = r.get_image();
+
+        auto is_pixel = [&](unsigned x, unsigned y, std::array<uint8_t, 4> expected){
+            auto p = im[y][x];
+            for(size_t i = 0; i != expected.size(); ++i){
+                if(p[i] != expected[i]){
+                    return false;
+                }
+            }
+            return true;
+        };
+
+        // inside of opaque red rectangle
+        tst::check(is_pixel(10, 4, {0xff, 0, 0, 0xff}), SL);
+        tst::check(is_pixel(29, 13, {0xff, 0, 0, 0xff}), SL);
+
+        // outside of the rectangle
+        tst::check(is_pixel(9, 4, {0, 0, 0, 0}), SL);
+        tst::check(is_pixel(30, 4, {0, 0, 0, 0}), SL);
+        tst::check(is_pixel(10, 14, {0, 0, 0, 0}), SL);
+
+        // half transparent green rectangle blended over transparent black
+        auto p = im[24][44];
+        tst::check_eq(unsigned(p[0]), unsigned(0), SL);
+        tst::check(p[1] >= 0x7f && p[1] <= 0x81, SL);
+        tst::check_eq(unsigned(p[2]), unsigned(0), SL);
+        tst::check(p[3] >= 0x7f && p[3] <= 0x81, SL);
+    });
+
+    suite.add("texture_part_is_updated", []{
+        auto context = make_software_context();
+        auto& r = context.get().renderer.get();
+
+        auto tex = r.factory->create_texture_2d(rasterimage::format::grey, {8, 8}, {});
+
+        rasterimage::image_variant imvar({8, 2}, rasterimage::format::grey, rasterimage::depth::uint_8_bit);
+        auto& im = imvar.get<rasterimage::format::grey, rasterimage::depth::uint_8_bit>();
+        for(uint32_t y = 0; y != im.dims().y(); ++y){
+            for(auto& px : im[y]){
+                px = {0x80};
+            }
+        }
+
+        tst::check(tex.get().update({0, 3}, imvar), SL);
+
+        const auto& sw_tex = dynamic_cast<const ruis::render::software::texture_2d&>(tex.get());
+
+        tst::check_eq(unsigned(sw_tex.image[2][0][0]), unsigned(0), SL);
+        tst::check_eq(unsigned(sw_tex.image[3][0][0]), unsigned(0x80), SL);
+        tst::check_eq(unsigned(sw_tex.image[4][7][0]), unsigned(0x80), SL);
+        tst::check_eq(unsigned(sw_tex.image[5][7][0]), unsigned(0), SL);
+    });
+});
+}
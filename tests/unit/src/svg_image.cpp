@@ -0,0 +1,55 @@
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include <tst/set.hpp>
+#include <tst/check.hpp>
+
+#include <papki/fs_file.hpp>
+
+#include <ruis/context.hpp>
+#include <ruis/render/null/renderer.hpp>
+#include <ruis/res/image.hpp>
+
+#include "../../harness/util/ui_queue.hpp"
+
+namespace{
+// NOLINTNEXTLINE(cppcoreguidelines-interfaces-global-init)
+const tst::set set("svg_image", [](tst::suite& suite){
+    suite.add("async_rasterization_posts_result_to_ui_thread", []{
+        auto queue = std::make_shared<ui_queue>();
+
+        auto c = utki::make_shared<ruis::context>(
+            utki::make_shared<ruis::render::null::renderer>(),
+            utki::make_shared<ruis::updater>(),
+            [queue](std::function<void()> f){
+                queue->post(std::move(f));
+            },
+            [](ruis::mouse_cursor){},
+            ruis::real(96),
+            ruis::real(1)
+        );
+
+        c.get().async_rasterization = true;
+
+        auto img = ruis::res::image::load(c, papki::fs_file("../../res/ruis_res/busy.svg"));
+
+        auto tex = img.get().get({20, 30});
+        tst::check_eq(tex.get().dims(), r4::vector2<uint32_t>(20, 30), SL);
+
+        // same dimensions request while rasterization is in progress gives the same texture
+        tst::check(&img.get().get({20, 30}).get() == &tex.get(), SL);
+
+        // wait for rasterization to finish
+        size_t num_run = 0;
+        for(unsigned i = 0; i != 1000 && num_run == 0; ++i){
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            num_run = queue->run();
+        }
+        tst::check_eq(num_run, size_t(1), SL);
+
+        // the rasterized texture stays cached
+        tst::check(&img.get().get({20, 30}).get() == &tex.get(), SL);
+    });
+});
+}
@@ -0,0 +1,113 @@
+#include <vector>
+
+#include <tst/set.hpp>
+#include <tst/check.hpp>
+
+#include <ruis/res/texture_atlas.hpp>
+
+namespace{
+rasterimage::image<uint8_t, 4> make_image(r4::vector2<uint32_t> dims, uint8_t seed){
+    rasterimage::image<uint8_t, 4> im(dims);
+    auto pixels = im.pixels();
+    for(size_t i = 0; i != pixels.size(); ++i){
+        pixels[i] = {uint8_t(seed + i), uint8_t(seed), uint8_t(i), 0xff};
+    }
+    return im;
+}
+
+bool is_same(const rasterimage::image<uint8_t, 4>& a, const rasterimage::image<uint8_t, 4>& b){
+    if(a.dims() != b.dims()){
+        return false;
+    }
+    auto ap = a.pixels();
+    auto bp = b.pixels();
+    for(size_t i = 0; i != ap.size(); ++i){
+        if(ap[i] != bp[i]){
+            return false;
+        }
+    }
+    return true;
+}
+
+// NOLINTNEXTLINE(cppcoreguidelines-interfaces-global-init)
+const tst::set set("texture_atlas", [](tst::suite& suite){
+    suite.add("small_images_share_page", []{
+        ruis::res::texture_atlas atlas(64, 32);
+
+        std::vector<std::shared_ptr<const ruis::res::texture_atlas::entry>> entries;
+        std::vector<rasterimage::image<uint8_t, 4>> images;
+        for(unsigned i = 0; i != 10; ++i){
+            images.push_back(make_image({unsigned(5 + i), unsigned(10 - i)}, uint8_t(i)));
+            entries.push_back(atlas.add(images.back()));
+            tst::check(entries.back() != nullptr, SL);
+        }
+
+        tst::check_eq(atlas.num_pages(), size_t(1), SL);
+
+        for(size_t i = 0; i != entries.size(); ++i){
+            tst::check(is_same(entries[i]->get_image(), images[i]), SL);
+        }
+
+        // too big image is not packed
+        tst::check(atlas.add(make_image({33, 1}, 0)) == nullptr, SL);
+    });
+
+    suite.add("page_is_removed_when_empty", []{
+        ruis::res::texture_atlas atlas(64, 32);
+
+        auto e = atlas.add(make_image({10, 10}, 1));
+        tst::check_eq(atlas.num_pages(), size_t(1), SL);
+
+        e.reset();
+        tst::check_eq(atlas.num_pages(), size_t(0), SL);
+    });
+
+    suite.add("page_grows_on_demand", []{
+        ruis::res::texture_atlas atlas(1024, 256);
+
+        // 200x200 images with border do not fit into initial 256x256 page
+        std::vector<std::shared_ptr<const ruis::res::texture_atlas::entry>> entries;
+        std::vector<rasterimage::image<uint8_t, 4>> images;
+        for(unsigned i = 0; i != 5; ++i){
+            images.push_back(make_image({200, 200}, uint8_t(i)));
+            entries.push_back(atlas.add(images.back()));
+            tst::check(entries.back() != nullptr, SL);
+        }
+
+        tst::check_eq(atlas.num_pages(), size_t(1), SL);
+
+        for(size_t i = 0; i != entries.size(); ++i){
+            tst::check(is_same(entries[i]->get_image(), images[i]), SL);
+        }
+    });
+
+    suite.add("freed_space_is_reclaimed_by_repacking", []{
+        ruis::res::texture_atlas atlas(64, 32);
+
+        // fill the page with 16 images of 14x14, which is 16x16 with border
+        std::vector<std::shared_ptr<const ruis::res::texture_atlas::entry>> entries;
+        std::vector<rasterimage::image<uint8_t, 4>> images;
+        for(unsigned i = 0; i != 16; ++i){
+            images.push_back(make_image({14, 14}, uint8_t(i)));
+            entries.push_back(atlas.add(images.back()));
+        }
+        tst::check_eq(atlas.num_pages(), size_t(1), SL);
+
+        // free every other image
+        for(size_t i = 0; i != entries.size(); i += 2){
+            entries[i].reset();
+        }
+
+        // the image does not fit into free space without repacking
+        auto big_image = make_image({30, 30}, 100);
+        auto big = atlas.add(big_image);
+        tst::check(big != nullptr, SL);
+        tst::check_eq(atlas.num_pages(), size_t(1), SL);
+
+        tst::check(is_same(big->get_image(), big_image), SL);
+        for(size_t i = 1; i < entries.size(); i += 2){
+            tst::check(is_same(entries[i]->get_image(), images[i]), SL);
+        }
+    });
+});
+}
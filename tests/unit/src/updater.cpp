@@ -130,5 +130,60 @@ const tst::set set("updater", [](tst::suite& suite){
         tst::check_eq(u.get().num_updated, unsigned(3), SL);
         tst::check(!u.get().is_updating(), SL);
     });
+    suite.add("updates_in_order_of_end_time_and_stop_from_middle_of_queue", [](){
+        uint32_t cur_ticks = 0;
+
+        auto updater = utki::make_shared<ruis::updater>(
+            [&](){
+                return cur_ticks;
+            }
+        );
+
+        std::vector<unsigned> updated;
+
+        struct test_updateable : public ruis::updateable{
+            utki::shared_ref<ruis::updater> updater;
+            std::vector<unsigned>& updated;
+            unsigned id;
+
+            test_updateable(utki::shared_ref<ruis::updater> updater, std::vector<unsigned>& updated, unsigned id) :
+                updater(std::move(updater)),
+                updated(updated),
+                id(id)
+            {}
+
+            void update(uint32_t dt)override{
+                this->updated.push_back(this->id);
+                this->updater.get().stop(*this);
+            }
+        };
+
+        std::vector<utki::shared_ref<test_updateable>> us;
+        for(unsigned i = 0; i != 8; ++i){
+            us.push_back(utki::make_shared<test_updateable>(updater, updated, i));
+        }
+
+        // start in reverse order of intervals
+        for(unsigned i = 0; i != us.size(); ++i){
+            updater.get().start(us[i], uint16_t(100 - i * 10));
+        }
+
+        updater.get().update();
+        tst::check(updated.empty(), SL);
+
+        // stop updateables which are in the middle of the queue
+        updater.get().stop(us[3].get());
+        updater.get().stop(us[5].get());
+        tst::check(!us[3].get().is_updating(), SL);
+        tst::check(!us[5].get().is_updating(), SL);
+
+        for(uint32_t t = 1; t <= 100; ++t){
+            cur_ticks = t;
+            updater.get().update();
+        }
+
+        tst::check_eq(updated.size(), size_t(6), SL);
+        tst::check(updated == std::vector<unsigned>{7, 6, 4, 2, 1, 0}, SL);
+    });
 });
 }
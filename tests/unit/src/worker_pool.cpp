@@ -0,0 +1,28 @@
+#include <atomic>
+#include <vector>
+
+#include <tst/set.hpp>
+#include <tst/check.hpp>
+
+#include <ruis/util/worker_pool.hpp>
+
+namespace{
+// NOLINTNEXTLINE(cppcoreguidelines-interfaces-global-init)
+const tst::set set("worker_pool", [](tst::suite& suite){
+    suite.add("run_calls_task_for_each_index_once", []{
+        ruis::worker_pool pool(3);
+
+        for(unsigned num_tasks : {0, 1, 2, 10, 100}){
+            std::vector<std::atomic<unsigned>> counters(num_tasks);
+
+            pool.run(num_tasks, [&](unsigned i){
+                ++counters[i];
+            });
+
+            for(const auto& c : counters){
+                tst::check_eq(c.load(), unsigned(1), SL);
+            }
+        }
+    });
+});
+}